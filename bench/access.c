@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include "bench.h"
+
+static float
+sum_components(bench_env_t* env, const eecs_entity_t* entities, long count) {
+	float sum = 0.f;
+	for (long i = 0; i < count; ++i) {
+		float* value = eecs_get_component_in_entity(env->world, entities[i], env->components[0]);
+		sum += *value;
+	}
+	return sum;
+}
+
+#define BENCH_GATHER_SIZE 256
+
+static float
+sum_gathered_components(bench_env_t* env, const eecs_entity_t* entities, long count) {
+	void* values[BENCH_GATHER_SIZE];
+	float sum = 0.f;
+	for (long i = 0; i < count; i += BENCH_GATHER_SIZE) {
+		eecs_id_t num_values = (eecs_id_t)(count - i < BENCH_GATHER_SIZE ? count - i : BENCH_GATHER_SIZE);
+		eecs_get_components_for_entities(env->world, entities + i, num_values, env->components[0], values);
+		for (eecs_id_t j = 0; j < num_values; ++j) {
+			sum += *(float*)values[j];
+		}
+	}
+	return sum;
+}
+
+void
+bench_random_access(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+
+	long num_archetypes = params->num_archetypes;
+	long num_entities = params->num_entities;
+	eecs_entity_t* entities = malloc(sizeof(eecs_entity_t) * num_entities);
+
+	// Interleave archetypes so that neighbouring handles live in different tables
+	eecs_component_init_t init[BENCH_NUM_COMPONENTS + 1];
+	for (long i = 0; i < num_entities; ++i) {
+		bench_archetype_init(&env, i % num_archetypes, init);
+		entities[i] = eecs_create_entity(env.world, init);
+	}
+
+	uint64_t start = bench_now_ns();
+	volatile float sum = sum_components(&env, entities, num_entities);
+	bench_report(params, "get_component_sequential", bench_now_ns() - start, num_entities);
+
+	bench_shuffle(entities, num_entities);
+	start = bench_now_ns();
+	sum = sum_components(&env, entities, num_entities);
+	bench_report(params, "get_component_random", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	sum = sum_gathered_components(&env, entities, num_entities);
+	bench_report(params, "get_components_for_entities", bench_now_ns() - start, num_entities);
+	(void)sum;
+
+	free(entities);
+	bench_cleanup_env(&env);
+}
+
+#define BENCH_WIDE_COMPONENTS 24
+
+// Every entity has BENCH_WIDE_COMPONENTS components and the last registered
+// one is fetched, the worst case for a search through the table's signature
+void
+bench_wide_access(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+
+	eecs_component_t components[BENCH_WIDE_COMPONENTS];
+	eecs_component_init_t init[BENCH_WIDE_COMPONENTS + 1];
+	for (int i = 0; i < BENCH_WIDE_COMPONENTS; ++i) {
+		components[i] = i < BENCH_NUM_COMPONENTS
+			? env.components[i]
+			: (eecs_component_t)EECS_HANDLE_INIT;
+		if (i >= BENCH_NUM_COMPONENTS) {
+			eecs_register_component(env.ecs, &components[i], (eecs_component_options_t){
+				.size = (size_t)params->component_size,
+				.alignment = 1,
+			});
+		}
+		init[i] = (eecs_component_init_t){ .component = components[i] };
+	}
+	init[BENCH_WIDE_COMPONENTS] = (eecs_component_init_t)EECS_END_OF_LIST;
+
+	long num_entities = params->num_entities;
+	eecs_entity_t* entities = malloc(sizeof(eecs_entity_t) * num_entities);
+	eecs_create_entities(env.world, init, num_entities, entities);
+	bench_shuffle(entities, num_entities);
+
+	eecs_component_t last_component = components[BENCH_WIDE_COMPONENTS - 1];
+	uint64_t start = bench_now_ns();
+	volatile char sum = 0;
+	for (long i = 0; i < num_entities; ++i) {
+		char* value = eecs_get_component_in_entity(env.world, entities[i], last_component);
+		sum += *value;
+	}
+	bench_report(params, "get_component_wide", bench_now_ns() - start, num_entities);
+	(void)sum;
+
+	free(entities);
+	bench_cleanup_env(&env);
+}
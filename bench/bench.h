@@ -0,0 +1,134 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <eecs.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// Component 0 is in every archetype, the others select the archetype
+#define BENCH_NUM_COMPONENTS 13
+#define BENCH_MAX_ARCHETYPES (1 << (BENCH_NUM_COMPONENTS - 1))
+#define BENCH_MAX_VALUES 16
+
+typedef struct bench_list_s {
+	long values[BENCH_MAX_VALUES];
+	int count;
+} bench_list_t;
+
+typedef struct bench_params_s {
+	long table_chunk_size;
+	long component_size;
+	long num_archetypes;
+	long num_systems;
+	long num_entities;
+} bench_params_t;
+
+typedef void (*bench_fn_t)(const bench_params_t* params);
+
+typedef struct bench_s {
+	const char* name;
+	bench_fn_t fn;
+	// Used when the dimension is not given on the command line
+	bench_list_t num_archetypes;
+	bench_list_t num_systems;
+	bench_list_t num_entities;
+} bench_t;
+
+typedef struct bench_env_s {
+	const bench_params_t* params;
+	eecs_t* ecs;
+	eecs_world_t* world;
+	eecs_component_t components[BENCH_NUM_COMPONENTS];
+} bench_env_t;
+
+static inline uint64_t
+bench_now_ns(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline void
+bench_print_header(void) {
+	printf("benchmark\ttable_chunk_size\tcomponent_size\tarchetypes\tsystems\tentities\tns_per_op\n");
+}
+
+// One tab separated row per measurement, see bench_print_header
+static inline void
+bench_report(const bench_params_t* params, const char* name, uint64_t elapsed_ns, long num_ops) {
+	printf(
+		"%s\t%ld\t%ld\t%ld\t%ld\t%ld\t%.2f\n",
+		name,
+		params->table_chunk_size,
+		params->component_size,
+		params->num_archetypes,
+		params->num_systems,
+		params->num_entities,
+		(double)elapsed_ns / (double)(num_ops > 0 ? num_ops : 1)
+	);
+	fflush(stdout);
+}
+
+static inline uint32_t
+bench_rand(uint32_t* state) {
+	// xorshift32
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+static inline void
+bench_shuffle(eecs_entity_t* entities, long count) {
+	uint32_t state = 0x9E3779B9u;
+	for (long i = count - 1; i > 0; --i) {
+		long j = (long)(bench_rand(&state) % (uint32_t)(i + 1));
+		eecs_entity_t tmp = entities[i];
+		entities[i] = entities[j];
+		entities[j] = tmp;
+	}
+}
+
+static inline void
+bench_init_env(bench_env_t* env, const bench_params_t* params) {
+	env->params = params;
+	env->ecs = eecs_create((eecs_options_t){ 0 });
+
+	size_t size = (size_t)params->component_size;
+	size_t alignment = size % 8 == 0 ? 8 : (size % 4 == 0 ? 4 : 1);
+	for (int i = 0; i < BENCH_NUM_COMPONENTS; ++i) {
+		env->components[i] = (eecs_component_t)EECS_HANDLE_INIT;
+		eecs_register_component(env->ecs, &env->components[i], (eecs_component_options_t){
+			.size = size,
+			.alignment = alignment,
+		});
+	}
+
+	env->world = eecs_create_world(env->ecs, (eecs_world_options_t){
+		.table_chunk_size = (size_t)params->table_chunk_size,
+	});
+}
+
+static inline void
+bench_cleanup_env(bench_env_t* env) {
+	eecs_destroy_world(env->world);
+	eecs_destroy(env->ecs);
+}
+
+// Archetype n has component 0 and the other components whose bit is set in n
+static inline void
+bench_archetype_init(const bench_env_t* env, long archetype, eecs_component_init_t* init) {
+	int num_inits = 0;
+	init[num_inits++] = (eecs_component_init_t){ .component = env->components[0] };
+	for (int i = 1; i < BENCH_NUM_COMPONENTS; ++i) {
+		if ((archetype >> (i - 1)) & 1) {
+			init[num_inits++] = (eecs_component_init_t){ .component = env->components[i] };
+		}
+	}
+	init[num_inits] = (eecs_component_init_t)EECS_END_OF_LIST;
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include "bench.h"
+
+static eecs_component_init_t inits[BENCH_MAX_ARCHETYPES][BENCH_NUM_COMPONENTS + 1];
+
+// Create then destroy one entity of each archetype so that their tables exist
+static void
+prepare_archetypes(bench_env_t* env) {
+	for (long i = 0; i < env->params->num_archetypes; ++i) {
+		bench_archetype_init(env, i, inits[i]);
+		eecs_destroy_entity(env->world, eecs_create_entity(env->world, inits[i]));
+	}
+}
+
+// Entities of the same archetype are created together
+static void
+create_entities(bench_env_t* env, eecs_entity_t* entities) {
+	long num_archetypes = env->params->num_archetypes;
+	long num_entities = env->params->num_entities;
+
+	long first = 0;
+	for (long i = 0; i < num_archetypes; ++i) {
+		long count = num_entities / num_archetypes + (i < num_entities % num_archetypes);
+		eecs_create_entities(env->world, inits[i], (eecs_id_t)count, entities + first);
+		first += count;
+	}
+}
+
+void
+bench_create_destroy(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+	prepare_archetypes(&env);
+
+	long num_entities = params->num_entities;
+	long num_archetypes = params->num_archetypes;
+	eecs_entity_t* entities = malloc(sizeof(eecs_entity_t) * num_entities);
+
+	uint64_t start = bench_now_ns();
+	for (long i = 0; i < num_entities; ++i) {
+		entities[i] = eecs_create_entity(env.world, inits[i % num_archetypes]);
+	}
+	bench_report(params, "create_entity", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	for (long i = 0; i < num_entities; ++i) {
+		eecs_destroy_entity(env.world, entities[i]);
+	}
+	bench_report(params, "destroy_entity", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	create_entities(&env, entities);
+	bench_report(params, "create_entities", bench_now_ns() - start, num_entities);
+
+	bench_shuffle(entities, num_entities);
+	start = bench_now_ns();
+	eecs_destroy_entities(env.world, entities, (eecs_id_t)num_entities);
+	bench_report(params, "destroy_entities", bench_now_ns() - start, num_entities);
+
+	free(entities);
+	bench_cleanup_env(&env);
+}
+
+void
+bench_morph(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+	prepare_archetypes(&env);
+
+	long num_entities = params->num_entities;
+	eecs_entity_t* entities = malloc(sizeof(eecs_entity_t) * num_entities);
+	create_entities(&env, entities);
+	bench_shuffle(entities, num_entities);
+
+	eecs_component_t removed[] = { env.components[0], EECS_END_OF_LIST };
+	eecs_component_init_t added[] = { { .component = env.components[0] }, EECS_END_OF_LIST };
+
+	uint64_t start = bench_now_ns();
+	for (long i = 0; i < num_entities; ++i) {
+		eecs_morph_entity(env.world, entities[i], NULL, removed);
+	}
+	bench_report(params, "morph_entity_remove", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	for (long i = 0; i < num_entities; ++i) {
+		eecs_morph_entity(env.world, entities[i], added, NULL);
+	}
+	bench_report(params, "morph_entity_add", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	eecs_morph_entities(env.world, entities, (eecs_id_t)num_entities, NULL, removed);
+	bench_report(params, "morph_entities_remove", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	eecs_morph_entities(env.world, entities, (eecs_id_t)num_entities, added, NULL);
+	bench_report(params, "morph_entities_add", bench_now_ns() - start, num_entities);
+
+	free(entities);
+	bench_cleanup_env(&env);
+}
+
+void
+bench_template(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+	prepare_archetypes(&env);
+
+	long num_archetypes = params->num_archetypes;
+	eecs_template_t* templates = malloc(sizeof(eecs_template_t) * num_archetypes);
+	for (long i = 0; i < num_archetypes; ++i) {
+		templates[i] = (eecs_template_t)EECS_HANDLE_INIT;
+		eecs_register_template(env.world, &templates[i], inits[i]);
+	}
+
+	long num_entities = params->num_entities;
+	uint64_t start = bench_now_ns();
+	for (long i = 0; i < num_entities; ++i) {
+		eecs_create_entity_from_template(env.world, templates[i % num_archetypes], NULL);
+	}
+	bench_report(params, "create_entity_from_template", bench_now_ns() - start, num_entities);
+
+	free(templates);
+	bench_cleanup_env(&env);
+}
@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include "bench.h"
+
+#define MIN_VISITS 50000000L
+
+typedef struct {
+	long component_size;
+	float sum;
+} iteration_state_t;
+
+static void
+sum_batch(eecs_world_t* world, eecs_batch_t batch, void* userdata) {
+	(void)world;
+	iteration_state_t* state = userdata;
+
+	const char* data = eecs_get_components_in_batch(batch, 0);
+	long stride = state->component_size;
+	float sum = 0.f;
+	for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+		sum += *(const float*)(data + i * stride);
+	}
+	state->sum += sum;
+}
+
+void
+bench_iteration(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+
+	long num_archetypes = params->num_archetypes;
+	long num_entities = params->num_entities;
+	eecs_entity_t* entities = malloc(sizeof(eecs_entity_t) * num_entities);
+
+	eecs_component_init_t init[BENCH_NUM_COMPONENTS + 1];
+	long first = 0;
+	for (long i = 0; i < num_archetypes; ++i) {
+		long count = num_entities / num_archetypes + (i < num_entities % num_archetypes);
+		bench_archetype_init(&env, i, init);
+		eecs_create_entities(env.world, init, (eecs_id_t)count, entities + first);
+		first += count;
+	}
+	free(entities);
+
+	iteration_state_t state = { .component_size = params->component_size };
+	eecs_system_t system = EECS_HANDLE_INIT;
+	eecs_register_system(env.ecs, &system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ env.components[0], EECS_END_OF_LIST },
+		.update_fn = sum_batch,
+		.userdata = &state,
+	});
+
+	// Warm up and sync
+	eecs_run_systems(env.world, EECS_UPDATE_ALL);
+
+	long num_runs = num_entities > 0 ? (MIN_VISITS + num_entities - 1) / num_entities : 1;
+	num_runs = num_runs < 3 ? 3 : num_runs;
+	uint64_t start = bench_now_ns();
+	for (long i = 0; i < num_runs; ++i) {
+		eecs_run_systems(env.world, EECS_UPDATE_ALL);
+	}
+	bench_report(params, "iterate_entity", bench_now_ns() - start, num_entities * num_runs);
+
+	bench_cleanup_env(&env);
+}
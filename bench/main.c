@@ -0,0 +1,202 @@
+#define EECS_IMPLEMENTATION
+#include "bench.h"
+#include <stdlib.h>
+
+void
+bench_create_destroy(const bench_params_t* params);
+
+void
+bench_morph(const bench_params_t* params);
+
+void
+bench_template(const bench_params_t* params);
+
+void
+bench_random_access(const bench_params_t* params);
+
+void
+bench_wide_access(const bench_params_t* params);
+
+void
+bench_iteration(const bench_params_t* params);
+
+void
+bench_sync(const bench_params_t* params);
+
+void
+bench_snapshot(const bench_params_t* params);
+
+void
+bench_delta(const bench_params_t* params);
+
+void
+bench_fork(const bench_params_t* params);
+
+static const bench_t benches[] = {
+	{
+		.name = "create_destroy",
+		.fn = bench_create_destroy,
+		.num_archetypes = { { 1, 64, 1024 }, 3 },
+		.num_systems = { { 0 }, 1 },
+		.num_entities = { { 200000 }, 1 },
+	},
+	{
+		.name = "morph",
+		.fn = bench_morph,
+		.num_archetypes = { { 1, 64, 1024 }, 3 },
+		.num_systems = { { 0 }, 1 },
+		.num_entities = { { 200000 }, 1 },
+	},
+	{
+		.name = "template",
+		.fn = bench_template,
+		.num_archetypes = { { 1, 64 }, 2 },
+		.num_systems = { { 0 }, 1 },
+		.num_entities = { { 200000 }, 1 },
+	},
+	{
+		.name = "random_access",
+		.fn = bench_random_access,
+		.num_archetypes = { { 1, 64 }, 2 },
+		.num_systems = { { 0 }, 1 },
+		.num_entities = { { 100000, 1000000 }, 2 },
+	},
+	{
+		.name = "wide_access",
+		.fn = bench_wide_access,
+		.num_archetypes = { { 1 }, 1 },
+		.num_systems = { { 0 }, 1 },
+		.num_entities = { { 100000 }, 1 },
+	},
+	{
+		.name = "iteration",
+		.fn = bench_iteration,
+		.num_archetypes = { { 1, 16 }, 2 },
+		.num_systems = { { 1 }, 1 },
+		.num_entities = { { 1000000, 10000000 }, 2 },
+	},
+	{
+		.name = "sync",
+		.fn = bench_sync,
+		.num_archetypes = { { 64, 1024 }, 2 },
+		.num_systems = { { 16, 256 }, 2 },
+		.num_entities = { { 0 }, 1 },
+	},
+	{
+		.name = "snapshot",
+		.fn = bench_snapshot,
+		.num_archetypes = { { 1, 64 }, 2 },
+		.num_systems = { { 0 }, 1 },
+		.num_entities = { { 1000000 }, 1 },
+	},
+	{
+		.name = "delta",
+		.fn = bench_delta,
+		.num_archetypes = { { 1, 64 }, 2 },
+		.num_systems = { { 0 }, 1 },
+		.num_entities = { { 100000 }, 1 },
+	},
+	{
+		.name = "fork",
+		.fn = bench_fork,
+		.num_archetypes = { { 1, 64 }, 2 },
+		.num_systems = { { 0 }, 1 },
+		.num_entities = { { 1000000 }, 1 },
+	},
+};
+
+static bool
+parse_list(const char* arg, const char* option, bench_list_t* list) {
+	size_t option_len = strlen(option);
+	if (strncmp(arg, option, option_len) != 0 || arg[option_len] != '=') {
+		return false;
+	}
+
+	list->count = 0;
+	const char* itr = arg + option_len + 1;
+	while (*itr != '\0' && list->count < BENCH_MAX_VALUES) {
+		char* end;
+		list->values[list->count++] = strtol(itr, &end, 10);
+		itr = *end == ',' ? end + 1 : end;
+		if (end == itr) { break; }
+	}
+
+	return true;
+}
+
+static void
+usage(const char* program) {
+	fprintf(
+		stderr,
+		"Usage: %s [options]\n"
+		"  --filter=NAME                 Only run benchmarks whose name contains NAME\n"
+		"  --table-chunk-size=N[,N...]   Default: 16384\n"
+		"  --component-size=N[,N...]     Size of every component in bytes. Default: 4,64\n"
+		"  --archetypes=N[,N...]         At most %d\n"
+		"  --systems=N[,N...]\n"
+		"  --entities=N[,N...]\n"
+		"Output is tab separated with a header line.\n",
+		program,
+		BENCH_MAX_ARCHETYPES
+	);
+}
+
+int main (int argc, char* argv[]) {
+	const char* filter = NULL;
+	bench_list_t table_chunk_sizes = { { EECS_DEFAULT_TABLE_CHUNK_SIZE }, 1 };
+	bench_list_t component_sizes = { { 4, 64 }, 2 };
+	bench_list_t num_archetypes = { { 0 }, 0 };
+	bench_list_t num_systems = { { 0 }, 0 };
+	bench_list_t num_entities = { { 0 }, 0 };
+
+	for (int i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+		if (strncmp(arg, "--filter=", 9) == 0) {
+			filter = arg + 9;
+		} else if (
+			!parse_list(arg, "--table-chunk-size", &table_chunk_sizes)
+			&& !parse_list(arg, "--component-size", &component_sizes)
+			&& !parse_list(arg, "--archetypes", &num_archetypes)
+			&& !parse_list(arg, "--systems", &num_systems)
+			&& !parse_list(arg, "--entities", &num_entities)
+		) {
+			usage(argv[0]);
+			return strcmp(arg, "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	for (int i = 0; i < num_archetypes.count; ++i) {
+		if (num_archetypes.values[i] < 1 || num_archetypes.values[i] > BENCH_MAX_ARCHETYPES) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	bench_print_header();
+
+	for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); ++i) {
+		const bench_t* bench = &benches[i];
+		if (filter != NULL && strstr(bench->name, filter) == NULL) { continue; }
+
+		const bench_list_t* archetypes = num_archetypes.count > 0 ? &num_archetypes : &bench->num_archetypes;
+		const bench_list_t* systems = num_systems.count > 0 ? &num_systems : &bench->num_systems;
+		const bench_list_t* entities = num_entities.count > 0 ? &num_entities : &bench->num_entities;
+
+		for (int c = 0; c < table_chunk_sizes.count; ++c)
+		for (int s = 0; s < component_sizes.count; ++s)
+		for (int a = 0; a < archetypes->count; ++a)
+		for (int y = 0; y < systems->count; ++y)
+		for (int e = 0; e < entities->count; ++e) {
+			bench_params_t params = {
+				.table_chunk_size = table_chunk_sizes.values[c],
+				.component_size = component_sizes.values[s],
+				.num_archetypes = archetypes->values[a],
+				.num_systems = systems->values[y],
+				.num_entities = entities->values[e],
+			};
+			bench->fn(&params);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include "bench.h"
+
+// Called through a volatile pointer so that the reference copy is not elided
+static void* (*volatile copy_memory)(void*, const void*, size_t) = memcpy;
+
+typedef struct snapshot_buffer_s {
+	char* data;
+	size_t size;
+	size_t capacity;
+} snapshot_buffer_t;
+
+static bool
+write_snapshot(const void* data, size_t size, void* userdata) {
+	snapshot_buffer_t* buffer = userdata;
+	if (buffer->size + size > buffer->capacity) {
+		buffer->capacity = buffer->capacity * 2 > buffer->size + size
+			? buffer->capacity * 2
+			: buffer->size + size;
+		buffer->data = realloc(buffer->data, buffer->capacity);
+	}
+	memcpy(buffer->data + buffer->size, data, size);
+	buffer->size += size;
+	return true;
+}
+
+// Compares rebuilding a world through eecs_create_entities with loading it
+// from an in-memory snapshot
+void
+bench_snapshot(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+
+	long num_entities = params->num_entities;
+	long num_archetypes = params->num_archetypes;
+	eecs_entity_t* entities = malloc(sizeof(eecs_entity_t) * num_entities);
+	eecs_component_init_t init[BENCH_NUM_COMPONENTS + 1];
+
+	uint64_t start = bench_now_ns();
+	long first = 0;
+	for (long i = 0; i < num_archetypes; ++i) {
+		long count = num_entities / num_archetypes + (i < num_entities % num_archetypes);
+		bench_archetype_init(&env, i, init);
+		eecs_create_entities(env.world, init, (eecs_id_t)count, entities + first);
+		first += count;
+	}
+	bench_report(params, "rebuild_world", bench_now_ns() - start, num_entities);
+
+	snapshot_buffer_t buffer = { 0 };
+	start = bench_now_ns();
+	eecs_save_world(env.world, write_snapshot, &buffer);
+	bench_report(params, "save_world", bench_now_ns() - start, num_entities);
+
+	eecs_world_t* loaded = eecs_create_world(env.ecs, (eecs_world_options_t){
+		.table_chunk_size = (size_t)params->table_chunk_size,
+	});
+	start = bench_now_ns();
+	eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){ 0 });
+	bench_report(params, "load_world", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	char* copy = malloc(buffer.size);
+	copy_memory(copy, buffer.data, buffer.size);
+	bench_report(params, "copy_snapshot", bench_now_ns() - start, num_entities);
+
+	free(copy);
+	eecs_destroy_world(loaded);
+	free(buffer.data);
+	free(entities);
+	bench_cleanup_env(&env);
+}
+
+// Replication of a world where one entity in a hundred changed since the last
+// tick, against serializing every component through a query
+void
+bench_delta(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+
+	long num_entities = params->num_entities;
+	long num_archetypes = params->num_archetypes;
+	size_t component_size = (size_t)params->component_size;
+	eecs_entity_t* entities = malloc(sizeof(eecs_entity_t) * num_entities);
+	eecs_component_init_t init[BENCH_NUM_COMPONENTS + 1];
+	long first = 0;
+	for (long i = 0; i < num_archetypes; ++i) {
+		long count = num_entities / num_archetypes + (i < num_entities % num_archetypes);
+		bench_archetype_init(&env, i, init);
+		eecs_create_entities(env.world, init, (eecs_id_t)count, entities + first);
+		first += count;
+	}
+	bench_shuffle(entities, num_entities);
+
+	eecs_world_t* replica = eecs_create_world(env.ecs, (eecs_world_options_t){
+		.table_chunk_size = (size_t)params->table_chunk_size,
+	});
+	eecs_delta_baseline_t* baseline = eecs_create_delta_baseline(env.world);
+	snapshot_buffer_t buffer = { 0 };
+	eecs_encode_delta(baseline, write_snapshot, &buffer);
+	eecs_apply_delta(replica, buffer.data, buffer.size);
+
+	for (long i = 0; i < num_entities / 100; ++i) {
+		char* data = eecs_get_component_in_entity(env.world, entities[i], env.components[0]);
+		memset(data, (int)i + 1, component_size);
+	}
+
+	buffer.size = 0;
+	uint64_t start = bench_now_ns();
+	eecs_encode_delta(baseline, write_snapshot, &buffer);
+	bench_report(params, "encode_delta", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	eecs_apply_delta(replica, buffer.data, buffer.size);
+	bench_report(params, "apply_delta", bench_now_ns() - start, num_entities);
+
+	eecs_query_t* query = eecs_create_query(env.world, (eecs_query_options_t){
+		.require_components = (eecs_component_t[]){ env.components[0], EECS_END_OF_LIST },
+	});
+	buffer.size = 0;
+	start = bench_now_ns();
+	eecs_query_iterator_t itr = eecs_iterate_query(query);
+	eecs_batch_t batch;
+	while (eecs_next_query_batch(&itr, &batch)) {
+		write_snapshot(
+			eecs_get_components_in_batch(batch, 0),
+			component_size * (size_t)eecs_get_batch_size(batch),
+			&buffer
+		);
+	}
+	bench_report(params, "serialize_components", bench_now_ns() - start, num_entities);
+
+	eecs_destroy_query(query);
+	free(buffer.data);
+	eecs_destroy_delta_baseline(baseline);
+	eecs_destroy_world(replica);
+	free(entities);
+	bench_cleanup_env(&env);
+}
+
+// Forking a world, writing to one entity in a hundred of the fork then
+// throwing it away, against saving and loading a snapshot of the world
+void
+bench_fork(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+
+	long num_entities = params->num_entities;
+	long num_archetypes = params->num_archetypes;
+	size_t component_size = (size_t)params->component_size;
+	eecs_entity_t* entities = malloc(sizeof(eecs_entity_t) * num_entities);
+	eecs_component_init_t init[BENCH_NUM_COMPONENTS + 1];
+	long first = 0;
+	for (long i = 0; i < num_archetypes; ++i) {
+		long count = num_entities / num_archetypes + (i < num_entities % num_archetypes);
+		bench_archetype_init(&env, i, init);
+		eecs_create_entities(env.world, init, (eecs_id_t)count, entities + first);
+		first += count;
+	}
+	bench_shuffle(entities, num_entities);
+
+	uint64_t start = bench_now_ns();
+	eecs_world_t* fork = eecs_fork_world(env.world);
+	bench_report(params, "fork_world", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	for (long i = 0; i < num_entities / 100; ++i) {
+		char* data = eecs_get_component_in_entity(fork, entities[i], env.components[0]);
+		memset(data, (int)i + 1, component_size);
+	}
+	bench_report(params, "write_fork", bench_now_ns() - start, num_entities);
+
+	start = bench_now_ns();
+	eecs_destroy_world(fork);
+	bench_report(params, "destroy_fork", bench_now_ns() - start, num_entities);
+
+	snapshot_buffer_t buffer = { 0 };
+	eecs_world_t* loaded = eecs_create_world(env.ecs, (eecs_world_options_t){
+		.table_chunk_size = (size_t)params->table_chunk_size,
+	});
+	start = bench_now_ns();
+	eecs_save_world(env.world, write_snapshot, &buffer);
+	eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){ 0 });
+	bench_report(params, "save_load_world", bench_now_ns() - start, num_entities);
+
+	eecs_destroy_world(loaded);
+	free(buffer.data);
+	free(entities);
+	bench_cleanup_env(&env);
+}
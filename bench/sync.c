@@ -0,0 +1,49 @@
+#include <stdlib.h>
+#include "bench.h"
+
+#define NUM_SYNCS 200
+
+static void
+noop_batch(eecs_world_t* world, eecs_batch_t batch, void* userdata) {
+	(void)world;
+	(void)batch;
+	(void)userdata;
+}
+
+// Measures how long a world takes to catch up after a system is registered
+void
+bench_sync(const bench_params_t* params) {
+	bench_env_t env;
+	bench_init_env(&env, params);
+
+	eecs_component_init_t init[BENCH_NUM_COMPONENTS + 1];
+	for (long i = 0; i < params->num_archetypes; ++i) {
+		bench_archetype_init(&env, i, init);
+		eecs_create_entity(env.world, init);
+	}
+
+	for (long i = 0; i < params->num_systems; ++i) {
+		eecs_system_t system = EECS_HANDLE_INIT;
+		eecs_register_system(env.ecs, &system, (eecs_system_options_t){
+			.require_components = (eecs_component_t[]){
+				env.components[1 + i % (BENCH_NUM_COMPONENTS - 1)],
+				EECS_END_OF_LIST,
+			},
+			.update_fn = noop_batch,
+		});
+	}
+
+	// Registering it again bumps the version and running it syncs the world
+	eecs_system_t trigger = EECS_HANDLE_INIT;
+	eecs_register_system(env.ecs, &trigger, (eecs_system_options_t){ 0 });
+	eecs_run_system(env.world, EECS_UPDATE_ALL, trigger);
+
+	uint64_t start = bench_now_ns();
+	for (long i = 0; i < NUM_SYNCS; ++i) {
+		eecs_register_system(env.ecs, &trigger, (eecs_system_options_t){ 0 });
+		eecs_run_system(env.world, EECS_UPDATE_ALL, trigger);
+	}
+	bench_report(params, "sync_world", bench_now_ns() - start, NUM_SYNCS);
+
+	bench_cleanup_env(&env);
+}
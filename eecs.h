@@ -29,11 +29,17 @@
 #	define EECS_DEFAULT_TABLE_CHUNK_SIZE 16384
 #endif
 
+// Slots per page of the entity directory, must be a power of 2 of at least 16
+#ifndef EECS_ENTITY_PAGE_SIZE
+#	define EECS_ENTITY_PAGE_SIZE 4096
+#endif
+
 #ifndef EECS_MALLOC
 #include <stdlib.h>
 #define EECS_MALLOC(CTX, SIZE) malloc(SIZE)
 #define EECS_REALLOC(CTX, PTR, NEW_SIZE) realloc(PTR, NEW_SIZE)
 #define EECS_FREE(CTX, SIZE) free(SIZE)
+#define EECS_ALIGNED_MALLOC(CTX, ALIGNMENT, SIZE) aligned_alloc(ALIGNMENT, SIZE)
 #endif
 
 #define EECS_UPDATE_ALL ((eecs_mask_t)-1)
@@ -51,6 +57,9 @@ typedef EECS_MASK_TYPE eecs_mask_t;
 
 typedef struct eecs_s eecs_t;
 typedef struct eecs_world_s eecs_world_t;
+typedef struct eecs_chunk_pool_s eecs_chunk_pool_t;
+typedef struct eecs_query_s eecs_query_t;
+typedef struct eecs_delta_baseline_s eecs_delta_baseline_t;
 typedef struct { eecs_id_t from_1_index; eecs_id_t gen; } eecs_entity_t;
 typedef struct { eecs_id_t from_1_index; } eecs_component_t;
 typedef struct { eecs_id_t from_1_index; } eecs_system_t;
@@ -59,8 +68,16 @@ typedef struct { eecs_id_t from_1_index; } eecs_template_t;
 typedef struct eecs_batch_s {
 	eecs_world_t* world;
 	eecs_id_t size;
+	// size rounded up to the world's batch_width
+	eecs_id_t padded_size;
 	void* chunk;
 	ptrdiff_t* offsets;
+	// Offset of the enable bits of each component or -1, NULL when none of
+	// the components is enableable
+	ptrdiff_t* enable_mask_offsets;
+	// Row of the first entity in its chunk, only past 0 in batches narrowed
+	// by sparse components
+	eecs_id_t first_row;
 } eecs_batch_t;
 
 typedef void (*eecs_component_fn_t)(
@@ -90,21 +107,66 @@ typedef void (*eecs_system_entity_fn_t)(
 typedef struct eecs_component_init_s {
 	eecs_component_t component;
 	const void* data;
+	// Only used by eecs_create_entities: data points to one value per entity
+	// instead of a single value shared by all entities. Morphs reject it.
+	bool per_entity;
 } eecs_component_init_t;
 
+typedef enum eecs_storage_e {
+	// In a column of the entity's table: adding or removing the component
+	// moves the entity to another table
+	EECS_STORAGE_TABLE = 0,
+	// In a sparse set of the world, outside of the tables: adding or removing
+	// the component does not move the entity. Meant for components which are
+	// toggled often. Systems and queries check them entity by entity.
+	EECS_STORAGE_SPARSE,
+} eecs_storage_t;
+
 typedef struct eecs_component_options_s {
+	// 0 for tags, which only select tables. They take no room in chunks and
+	// their pointers must not be dereferenced.
 	size_t size;
 	size_t alignment;
 	eecs_component_fn_t init_fn;
 	eecs_component_fn_t cleanup_fn;
 	void* userdata;
+	// Cannot be changed by re-registering the component
+	eecs_storage_t storage;
+	// Each entity has an enable bit for the component, which is toggled with
+	// eecs_set_component_enabled without moving the entity to another table.
+	// Disabled components keep their data and still match systems and
+	// queries: the bits are read from batches with
+	// eecs_get_enable_masks_in_batch. Cannot be changed by re-registering the
+	// component and only applies to table storage.
+	bool enableable;
 } eecs_component_options_t;
 
 typedef struct eecs_system_options_s {
 	void* userdata;
 	eecs_mask_t update_mask;
+	// Sparse components narrow each batch down to runs of entities which
+	// have the required ones and lack the excluded ones. Their data is not in
+	// batches: eecs_get_components_in_batch returns NULL for them. Changes to
+	// them are not tracked and per-entity callbacks do not consider them.
 	eecs_component_t* require_components;
 	eecs_component_t* exclude_components;
+	// Not needed to match. In batches, they follow the required components
+	// and eecs_get_components_in_batch returns NULL when they are missing.
+	eecs_component_t* optional_components;
+	// Components accessed by the system. Required and optional components are
+	// assumed to be read. When either list is given and no_structural_changes
+	// is set, eecs_run_systems may run this system concurrently with other
+	// such systems it does not conflict with. Otherwise, the system never
+	// overlaps with any other system.
+	eecs_component_t* read_components;
+	eecs_component_t* write_components;
+	// Only call update_fn on batches where one of these components changed
+	// since the last run of this system. Changes are tracked per chunk and
+	// column: a column changes when entities are created, moved or morphed
+	// into the chunk, when a system writing the component runs over the chunk
+	// or when eecs_mark_component_changed is called. Systems which do not
+	// declare their accesses are assumed to write their required components.
+	eecs_component_t* changed_components;
 	eecs_system_world_fn_t pre_update_fn;
 	eecs_system_world_fn_t post_update_fn;
 	eecs_system_update_fn_t update_fn;
@@ -112,18 +174,154 @@ typedef struct eecs_system_options_s {
 	eecs_system_world_fn_t cleanup_per_world_fn;
 	eecs_system_entity_fn_t init_per_entity_fn;
 	eecs_system_entity_fn_t cleanup_per_entity_fn;
+	// Spread update_fn calls over the world's worker threads.
+	// Destroy and morph calls made during the update are all deferred until
+	// every batch has been processed and then applied in table and chunk order.
+	bool parallel;
+	// Skip the chunks where no entity has all of its enableable required
+	// components enabled. The other batches still hold disabled entities.
+	bool skip_disabled_chunks;
+	// update_fn does not create, destroy or morph entities, which asserts.
+	// Only such systems can share a stage, as their update does not depend
+	// on when the others apply their changes. Systems with a pre_update_fn or
+	// a post_update_fn always run alone.
+	bool no_structural_changes;
 } eecs_system_options_t;
 
+typedef struct eecs_query_options_s {
+	// Sparse components narrow batches as for systems
+	const eecs_component_t* require_components;
+	const eecs_component_t* exclude_components;
+	// Not needed to match. In batches, they follow the required components
+	// and eecs_get_components_in_batch returns NULL when they are missing.
+	const eecs_component_t* optional_components;
+} eecs_query_options_t;
+
+typedef struct eecs_query_iterator_s {
+	eecs_query_t* query;
+	eecs_id_t match_index;
+	eecs_id_t chunk_index;
+	// Where the next run starts in the chunk, with sparse components
+	eecs_id_t row_index;
+} eecs_query_iterator_t;
+
+typedef struct eecs_chunk_pool_options_s {
+	void* memctx;
+	size_t chunk_size;
+	// Number of chunks allocated up front and kept when trimming
+	eecs_id_t low_watermark;
+	// When more chunks are pooled, the surplus down to low_watermark is freed.
+	// 0 means no limit.
+	eecs_id_t high_watermark;
+	// Bytes of address space reserved up front. Chunks are carved from it
+	// back to back, backed by transparent huge pages where available, and
+	// the whole pages of trimmed ones are returned to the OS but keep their
+	// addresses.
+	// The allocator is used once it runs out.
+	// Only used when the implementation is compiled with EECS_MMAP.
+	size_t reserve_size;
+	// Must be at least the column_alignment of the worlds using the pool
+	size_t chunk_alignment;
+} eecs_chunk_pool_options_t;
+
 typedef struct eecs_world_options_s {
 	void* memctx;
 	void* table_chunk_memctx;
 	size_t table_chunk_size;
+	// When set, chunks are taken from and returned to this pool instead of
+	// the allocator. Its memctx and chunk_size replace table_chunk_memctx and
+	// table_chunk_size.
+	eecs_chunk_pool_t* chunk_pool;
+	// Number of threads spawned to run parallel systems alongside the calling
+	// thread. They are started by the first parallel update. Only used when the
+	// implementation is compiled with EECS_THREADS.
+	eecs_id_t num_worker_threads;
+	// Alignment of every column in a table chunk, including the entity ids,
+	// e.g. 64 for cache lines and AVX-512. It must be a power of two.
+	// Chunks are allocated with EECS_ALIGNED_MALLOC when it exceeds the
+	// alignment of EECS_ALIGN_TYPE.
+	// 0 aligns each column to its component only.
+	size_t column_alignment;
+	// The number of entities per chunk is rounded down to a multiple of this
+	// so that update functions can process eecs_get_padded_batch_size entities
+	// in full vector iterations. The padding rows hold unspecified values.
+	// 0 means 1.
+	eecs_id_t batch_width;
 } eecs_world_options_t;
 
 typedef struct eecs_options_s {
 	void* memctx;
 } eecs_options_t;
 
+// Receives a snapshot piece by piece, returns false to abort the save
+typedef bool (*eecs_write_fn_t)(const void* data, size_t size, void* userdata);
+
+typedef struct eecs_load_options_s {
+	// The component to load in place of each component of the saved world,
+	// indexed by registration order at save time. A zero handle drops the
+	// component. NULL when components are registered in the same order.
+	const eecs_component_t* component_map;
+	// Call the init_fn of components and the init_per_entity_fn of systems
+	// for every loaded entity, as if it was just created
+	bool run_init_callbacks;
+} eecs_load_options_t;
+
+typedef struct eecs_system_stats_s {
+	uint64_t num_runs;
+	// Time spent in the system's callbacks and in applying its deferred
+	// operations. When the system shares a stage with others, the time spent
+	// in its batches is summed across threads.
+	uint64_t update_time_ns;
+	eecs_id_t num_matched_tables;
+	uint64_t num_chunks_visited;
+	uint64_t num_entities_processed;
+	uint64_t num_deferred_ops_applied;
+} eecs_system_stats_t;
+
+typedef struct eecs_world_stats_s {
+	uint64_t num_entities_created;
+	uint64_t num_entities_destroyed;
+	uint64_t num_entities_morphed;
+	uint64_t num_tables_created;
+	// Number of times the world caught up with new components or systems
+	uint64_t num_syncs;
+	// Chunks for tables and arenas, from the allocator or the free list
+	uint64_t num_chunks_allocated;
+	uint64_t num_chunks_reused;
+	// Chunks shared with a fork which had to be copied before a write
+	uint64_t num_chunks_copied;
+} eecs_world_stats_t;
+
+typedef struct eecs_table_memory_s {
+	const eecs_component_t* components;
+	eecs_id_t num_components;
+	eecs_id_t num_entities;
+	eecs_id_t num_chunks;
+	eecs_id_t num_entities_per_chunk;
+	// Bytes per row: the entity id and every component
+	size_t entity_size;
+	// Bytes lost to column alignment and to the unused tail of each chunk,
+	// amortized over the rows of a full chunk
+	size_t alignment_waste_per_entity;
+} eecs_table_memory_t;
+
+typedef struct eecs_world_memory_s {
+	size_t table_chunk_size;
+	eecs_id_t num_tables;
+	// Chunks holding table rows
+	eecs_id_t num_table_chunks;
+	// Released chunks kept for reuse, see eecs_compact_world
+	eecs_id_t num_pooled_chunks;
+	// Chunks held by arenas, worker arenas are counted in deferred
+	eecs_id_t num_version_arena_chunks;
+	eecs_id_t num_deferred_arena_chunks;
+	eecs_id_t num_tmp_arena_chunks;
+	// Slots in the entity directory, free ones are waiting for reuse
+	eecs_id_t num_entity_slots;
+	eecs_id_t num_free_entity_slots;
+	eecs_id_t entity_slot_capacity;
+} eecs_world_memory_t;
+
 EECS_API eecs_t*
 eecs_create(eecs_options_t options);
 
@@ -144,12 +342,40 @@ eecs_register_system(
 	eecs_system_options_t options
 );
 
+// A chunk pool can be shared by several worlds, across threads when the
+// implementation is compiled with EECS_THREADS.
+// It must outlive all the worlds using it.
+EECS_API eecs_chunk_pool_t*
+eecs_create_chunk_pool(eecs_chunk_pool_options_t options);
+
+EECS_API void
+eecs_destroy_chunk_pool(eecs_chunk_pool_t* pool);
+
+// Number of chunks currently in the pool
+EECS_API eecs_id_t
+eecs_get_chunk_pool_size(eecs_chunk_pool_t* pool);
+
 EECS_API eecs_world_t*
 eecs_create_world(eecs_t* ecs, eecs_world_options_t options);
 
 EECS_API void
 eecs_destroy_world(eecs_world_t* world);
 
+// Create a world with the same entities, components and templates, sharing
+// the table chunks and the entity directory with the original until either
+// world writes to them. Only the chunks which are written get copied so a
+// fork costs about one reference per chunk and so does destroying it.
+// System matches are cloned rather than recomputed and worker threads are
+// only started if the fork runs systems in parallel.
+// Component data is copied byte for byte: anything it points to is shared.
+// The fork gets its own per-world system data and no queries. Entity
+// callbacks are not called for the forked entities.
+// With EECS_THREADS, a world and its forks may be used from different threads
+// at the same time. Otherwise they must be used from one thread.
+// Cannot be called during an update.
+EECS_API eecs_world_t*
+eecs_fork_world(eecs_world_t* world);
+
 EECS_API void
 eecs_set_per_world_userdata(
 	eecs_world_t* world,
@@ -166,6 +392,14 @@ eecs_get_per_world_userdata(
 EECS_API eecs_entity_t
 eecs_create_entity(eecs_world_t* world, const eecs_component_init_t* init);
 
+EECS_API void
+eecs_create_entities(
+	eecs_world_t* world,
+	const eecs_component_init_t* init,
+	eecs_id_t count,
+	eecs_entity_t* handles_out
+);
+
 EECS_API void
 eecs_morph_entity(
 	eecs_world_t* world,
@@ -174,6 +408,7 @@ eecs_morph_entity(
 	const eecs_component_t* removed_components
 );
 
+// Templates cannot have sparse components
 EECS_API void
 eecs_register_template(
 	eecs_world_t* world,
@@ -191,6 +426,48 @@ eecs_create_entity_from_template(
 EECS_API void
 eecs_destroy_entity(eecs_world_t* world, eecs_entity_t entity);
 
+EECS_API void
+eecs_destroy_entities(
+	eecs_world_t* world,
+	const eecs_entity_t* entities,
+	eecs_id_t count
+);
+
+EECS_API void
+eecs_morph_entities(
+	eecs_world_t* world,
+	const eecs_entity_t* entities,
+	eecs_id_t count,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+);
+
+EECS_API void
+eecs_destroy_entities_in_batch(eecs_batch_t batch);
+
+EECS_API void
+eecs_morph_entities_in_batch(
+	eecs_batch_t batch,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+);
+
+EECS_API void
+eecs_destroy_entities_matching(
+	eecs_world_t* world,
+	const eecs_component_t* require_components,
+	const eecs_component_t* exclude_components
+);
+
+EECS_API void
+eecs_morph_entities_matching(
+	eecs_world_t* world,
+	const eecs_component_t* require_components,
+	const eecs_component_t* exclude_components,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+);
+
 EECS_API bool
 eecs_is_valid_entity(eecs_world_t* world, eecs_entity_t entity);
 
@@ -201,6 +478,83 @@ eecs_get_component_in_entity(
 	eecs_component_t component_type
 );
 
+// Resolve many handles at once, with the directory entries and rows being
+// prefetched ahead of use. out[i] is the component of entities[i] or NULL
+// when the entity is not valid or does not have the component.
+EECS_API void
+eecs_get_components_for_entities(
+	eecs_world_t* world,
+	const eecs_entity_t* entities,
+	eecs_id_t count,
+	eecs_component_t component,
+	void** out
+);
+
+// Same with a list of components, out[i * num_components + j] is the
+// component j of entities[i]
+EECS_API void
+eecs_get_multiple_components_for_entities(
+	eecs_world_t* world,
+	const eecs_entity_t* entities,
+	eecs_id_t count,
+	const eecs_component_t* components,
+	void** out
+);
+
+// Report a write made through eecs_get_component_in_entity to systems
+// filtering on changed_components
+EECS_API void
+eecs_mark_component_changed(
+	eecs_world_t* world,
+	eecs_entity_t entity,
+	eecs_component_t component
+);
+
+// Toggle an enableable component of an entity. Components are enabled when
+// added. This is a write to the component: it is seen by changed filters and
+// systems doing it must declare write access to the component.
+EECS_API void
+eecs_set_component_enabled(
+	eecs_world_t* world,
+	eecs_entity_t entity,
+	eecs_component_t component,
+	bool enabled
+);
+
+// False when the entity does not have the component. Components which are
+// not enableable are always enabled.
+EECS_API bool
+eecs_is_component_enabled(
+	eecs_world_t* world,
+	eecs_entity_t entity,
+	eecs_component_t component
+);
+
+// A query matches tables like a system but belongs to a single world and
+// does not require a registration. Its matches are cached and updated as
+// tables are created.
+EECS_API eecs_query_t*
+eecs_create_query(eecs_world_t* world, eecs_query_options_t options);
+
+EECS_API void
+eecs_destroy_query(eecs_query_t* query);
+
+// Iterate the non-empty chunks of the matched tables:
+//
+//     eecs_query_iterator_t itr = eecs_iterate_query(query);
+//     eecs_batch_t batch;
+//     while (eecs_next_query_batch(&itr, &batch)) { ... }
+//
+// Entities must not be created, destroyed or morphed while iterating.
+// Batches narrowed by sparse components are only valid until the next call.
+// Writes made through the batches are not seen by changed filters unless
+// they are reported with eecs_mark_component_changed.
+EECS_API eecs_query_iterator_t
+eecs_iterate_query(eecs_query_t* query);
+
+EECS_API bool
+eecs_next_query_batch(eecs_query_iterator_t* itr, eecs_batch_t* batch);
+
 EECS_API void
 eecs_run_systems(eecs_world_t* world, eecs_mask_t update_mask);
 
@@ -210,12 +564,131 @@ eecs_run_system(eecs_world_t* world, eecs_mask_t update_mask, eecs_system_t syst
 EECS_API eecs_mask_t
 eecs_get_current_update_mask(eecs_world_t* world);
 
+// Statistics are only collected when the implementation is compiled with
+// EECS_STATS. Otherwise, these return false and leave stats untouched.
+EECS_API bool
+eecs_get_world_stats(eecs_world_t* world, eecs_world_stats_t* stats);
+
+EECS_API bool
+eecs_get_system_stats(
+	eecs_world_t* world,
+	eecs_system_t system,
+	eecs_system_stats_t* stats
+);
+
+EECS_API void
+eecs_reset_stats(eecs_world_t* world);
+
+EECS_API void
+eecs_get_world_memory(eecs_world_t* world, eecs_world_memory_t* memory);
+
+// Fill up to max_tables entries and return the total number of tables
+EECS_API eecs_id_t
+eecs_get_table_memory(
+	eecs_world_t* world,
+	eecs_table_memory_t* tables,
+	eecs_id_t max_tables
+);
+
+// Return memory left over by churn: trim table and entity arrays to fit and
+// free pooled chunks beyond max_pooled_chunks, or give them back to the
+// world's chunk pool.
+// Must not be called while the world is being updated.
+EECS_API void
+eecs_compact_world(eecs_world_t* world, eecs_id_t max_pooled_chunks);
+
+// Write the tables, the entity directory and the sparse sets of a world as
+// they are in memory. Snapshots can only be loaded by a build with the same
+// eecs_id_t and byte order. Must not be called while the world is being
+// updated.
+EECS_API bool
+eecs_save_world(eecs_world_t* world, eecs_write_fn_t write_fn, void* userdata);
+
+// Load a snapshot into a world which never had any entity. Chunks are copied
+// whole when the table layout did not change and column by column otherwise.
+// Entity handles from the saved world stay valid.
+// Return false when the snapshot is invalid or does not match the components.
+EECS_API bool
+eecs_load_world(
+	eecs_world_t* world,
+	const void* snapshot,
+	size_t size,
+	eecs_load_options_t options
+);
+
+EECS_API bool
+eecs_save_world_to_file(eecs_world_t* world, const char* path);
+
+// The file is mapped when the implementation is compiled with EECS_MMAP and
+// read whole otherwise
+EECS_API bool
+eecs_load_world_from_file(
+	eecs_world_t* world,
+	const char* path,
+	eecs_load_options_t options
+);
+
+// The state of a world as last sent to its replicas. A new baseline is empty
+// so the first delta carries the whole world.
+EECS_API eecs_delta_baseline_t*
+eecs_create_delta_baseline(eecs_world_t* world);
+
+EECS_API void
+eecs_destroy_delta_baseline(eecs_delta_baseline_t* baseline);
+
+// Write what changed in the world since the baseline then update the
+// baseline: the rows of each chunk column which differ, the row count of each
+// table, the tables created, the directory entries of entities which were
+// created, destroyed or moved and the whole of each sparse set which changed.
+// Must not be called while the world is being updated.
+EECS_API bool
+eecs_encode_delta(
+	eecs_delta_baseline_t* baseline,
+	eecs_write_fn_t write_fn,
+	void* userdata
+);
+
+// Apply a delta to a replica which mirrors the baseline it was encoded
+// against. The replica must have the same components and chunk layout
+// options, and must only be changed through deltas: rows are copied to the
+// same positions and no callback is called.
+// Return false on an invalid delta. The whole delta is checked before it is
+// applied so the replica is left as it was, save for empty tables the delta
+// described, and the same delta may be applied again.
+EECS_API bool
+eecs_apply_delta(eecs_world_t* replica, const void* delta, size_t size);
+
 EECS_API eecs_id_t
 eecs_get_batch_size(eecs_batch_t batch);
 
+// Batch size rounded up to the world's batch_width. Rows past
+// eecs_get_batch_size can be read and written but do not belong to entities.
+// Batches narrowed by sparse components are not padded.
+EECS_API eecs_id_t
+eecs_get_padded_batch_size(eecs_batch_t batch);
+
+// NULL for optional components missing from the batch's table
 EECS_API void*
 eecs_get_components_in_batch(eecs_batch_t batch, eecs_id_t match_index);
 
+// Enable bits of an enableable component in the batch. Entity i is enabled
+// when bit (first_bit + i) % N of mask (first_bit + i) / N is set, N being
+// the number of bits in eecs_mask_t. first_bit is 0 unless the batch was
+// narrowed by sparse components and bits past the batch size are
+// unspecified. NULL when the component is not enableable or missing.
+EECS_API const eecs_mask_t*
+eecs_get_enable_masks_in_batch(
+	eecs_batch_t batch,
+	eecs_id_t match_index,
+	eecs_id_t* first_bit_out
+);
+
+// Whether entity index of the batch has the component enabled. False for
+// optional components missing from the batch, true for components which are
+// not enableable.
+EECS_API bool
+eecs_is_enabled_in_batch(eecs_batch_t batch, eecs_id_t match_index, eecs_id_t index);
+
 EECS_API eecs_entity_t
 eecs_get_entity_in_batch(eecs_batch_t batch, eecs_id_t index);
 
@@ -224,6 +697,50 @@ eecs_get_entity_in_batch(eecs_batch_t batch, eecs_id_t index);
 #ifdef EECS_IMPLEMENTATION
 
 #include <string.h>
+#include <stdio.h>
+
+#ifdef EECS_THREADS
+#include <threads.h>
+#include <stdatomic.h>
+#endif
+
+// EECS_MMAP needs MAP_ANONYMOUS and madvise, which may require a feature test
+// macro such as _DEFAULT_SOURCE
+#ifdef EECS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#	ifndef EECS_HUGE_PAGE_SIZE
+#		define EECS_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#	endif
+#endif
+
+// EECS_STATS_CLOCK() can be defined to read a cheaper or monotonic clock,
+// in nanoseconds
+#ifdef EECS_STATS
+#	ifndef EECS_STATS_CLOCK
+#		include <time.h>
+#		define EECS_STATS_CLOCK() eecs_default_stats_clock()
+#		define EECS_DEFAULT_STATS_CLOCK
+#	endif
+#	define eecs_stat_add(stats, field, value) ((stats).field += (uint64_t)(value))
+#else
+#	define eecs_stat_add(stats, field, value) ((void)(value))
+#endif
+
+#ifndef EECS_PREFETCH
+#	if defined(__GNUC__) || defined(__clang__)
+#		define EECS_PREFETCH(ADDR) __builtin_prefetch(ADDR)
+#	else
+#		define EECS_PREFETCH(ADDR) ((void)(ADDR))
+#	endif
+#endif
+
+// How many entities ahead eecs_get_components_for_entities prefetches
+#ifndef EECS_PREFETCH_DISTANCE
+#	define EECS_PREFETCH_DISTANCE 8
+#endif
 
 #define eecs_max(a, b) ((a) > (b) ? (a) : (b))
 #define eecs_min(a, b) ((a) < (b) ? (a) : (b))
@@ -239,6 +756,24 @@ eecs_malloc(void* memctx, size_t size) {
 	return ptr;
 }
 
+EECS_PRIVATE void*
+eecs_malloc_aligned(void* memctx, size_t alignment, size_t size) {
+	if (alignment <= _Alignof(EECS_ALIGN_TYPE)) {
+		return eecs_malloc(memctx, size);
+	}
+
+#ifdef EECS_ALIGNED_MALLOC
+	void* ptr = EECS_ALIGNED_MALLOC(memctx, alignment, size);
+	EECS_ASSERT(ptr != NULL, "Out of memory");
+	return ptr;
+#else
+	(void)memctx;
+	(void)size;
+	EECS_ASSERT(false, "EECS_ALIGNED_MALLOC is required for over-aligned chunks");
+	return NULL;
+#endif
+}
+
 EECS_PRIVATE void
 eecs_free(void* memctx, void* ptr) {
 	EECS_FREE(memctx, ptr);
@@ -280,6 +815,11 @@ eecs_realloc(void* memctx, void* ptr, size_t new_size) {
 #define eecs_array_clear(array) \
 	eecs_dynamic_array_clear(array)
 
+#define eecs_array_shrink_to_fit(allocator, array) \
+	do { \
+		array = eecs_dynamic_array_shrink_to_fit(allocator, array, sizeof(*array)); \
+	} while (0)
+
 #define eecs_array_free(allocator, array) \
 	eecs_free_dynamic_array(allocator, array)
 
@@ -302,7 +842,7 @@ eecs_realloc(void* memctx, void* ptr, size_t new_size) {
 		for (eecs_id_t sort_i = 1; sort_i < length; ++sort_i) { \
 			element_type element_i = array[sort_i]; \
 			eecs_id_t sort_j = sort_i; \
-			while ((sort_j >= 0) && (cmp_lt(element_i, array[sort_j - 1]))) { \
+			while ((sort_j > 0) && (cmp_lt(element_i, array[sort_j - 1]))) { \
 				array[sort_j] = array[sort_j - 1]; \
 				--sort_j; \
 			} \
@@ -428,6 +968,29 @@ eecs_dynamic_array_resize(
 	}
 }
 
+EECS_PRIVATE void*
+eecs_dynamic_array_shrink_to_fit(
+	void* memctx,
+	void* array,
+	size_t element_size
+) {
+	eecs_id_t length = eecs_array_length(array);
+	if (length == eecs_array_capacity(array)) {
+		return array;
+	} else if (length == 0) {
+		eecs_free_dynamic_array(memctx, array);
+		return NULL;
+	} else {
+		eecs_dynamic_array_t* header = eecs_realloc(
+			memctx,
+			eecs_dynamic_array_header(array),
+			length * (eecs_id_t)element_size + sizeof(eecs_dynamic_array_t)
+		);
+		header->capacity = length;
+		return header->elements;
+	}
+}
+
 EECS_PRIVATE eecs_id_t
 eecs_dynamic_array_pop(void* array) {
 	eecs_dynamic_array_t* header = eecs_dynamic_array_header(array);
@@ -462,25 +1025,60 @@ EECS_PRIVATE void
 eecs_bitset_set(eecs_bitset_t* bitset, eecs_id_t bit_index) {
 	eecs_id_t num_bits_per_mask = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
 	eecs_id_t mask_index = (eecs_id_t)((eecs_mask_t)bit_index / num_bits_per_mask);
-	eecs_mask_t bit_mask = 1 << ((eecs_mask_t)bit_index % num_bits_per_mask);
+	eecs_mask_t bit_mask = (eecs_mask_t)1 << ((eecs_mask_t)bit_index % num_bits_per_mask);
 	EECS_ASSERT(mask_index < bitset->num_masks, "Out of bound");
 
 	bitset->masks[mask_index] |= bit_mask;
 }
 
+EECS_PRIVATE void
+eecs_bitset_clear(eecs_bitset_t* bitset, eecs_id_t bit_index) {
+	eecs_id_t num_bits_per_mask = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
+	eecs_id_t mask_index = (eecs_id_t)((eecs_mask_t)bit_index / num_bits_per_mask);
+	eecs_mask_t bit_mask = (eecs_mask_t)1 << ((eecs_mask_t)bit_index % num_bits_per_mask);
+	EECS_ASSERT(mask_index < bitset->num_masks, "Out of bound");
+
+	bitset->masks[mask_index] &= ~bit_mask;
+}
+
 EECS_PRIVATE bool
 eecs_bitset_is_set(const eecs_bitset_t* bitset, eecs_id_t bit_index) {
 	eecs_id_t num_bits_per_mask = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
 	eecs_id_t mask_index = (eecs_id_t)((eecs_mask_t)bit_index / num_bits_per_mask);
 
 	if (mask_index < bitset->num_masks) {
-		eecs_mask_t bit_mask = 1 << ((eecs_mask_t)bit_index % num_bits_per_mask);
+		eecs_mask_t bit_mask = (eecs_mask_t)1 << ((eecs_mask_t)bit_index % num_bits_per_mask);
 		return (bitset->masks[mask_index] & bit_mask) > 0;
 	} else {
 		return false;
 	}
 }
 
+// Enable bits are stored as plain arrays of masks, one bit per row
+EECS_PRIVATE eecs_id_t
+eecs_num_enable_masks(eecs_id_t num_rows) {
+	eecs_id_t num_bits_per_mask = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
+	return (num_rows + num_bits_per_mask - 1) / num_bits_per_mask;
+}
+
+EECS_PRIVATE bool
+eecs_is_mask_bit_set(const eecs_mask_t* masks, eecs_id_t bit_index) {
+	eecs_id_t num_bits_per_mask = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
+	eecs_mask_t bit_mask = (eecs_mask_t)1 << ((eecs_mask_t)bit_index % num_bits_per_mask);
+	return (masks[bit_index / num_bits_per_mask] & bit_mask) > 0;
+}
+
+EECS_PRIVATE void
+eecs_set_mask_bit(eecs_mask_t* masks, eecs_id_t bit_index, bool value) {
+	eecs_id_t num_bits_per_mask = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
+	eecs_mask_t bit_mask = (eecs_mask_t)1 << ((eecs_mask_t)bit_index % num_bits_per_mask);
+	if (value) {
+		masks[bit_index / num_bits_per_mask] |= bit_mask;
+	} else {
+		masks[bit_index / num_bits_per_mask] &= ~bit_mask;
+	}
+}
+
 EECS_PRIVATE bool
 eecs_bitset_is_all_set(const eecs_bitset_t* bitset, const eecs_bitset_t* required_bits) {
 	bool result = true;
@@ -533,31 +1131,101 @@ typedef struct eecs_component_entity_callback_s {
 
 typedef struct eecs_table_s {
 	eecs_signature_t signature;
+	uint64_t signature_hash;
 	eecs_bitset_t* bitset;
+	// Position in world->tables
+	eecs_id_t index;
 
 	eecs_id_t num_entities_per_chunk;
 	ptrdiff_t* component_storage_offsets;
 	size_t* component_sizes;
+	// Columns of the components which have a size. Tags take no room in
+	// chunks so rows are written and moved without them.
+	eecs_id_t num_data_columns;
+	eecs_id_t* data_columns;
+	// Column of each component by index or -1. Components registered after
+	// the table was created cannot be in it and are past the end.
+	eecs_id_t num_component_columns;
+	eecs_id_t* component_columns;
+	// Columns of the enableable components. Their enable bits follow the
+	// component data in chunks, at enable_mask_offsets which is -1 for the
+	// other columns.
+	eecs_id_t num_enableable_columns;
+	eecs_id_t* enableable_columns;
+	ptrdiff_t* enable_mask_offsets;
 
 	eecs_array(eecs_system_entity_callback_t) system_init_callbacks;
 	eecs_array(eecs_system_entity_callback_t) system_cleanup_callbacks;
 	eecs_array(eecs_component_entity_callback_t) component_init_callbacks;
 	eecs_array(eecs_component_entity_callback_t) component_cleanup_callbacks;
 
+	// Cached transitions to the table with one component added or removed
+	eecs_array(struct eecs_table_edge_s) add_edges;
+	eecs_array(struct eecs_table_edge_s) remove_edges;
+
 	eecs_id_t num_entities;
 	eecs_array(char*) chunks;
+	// NULL until the table is forked, then the share of each chunk or NULL
+	// when only this world has the chunk
+	eecs_array(struct eecs_shared_block_s*) shared_chunks;
+	// Tick of the last change to each column of each chunk, indexed by
+	// chunk_index * signature.length + column
+	eecs_array(uint64_t) change_ticks;
 } eecs_table_t;
 
+typedef struct eecs_table_edge_s {
+	eecs_component_t component;
+	eecs_table_t* table;
+	// For each column of the target table, the source column or -1 if new
+	eecs_id_t* column_map;
+} eecs_table_edge_t;
+
 typedef struct eecs_system_table_match_s {
 	eecs_table_t* table;
 	ptrdiff_t* component_storage_offsets;
+	// NULL when the table has no enableable component
+	ptrdiff_t* enable_mask_offsets;
+	// Enableable required columns checked by skip_disabled_chunks
+	eecs_id_t num_enabled_columns;
+	eecs_id_t* enabled_columns;
+	// Columns stamped after each batch and columns checked by the changed filter
+	eecs_id_t num_write_columns;
+	eecs_id_t* write_columns;
+	eecs_id_t num_changed_columns;
+	eecs_id_t* changed_columns;
 } eecs_system_table_match_t;
 
+// Sparse components of require_components then exclude_components, which
+// are checked on each entity of the matched tables
+typedef struct eecs_sparse_filter_s {
+	eecs_id_t num_required;
+	eecs_id_t num_excluded;
+	eecs_id_t* components;
+	// Size of each component in batches, to narrow them down to runs
+	eecs_id_t num_batch_components;
+	size_t* batch_component_sizes;
+} eecs_sparse_filter_t;
+
 typedef struct eecs_system_data_s {
 	void* per_world_data;
+	// Table components only, sparse components are in sparse_filter
 	eecs_bitset_t* require_bitset;
 	eecs_bitset_t* exclude_bitset;
+	eecs_sparse_filter_t sparse_filter;
+	// Required and optional components, the columns exposed in batches
+	eecs_bitset_t* batch_bitset;
+	// NULL when the system did not declare its accesses
+	eecs_bitset_t* read_bitset;
+	eecs_bitset_t* write_bitset;
+	// Only set when the system has changed_components
+	eecs_bitset_t* changed_bitset;
 	eecs_array(eecs_system_table_match_t) matched_tables;
+	// Ticks of the current and previous runs
+	uint64_t run_tick;
+	uint64_t last_run_tick;
+#ifdef EECS_STATS
+	eecs_system_stats_t stats;
+#endif
 } eecs_system_data_t;
 
 typedef struct eecs_morph_entry_s {
@@ -585,38 +1253,335 @@ typedef struct eecs_arena_checkpoint_s {
 	uintptr_t bump_ptr;
 } eecs_arena_checkpoint_t;
 
+// Free slots have a NULL table and their pos_in_table links the next free
+// slot of their page
 typedef struct eecs_entity_data_s {
 	eecs_table_t* table;
 	eecs_id_t gen;
 	eecs_id_t pos_in_table;
 } eecs_entity_data_t;
 
+// The directory grows by whole pages which never move so that growing it
+// does not copy the existing slots
+typedef struct eecs_entity_page_s {
+	// from_1_index of the first free slot of the page or 0 when it is full
+	eecs_id_t next_free_slot;
+	// Index + 1 of the next page with free slots
+	eecs_id_t next_free_page;
+	eecs_entity_data_t slots[EECS_ENTITY_PAGE_SIZE];
+} eecs_entity_page_t;
+
+// Deltas compare the directory in blocks of 16 slots which must not straddle
+// a page
+_Static_assert(
+	EECS_ENTITY_PAGE_SIZE >= 16 && (EECS_ENTITY_PAGE_SIZE & (EECS_ENTITY_PAGE_SIZE - 1)) == 0,
+	"EECS_ENTITY_PAGE_SIZE must be a power of 2 of at least 16"
+);
+
 typedef enum eecs_defferred_op_type_e {
 	EECS_DESTROY_ENTITY,
 	EECS_MORPH_ENTITY,
+	EECS_DESTROY_ENTITIES,
+	EECS_MORPH_ENTITIES,
 } eecs_deferred_op_type_t;
 
 typedef struct eecs_deferred_op_s {
 	eecs_deferred_op_type_t type;
 	eecs_entity_t handle;
 
-	// For EECS_MORPH_ENTITY
+	// For EECS_DESTROY_ENTITIES and EECS_MORPH_ENTITIES
+	eecs_entity_t* handles;
+	eecs_id_t num_handles;
+
+	// For EECS_MORPH_ENTITY and EECS_MORPH_ENTITIES
 	eecs_component_init_t* new_components;
 	eecs_component_t* removed_components;
 
 	struct eecs_deferred_op_s* next;
 } eecs_deferred_op_t;
 
+typedef struct eecs_parallel_task_s {
+	const eecs_system_options_t* system_options;
+	eecs_system_data_t* system_data;
+	eecs_id_t match_begin;
+	eecs_id_t match_end;
+	// Chunk range within each matched table, a negative end means all chunks
+	eecs_id_t chunk_begin;
+	eecs_id_t chunk_end;
+
+	eecs_deferred_op_t* first_deferred_ops;
+	eecs_deferred_op_t* last_deferred_ops;
+
+	// Statistics, only updated with EECS_STATS
+	uint64_t update_time_ns;
+	uint64_t num_chunks_visited;
+	uint64_t num_entities_processed;
+} eecs_parallel_task_t;
+
+typedef struct eecs_worker_s {
+	eecs_world_t* world;
+	eecs_arena_t deferred_arena;
+	eecs_parallel_task_t* current_task;
+
+	// Range of tasks owned by this worker, others steal from it when idle
+#ifdef EECS_THREADS
+	_Atomic(eecs_id_t) next_task;
+	thrd_t thread;
+#else
+	eecs_id_t next_task;
+#endif
+	eecs_id_t end_task;
+	// Offsets of the batches narrowed by sparse components
+	eecs_array(ptrdiff_t) run_offsets;
+} eecs_worker_t;
+
+// Systems grouped into stages that do not conflict with each other
+typedef struct eecs_schedule_s {
+	eecs_mask_t update_mask;
+	eecs_array(eecs_id_t) systems;
+	eecs_array(eecs_id_t) stage_ends;
+} eecs_schedule_t;
+
+struct eecs_chunk_pool_s {
+	eecs_chunk_pool_options_t options;
+	eecs_table_chunk_header_t* next_free_chunk;
+	eecs_id_t num_free_chunks;
+#ifdef EECS_MMAP
+	void* mapping;
+	size_t mapping_size;
+	// Chunks are carved from [region_next, region_end)
+	char* region_begin;
+	char* region_next;
+	char* region_end;
+	// Trimmed chunks of the region, their pages were given back to the OS
+	eecs_array(char*) decommitted_chunks;
+	size_t page_size;
+#endif
+#ifdef EECS_THREADS
+	mtx_t mutex;
+#endif
+};
+
+struct eecs_query_s {
+	eecs_world_t* world;
+	// Position in world->queries
+	eecs_id_t index;
+	eecs_bitset_t* require_bitset;
+	eecs_bitset_t* exclude_bitset;
+	eecs_sparse_filter_t sparse_filter;
+	// Required then optional components
+	eecs_id_t num_components;
+	eecs_component_t* components;
+	eecs_array(eecs_table_t*) matched_tables;
+	// num_components offsets per matched table, -1 for missing components
+	eecs_array(ptrdiff_t) component_storage_offsets;
+	// Same for the enable bits, -1 for components which are not enableable
+	eecs_array(ptrdiff_t) enable_mask_offsets;
+	// Offsets of the last batch narrowed by sparse components
+	ptrdiff_t* run_offsets;
+};
+
+// Entities having a sparse component, with their data in the same order
+typedef struct eecs_sparse_set_s {
+	// Position in entities + 1 by entity slot, 0 when it lacks the component
+	eecs_array(eecs_id_t) positions;
+	// from_1_index of each entity
+	eecs_array(eecs_id_t) entities;
+	// Grown along with the capacity of entities
+	char* data;
+	size_t component_size;
+} eecs_sparse_set_t;
+
+// Forked worlds share chunks and entity directories until they write to them
+typedef struct eecs_shared_block_s {
+#ifdef EECS_THREADS
+	_Atomic(eecs_id_t) num_owners;
+#else
+	eecs_id_t num_owners;
+#endif
+} eecs_shared_block_t;
+
+typedef struct eecs_copied_chunk_s {
+	char* chunk;
+	eecs_shared_block_t* block;
+} eecs_copied_chunk_t;
+
+typedef struct eecs_table_address_s {
+	uintptr_t address;
+	eecs_id_t index;
+} eecs_table_address_t;
+
+typedef struct eecs_shared_entities_s {
+	eecs_shared_block_t share;
+	// Tables of the world which wrote the entries, sorted by address. A table
+	// has the same index in every fork.
+	eecs_id_t num_tables;
+	eecs_table_address_t* tables;
+} eecs_shared_entities_t;
+
 typedef struct eecs_template_data_s {
 	eecs_table_t* table;
 	eecs_component_init_t* init_data;
 } eecs_template_data_t;
 
+// Snapshot layout: the header, each component, each table with its columns
+// and chunks, the entity directory then the non-empty sparse sets.
+// Everything is in native byte order.
+#define EECS_SNAPSHOT_MAGIC "EECSSNAP"
+#define EECS_SNAPSHOT_VERSION 4
+#define EECS_SNAPSHOT_BYTE_ORDER UINT64_C(0x0102030405060708)
+
+typedef struct eecs_snapshot_header_s {
+	char magic[8];
+	uint64_t version;
+	uint64_t byte_order;
+	uint64_t id_size;
+	uint64_t chunk_size;
+	uint64_t num_components;
+	uint64_t num_tables;
+	uint64_t num_entity_slots;
+	uint64_t new_entity_gen;
+	uint64_t num_sparse_sets;
+} eecs_snapshot_header_t;
+
+typedef struct eecs_snapshot_component_s {
+	uint64_t size;
+	uint64_t alignment;
+	uint64_t storage;
+	uint64_t enableable;
+} eecs_snapshot_component_t;
+
+typedef struct eecs_snapshot_table_s {
+	uint64_t num_columns;
+	uint64_t num_entities;
+	uint64_t num_entities_per_chunk;
+	uint64_t num_chunks;
+} eecs_snapshot_table_t;
+
+// enable_mask_offset is -1 for components which are not enableable
+typedef struct eecs_snapshot_column_s {
+	uint64_t component_index;
+	uint64_t storage_offset;
+	uint64_t enable_mask_offset;
+} eecs_snapshot_column_t;
+
+// table_index is -1 for free slots, whose pos_in_table is 0. The free lists
+// are rebuilt on load.
+typedef struct eecs_snapshot_entity_s {
+	eecs_id_t table_index;
+	eecs_id_t gen;
+	eecs_id_t pos_in_table;
+} eecs_snapshot_entity_t;
+
+// Followed by the from_1_index of each member then their components
+typedef struct eecs_snapshot_sparse_set_s {
+	uint64_t component_index;
+	uint64_t num_entities;
+} eecs_snapshot_sparse_set_t;
+
+// Deltas follow the same conventions. Each list ends with a -1 entry.
+#define EECS_DELTA_MAGIC "EECSDLTA"
+#define EECS_DELTA_VERSION 4
+#define EECS_DELTA_END_OF_LIST UINT64_MAX
+
+typedef struct eecs_delta_header_s {
+	char magic[8];
+	uint64_t version;
+	uint64_t byte_order;
+	uint64_t id_size;
+	uint64_t chunk_size;
+	uint64_t num_components;
+	// Tables from first_new_table to num_tables are described after the
+	// header
+	uint64_t first_new_table;
+	uint64_t num_tables;
+	uint64_t num_entity_slots;
+	uint64_t new_entity_gen;
+} eecs_delta_header_t;
+
+// Followed by the column patches of the table
+typedef struct eecs_delta_table_patch_s {
+	uint64_t table_index;
+	uint64_t num_entities;
+	uint64_t num_entities_per_chunk;
+} eecs_delta_table_patch_t;
+
+// Followed by the rows. Column 0 holds the entity ids and column i + 1 the
+// component in position i of the signature. The columns past those hold the
+// enable bits of each enableable column, with a mask per row.
+typedef struct eecs_delta_column_patch_s {
+	uint64_t chunk_index;
+	uint64_t column;
+	uint64_t first_row;
+	uint64_t num_rows;
+} eecs_delta_column_patch_t;
+
+typedef struct eecs_delta_entity_s {
+	eecs_id_t slot_index;
+	eecs_snapshot_entity_t entity;
+} eecs_delta_entity_t;
+
+typedef struct eecs_delta_table_s {
+	eecs_id_t num_entities;
+	// Copies of the chunks as they were sent
+	eecs_array(char*) chunks;
+} eecs_delta_table_t;
+
+// Copy of a sparse set as it was sent
+typedef struct eecs_delta_sparse_set_s {
+	eecs_id_t num_entities;
+	eecs_id_t* entities;
+	char* data;
+} eecs_delta_sparse_set_t;
+
+// A patch of the entity ids of a table. They are checked against the
+// directory before anything is applied.
+typedef struct eecs_delta_id_patch_s {
+	eecs_id_t first_pos;
+	eecs_id_t num_rows;
+	const char* ids;
+} eecs_delta_id_patch_t;
+
+// The state a delta leads to, as far as rows and directory go
+typedef struct eecs_delta_check_s {
+	const eecs_world_t* world;
+	eecs_id_t num_slots;
+	// Row counts of the tables once patched
+	eecs_id_t* table_sizes;
+	// Id patches by table then position
+	eecs_array(eecs_delta_id_patch_t) id_patches;
+	eecs_id_t* first_id_patches;
+	eecs_id_t* num_id_patches;
+	// Directory changes by increasing slot
+	const char* changes;
+	eecs_id_t num_changes;
+} eecs_delta_check_t;
+
+struct eecs_delta_baseline_s {
+	eecs_world_t* world;
+	eecs_array(eecs_delta_table_t) tables;
+	// By component, sparse sets which changed are sent whole after the
+	// directory as an eecs_snapshot_sparse_set_t list
+	eecs_array(eecs_delta_sparse_set_t) sparse_sets;
+	// Copy of the directory, compared in blocks with the world's
+	eecs_array(eecs_entity_data_t) entities;
+	eecs_id_t new_entity_gen;
+};
+
+typedef struct eecs_snapshot_reader_s {
+	const char* data;
+	size_t size;
+	size_t pos;
+} eecs_snapshot_reader_t;
+
 struct eecs_s {
 	eecs_options_t options;
 	eecs_id_t version;
 	eecs_array(eecs_component_options_t) components;
 	eecs_array(eecs_system_options_t) systems;
+	// Version of the last registration of each component and system
+	eecs_array(eecs_id_t) component_versions;
+	eecs_array(eecs_id_t) system_versions;
 };
 
 struct eecs_world_s {
@@ -628,14 +1593,41 @@ struct eecs_world_s {
 	eecs_table_t* current_update_table;
 
 	eecs_array(eecs_system_data_t) system_data;
-
-	eecs_id_t next_free_entity_slot;
-	eecs_array(eecs_entity_data_t) entities;
+	// Systems re-registered since version_arena was reset, their previous
+	// data is still in it
+	eecs_id_t num_stale_systems;
+
+	// Index + 1 of the first page with free slots. Slots are reused from one
+	// page until it is full so that new entities are close in the directory.
+	eecs_id_t next_free_entity_page;
+	// Set when free slots were written without being linked, the lists are
+	// then rebuilt before the next reuse
+	bool relink_free_entity_slots;
+	eecs_array(eecs_entity_page_t*) entity_pages;
+	eecs_id_t num_entity_slots;
+	// Set while the directory is shared with forks. When rebase_entities is
+	// set, the entries point to the tables of another world and they are
+	// rebased onto this world's tables before the first lookup.
+	struct eecs_shared_entities_s* shared_entities;
+	bool rebase_entities;
+	// Generation of new slots, raised when trailing slots are trimmed so that
+	// stale handles to them stay invalid
+	eecs_id_t new_entity_gen;
 
 	eecs_array(eecs_template_data_t) templates;
+	eecs_array(eecs_query_t*) queries;
+
+	// Indexed by component, only the sets of sparse components are used
+	eecs_array(eecs_sparse_set_t) sparse_sets;
+	// Indices of the sparse components, entities only need to be looked up in
+	// sparse sets when it is not empty
+	eecs_array(eecs_id_t) sparse_components;
 
 	// Store pointer so that table's address is stable
 	eecs_array(eecs_table_t*) tables;
+	// Open addressing index into tables, keyed on signature hash
+	eecs_table_t** table_index;
+	eecs_id_t table_index_capacity;
 
 	eecs_deferred_op_t* first_deferred_ops;
 	eecs_deferred_op_t* last_deferred_ops;
@@ -644,32 +1636,418 @@ struct eecs_world_s {
 	eecs_arena_t deferred_arena;
 	eecs_arena_t tmp_arena;
 
+	// Stamped on structural changes, advanced by every system run
+	uint64_t change_tick;
+
 	eecs_table_chunk_header_t* next_free_table_chunks;
+	size_t chunk_alignment;
+	// Shared chunks replaced by a copy during an update. Batches of the update
+	// may still point to them so they are released once it ends.
+	eecs_array(eecs_copied_chunk_t) copied_chunks;
+
+	// The first worker is the calling thread
+	eecs_id_t num_workers;
+	eecs_worker_t* workers;
+	bool parallel_update;
+	// Set while running systems with no_structural_changes
+	bool structure_locked;
+	eecs_id_t bulk_depth;
+	eecs_array(eecs_parallel_task_t) parallel_tasks;
+	eecs_array(eecs_schedule_t) schedules;
+#ifdef EECS_THREADS
+	mtx_t chunk_mutex;
+	mtx_t pool_mutex;
+	cnd_t pool_start_cnd;
+	cnd_t pool_done_cnd;
+	eecs_id_t pool_generation;
+	eecs_id_t num_busy_workers;
+	bool pool_shutdown;
+	bool pool_started;
+#endif
+#ifdef EECS_STATS
+	eecs_world_stats_t stats;
+#endif
 };
 
+#ifdef EECS_THREADS
+static _Thread_local eecs_worker_t* eecs_thread_worker = NULL;
+#endif
+
+#ifdef EECS_DEFAULT_STATS_CLOCK
+EECS_PRIVATE uint64_t
+eecs_default_stats_clock(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+EECS_PRIVATE uint64_t
+eecs_stats_now(void) {
+#ifdef EECS_STATS
+	return EECS_STATS_CLOCK();
+#else
+	return 0;
+#endif
+}
+
 EECS_PRIVATE uintptr_t
 eecs_align_ptr(uintptr_t ptr, size_t alignment) {
 	return ((uintptr_t)ptr + (uintptr_t)(alignment - 1)) & -(uintptr_t)alignment;
 }
 
-EECS_PRIVATE void*
-eecs_allocate_chunk(eecs_world_t* world) {
-	if (world->next_free_table_chunks) {
-		eecs_table_chunk_header_t* header = world->next_free_table_chunks;
-		world->next_free_table_chunks = header->next;
-		return header;
-	}
-
-	return eecs_malloc(
-		world->options.table_chunk_memctx, world->options.table_chunk_size
-	);
-}
+EECS_PRIVATE void
+eecs_lock_chunks(eecs_world_t* world) {
+#ifdef EECS_THREADS
+	// Worker threads only allocate for their deferred arenas
+	if (world->parallel_update) { mtx_lock(&world->chunk_mutex); }
+#else
+	(void)world;
+#endif
+}
+
+EECS_PRIVATE void
+eecs_unlock_chunks(eecs_world_t* world) {
+#ifdef EECS_THREADS
+	if (world->parallel_update) { mtx_unlock(&world->chunk_mutex); }
+#else
+	(void)world;
+#endif
+}
+
+#ifdef EECS_MMAP
+EECS_PRIVATE bool
+eecs_is_reserved_chunk(const eecs_chunk_pool_t* pool, const void* chunk) {
+	return pool->region_begin <= (const char*)chunk && (const char*)chunk < pool->region_end;
+}
+#endif
+
+// Reserved address space is used before the allocator
+EECS_PRIVATE void*
+eecs_carve_pooled_chunk(eecs_chunk_pool_t* pool) {
+#ifdef EECS_MMAP
+	if (eecs_array_length(pool->decommitted_chunks) > 0) {
+		return eecs_array_pop(pool->decommitted_chunks);
+	} else if (pool->region_next < pool->region_end) {
+		char* chunk = pool->region_next;
+		pool->region_next += pool->options.chunk_size;
+		return chunk;
+	}
+#else
+	(void)pool;
+#endif
+	return NULL;
+}
+
+EECS_PRIVATE void*
+eecs_take_pooled_chunk(eecs_chunk_pool_t* pool) {
+#ifdef EECS_THREADS
+	mtx_lock(&pool->mutex);
+#endif
+	eecs_table_chunk_header_t* header = pool->next_free_chunk;
+	if (header != NULL) {
+		pool->next_free_chunk = header->next;
+		--pool->num_free_chunks;
+	} else {
+		header = eecs_carve_pooled_chunk(pool);
+	}
+#ifdef EECS_THREADS
+	mtx_unlock(&pool->mutex);
+#endif
+	return header;
+}
+
+// Give a list of chunks back to the pool, trimming it to the low watermark
+// when it goes above the high one
+EECS_PRIVATE void
+eecs_return_pooled_chunks(
+	eecs_chunk_pool_t* pool,
+	eecs_table_chunk_header_t* first,
+	eecs_table_chunk_header_t* last,
+	eecs_id_t count
+) {
+	eecs_table_chunk_header_t* surplus = NULL;
+#ifdef EECS_THREADS
+	mtx_lock(&pool->mutex);
+#endif
+	last->next = pool->next_free_chunk;
+	pool->next_free_chunk = first;
+	pool->num_free_chunks += count;
+
+	eecs_id_t high_watermark = pool->options.high_watermark;
+	eecs_id_t low_watermark = eecs_min(pool->options.low_watermark, high_watermark);
+	if (high_watermark > 0 && pool->num_free_chunks > high_watermark) {
+		eecs_table_chunk_header_t** link = &pool->next_free_chunk;
+		for (eecs_id_t i = 0; i < low_watermark; ++i) {
+			link = &(*link)->next;
+		}
+		surplus = *link;
+		*link = NULL;
+		pool->num_free_chunks = low_watermark;
+	}
+
+#ifdef EECS_MMAP
+	// Only the allocated chunks are left to free, the pages of the others
+	// are released but the chunks stay reserved for reuse
+	eecs_table_chunk_header_t** surplus_link = &surplus;
+	while (*surplus_link != NULL) {
+		char* chunk = (char*)*surplus_link;
+		if (eecs_is_reserved_chunk(pool, chunk)) {
+			*surplus_link = (*surplus_link)->next;
+			// The kernel rounds up to whole pages so pages shared with a
+			// neighbouring chunk must be kept
+			uintptr_t pages_begin = eecs_align_ptr((uintptr_t)chunk, pool->page_size);
+			uintptr_t pages_end = ((uintptr_t)chunk + pool->options.chunk_size) / pool->page_size * pool->page_size;
+			if (pages_end > pages_begin) {
+				madvise((void*)pages_begin, pages_end - pages_begin, MADV_DONTNEED);
+			}
+			eecs_array_push(pool->options.memctx, pool->decommitted_chunks, chunk);
+		} else {
+			surplus_link = &(*surplus_link)->next;
+		}
+	}
+#endif
+#ifdef EECS_THREADS
+	mtx_unlock(&pool->mutex);
+#endif
+
+	// Free outside of the lock
+	for (eecs_table_chunk_header_t* itr = surplus; itr != NULL;) {
+		eecs_table_chunk_header_t* next = itr->next;
+		eecs_free(pool->options.memctx, itr);
+		itr = next;
+	}
+}
+
+// Release a list of chunks to the shared pool or to the allocator
+EECS_PRIVATE void
+eecs_free_chunks(eecs_world_t* world, eecs_table_chunk_header_t* first) {
+	if (first == NULL) { return; }
+
+	if (world->options.chunk_pool != NULL) {
+		eecs_id_t count = 1;
+		eecs_table_chunk_header_t* last = first;
+		for (; last->next != NULL; last = last->next) { ++count; }
+		eecs_return_pooled_chunks(world->options.chunk_pool, first, last, count);
+	} else {
+		for (eecs_table_chunk_header_t* itr = first; itr != NULL;) {
+			eecs_table_chunk_header_t* next = itr->next;
+			eecs_free(world->options.table_chunk_memctx, itr);
+			itr = next;
+		}
+	}
+}
+
+EECS_PRIVATE void*
+eecs_allocate_chunk(eecs_world_t* world) {
+	eecs_lock_chunks(world);
+	eecs_table_chunk_header_t* header = world->next_free_table_chunks;
+	if (header != NULL) {
+		world->next_free_table_chunks = header->next;
+	} else if (world->options.chunk_pool != NULL) {
+		header = eecs_take_pooled_chunk(world->options.chunk_pool);
+	}
+	if (header != NULL) {
+		eecs_stat_add(world->stats, num_chunks_reused, 1);
+	} else {
+		eecs_stat_add(world->stats, num_chunks_allocated, 1);
+	}
+	eecs_unlock_chunks(world);
+
+	if (header != NULL) { return header; }
+
+	return eecs_malloc_aligned(
+		world->options.table_chunk_memctx,
+		world->chunk_alignment,
+		world->options.table_chunk_size
+	);
+}
 
 EECS_PRIVATE void
 eecs_release_chunk(eecs_world_t* world, void* chunk) {
 	eecs_table_chunk_header_t* header = chunk;
+	eecs_lock_chunks(world);
 	header->next = world->next_free_table_chunks;
 	world->next_free_table_chunks = header;
+	eecs_unlock_chunks(world);
+}
+
+// Forks sharing a block may be on different threads
+EECS_PRIVATE void
+eecs_add_block_owner(eecs_shared_block_t* block) {
+#ifdef EECS_THREADS
+	atomic_fetch_add_explicit(&block->num_owners, 1, memory_order_relaxed);
+#else
+	++block->num_owners;
+#endif
+}
+
+// Returns whether the caller was the last owner, who then sees every read
+// the others made before letting go
+EECS_PRIVATE bool
+eecs_remove_block_owner(eecs_shared_block_t* block) {
+#ifdef EECS_THREADS
+	return atomic_fetch_sub_explicit(&block->num_owners, 1, memory_order_acq_rel) == 1;
+#else
+	return --block->num_owners == 0;
+#endif
+}
+
+EECS_PRIVATE bool
+eecs_is_block_shared(eecs_shared_block_t* block) {
+#ifdef EECS_THREADS
+	return atomic_load_explicit(&block->num_owners, memory_order_acquire) > 1;
+#else
+	return block->num_owners > 1;
+#endif
+}
+
+EECS_PRIVATE eecs_shared_block_t*
+eecs_share_block(eecs_world_t* world, eecs_shared_block_t* block) {
+	if (block == NULL) {
+		block = eecs_malloc(world->options.memctx, sizeof(eecs_shared_block_t));
+		block->num_owners = 2;
+	} else {
+		eecs_add_block_owner(block);
+	}
+	return block;
+}
+
+// Returns whether the caller was the last owner
+EECS_PRIVATE bool
+eecs_release_shared_block(eecs_world_t* world, eecs_shared_block_t* block) {
+	if (!eecs_remove_block_owner(block)) { return false; }
+
+	eecs_free(world->options.memctx, block);
+	return true;
+}
+
+EECS_PRIVATE void
+eecs_release_table_chunk(eecs_world_t* world, char* chunk, eecs_shared_block_t* block) {
+	if (block == NULL || eecs_release_shared_block(world, block)) {
+		eecs_release_chunk(world, chunk);
+	}
+}
+
+EECS_PRIVATE char*
+eecs_copy_shared_chunk(eecs_world_t* world, eecs_table_t* table, eecs_id_t chunk_index) {
+	// Once the other worlds let go, the chunk is taken over as is. The count
+	// of owners only goes up from this world.
+	eecs_lock_chunks(world);
+	char* chunk = table->chunks[chunk_index];
+	eecs_shared_block_t* block = table->shared_chunks[chunk_index];
+	bool taken_over = block != NULL && !eecs_is_block_shared(block);
+	if (taken_over) { table->shared_chunks[chunk_index] = NULL; }
+	eecs_unlock_chunks(world);
+
+	if (block == NULL) { return chunk; }
+	if (taken_over) {
+		eecs_free(world->options.memctx, block);
+		return chunk;
+	}
+
+	// Workers may race to write the same chunk through entity handles
+	char* copy = eecs_allocate_chunk(world);
+	eecs_lock_chunks(world);
+	chunk = table->chunks[chunk_index];
+	block = table->shared_chunks[chunk_index];
+	bool copied = block != NULL;
+	bool deferred = copied && (world->parallel_update || world->current_update_table != NULL);
+	if (copied) {
+		memcpy(copy, chunk, world->options.table_chunk_size);
+		table->chunks[chunk_index] = copy;
+		table->shared_chunks[chunk_index] = NULL;
+		eecs_stat_add(world->stats, num_chunks_copied, 1);
+	}
+	if (deferred) {
+		eecs_array_push(world->options.memctx, world->copied_chunks, ((eecs_copied_chunk_t){
+			.chunk = chunk,
+			.block = block,
+		}));
+	}
+	eecs_unlock_chunks(world);
+
+	if (!copied) {
+		eecs_release_chunk(world, copy);
+		return chunk;
+	}
+
+	if (!deferred) { eecs_release_table_chunk(world, chunk, block); }
+	return copy;
+}
+
+// Once no batch of the update can point to them
+EECS_PRIVATE void
+eecs_release_copied_chunks(eecs_world_t* world) {
+	eecs_array_indexed_foreach(eecs_copied_chunk_t, itr, world->copied_chunks) {
+		eecs_release_table_chunk(world, itr.value->chunk, itr.value->block);
+	}
+	eecs_array_clear(world->copied_chunks);
+}
+
+// Must be called before writing to a chunk, returns the chunk
+EECS_PRIVATE char*
+eecs_own_chunk(eecs_world_t* world, eecs_table_t* table, eecs_id_t chunk_index) {
+	if (table->shared_chunks == NULL || table->shared_chunks[chunk_index] == NULL) {
+		return table->chunks[chunk_index];
+	}
+
+	return eecs_copy_shared_chunk(world, table, chunk_index);
+}
+
+EECS_PRIVATE void
+eecs_own_rows(eecs_world_t* world, eecs_table_t* table, eecs_id_t first_pos, eecs_id_t num_rows) {
+	if (table->shared_chunks == NULL || num_rows <= 0) { return; }
+
+	eecs_id_t last_chunk_index = (first_pos + num_rows - 1) / table->num_entities_per_chunk;
+	for (eecs_id_t i = first_pos / table->num_entities_per_chunk; i <= last_chunk_index; ++i) {
+		eecs_own_chunk(world, table, i);
+	}
+}
+
+EECS_PRIVATE char*
+eecs_push_table_chunk(eecs_world_t* world, eecs_table_t* table) {
+	void* memctx = world->options.memctx;
+	char* chunk = eecs_allocate_chunk(world);
+	eecs_array_push(memctx, table->chunks, chunk);
+	if (table->shared_chunks != NULL) {
+		eecs_array_push(memctx, table->shared_chunks, NULL);
+	}
+	for (eecs_id_t i = 0; i < table->signature.length; ++i) {
+		eecs_array_push(memctx, table->change_ticks, world->change_tick);
+	}
+	return chunk;
+}
+
+EECS_PRIVATE void
+eecs_pop_table_chunk(eecs_world_t* world, eecs_table_t* table) {
+	eecs_shared_block_t* block = table->shared_chunks != NULL
+		? eecs_array_pop(table->shared_chunks)
+		: NULL;
+	eecs_release_table_chunk(world, eecs_array_pop(table->chunks), block);
+	eecs_array_resize(
+		world->options.memctx,
+		table->change_ticks,
+		eecs_array_length(table->chunks) * table->signature.length
+	);
+}
+
+// Stamp every column of the chunks holding the given rows
+EECS_PRIVATE void
+eecs_mark_rows_changed(
+	eecs_world_t* world,
+	eecs_table_t* table,
+	eecs_id_t first_pos,
+	eecs_id_t num_rows
+) {
+	if (num_rows <= 0) { return; }
+
+	eecs_id_t num_columns = table->signature.length;
+	eecs_id_t first_chunk = first_pos / table->num_entities_per_chunk;
+	eecs_id_t last_chunk = (first_pos + num_rows - 1) / table->num_entities_per_chunk;
+	for (eecs_id_t i = first_chunk * num_columns; i < (last_chunk + 1) * num_columns; ++i) {
+		table->change_ticks[i] = world->change_tick;
+	}
 }
 
 EECS_PRIVATE void*
@@ -759,6 +2137,14 @@ eecs_component_init_list_length(const eecs_component_init_t* list) {
 	return i;
 }
 
+EECS_PRIVATE bool
+eecs_has_per_entity_init(const eecs_component_init_t* list) {
+	for (eecs_id_t i = 0; list != NULL && list[i].component.from_1_index != 0; ++i) {
+		if (list[i].per_entity) { return true; }
+	}
+	return false;
+}
+
 EECS_PRIVATE bool
 eecs_table_matches_system(
 	const eecs_table_t* table,
@@ -768,6 +2154,169 @@ eecs_table_matches_system(
 		&& !eecs_bitset_is_any_set(table->bitset, system_data->exclude_bitset);
 }
 
+// -1 when the table does not have the component
+EECS_PRIVATE eecs_id_t
+eecs_find_column(const eecs_table_t* table, eecs_component_t component) {
+	eecs_id_t component_index = eecs_index_of(component);
+	return 0 <= component_index && component_index < table->num_component_columns
+		? table->component_columns[component_index]
+		: -1;
+}
+
+EECS_PRIVATE char*
+eecs_get_column_address(const eecs_table_t* table, eecs_id_t column, eecs_id_t pos_in_table) {
+	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
+	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
+	return table->chunks[chunk_index]
+		+ table->component_storage_offsets[column]
+		+ pos_in_chunk * table->component_sizes[column];
+}
+
+// -1 when the table does not have the component
+EECS_PRIVATE ptrdiff_t
+eecs_find_component_offset(const eecs_table_t* table, eecs_component_t component) {
+	eecs_id_t column = eecs_find_column(table, component);
+	return column >= 0 ? table->component_storage_offsets[column] : -1;
+}
+
+// -1 when the table does not have the component or it is not enableable
+EECS_PRIVATE ptrdiff_t
+eecs_find_enable_mask_offset(const eecs_table_t* table, eecs_component_t component) {
+	eecs_id_t column = eecs_find_column(table, component);
+	return column >= 0 ? table->enable_mask_offsets[column] : -1;
+}
+
+EECS_PRIVATE eecs_mask_t*
+eecs_get_enable_masks(const eecs_table_t* table, eecs_id_t column, eecs_id_t chunk_index) {
+	return (eecs_mask_t*)(table->chunks[chunk_index] + table->enable_mask_offsets[column]);
+}
+
+EECS_PRIVATE bool
+eecs_is_row_enabled(const eecs_table_t* table, eecs_id_t column, eecs_id_t pos_in_table) {
+	eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+	return eecs_is_mask_bit_set(
+		eecs_get_enable_masks(table, column, pos_in_table / num_entities_per_chunk),
+		pos_in_table % num_entities_per_chunk
+	);
+}
+
+// The chunk must be owned
+EECS_PRIVATE void
+eecs_set_rows_enabled(
+	const eecs_table_t* table,
+	eecs_id_t column,
+	eecs_id_t first_pos,
+	eecs_id_t num_rows,
+	bool enabled
+) {
+	eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+	for (eecs_id_t pos = first_pos; pos < first_pos + num_rows; ++pos) {
+		eecs_set_mask_bit(
+			eecs_get_enable_masks(table, column, pos / num_entities_per_chunk),
+			pos % num_entities_per_chunk,
+			enabled
+		);
+	}
+}
+
+// Rows are copied one bit at a time as they rarely start on a mask boundary
+EECS_PRIVATE void
+eecs_copy_enable_bits(
+	const eecs_table_t* dst_table,
+	eecs_id_t dst_column,
+	eecs_id_t dst_pos,
+	const eecs_table_t* src_table,
+	eecs_id_t src_column,
+	eecs_id_t src_pos,
+	eecs_id_t num_rows
+) {
+	for (eecs_id_t i = 0; i < num_rows; ++i) {
+		eecs_set_rows_enabled(
+			dst_table, dst_column, dst_pos + i, 1,
+			eecs_is_row_enabled(src_table, src_column, src_pos + i)
+		);
+	}
+}
+
+EECS_PRIVATE void
+eecs_try_match_query_with_table(eecs_query_t* query, eecs_table_t* table) {
+	if (
+		!eecs_bitset_is_all_set(table->bitset, query->require_bitset)
+		|| eecs_bitset_is_any_set(table->bitset, query->exclude_bitset)
+	) {
+		return;
+	}
+
+	void* memctx = query->world->options.memctx;
+	eecs_array_push(memctx, query->matched_tables, table);
+	for (eecs_id_t i = 0; i < query->num_components; ++i) {
+		ptrdiff_t offset = eecs_find_component_offset(table, query->components[i]);
+		eecs_array_push(memctx, query->component_storage_offsets, offset);
+		ptrdiff_t enable_mask_offset = eecs_find_enable_mask_offset(table, query->components[i]);
+		eecs_array_push(memctx, query->enable_mask_offsets, enable_mask_offset);
+	}
+}
+
+EECS_PRIVATE eecs_id_t*
+eecs_collect_columns(
+	eecs_world_t* world,
+	const eecs_table_t* table,
+	const eecs_bitset_t* components,
+	eecs_id_t* num_columns_out
+) {
+	eecs_id_t* columns = eecs_arena_alloc(
+		world,
+		&world->version_arena,
+		sizeof(eecs_id_t) * eecs_max(table->signature.length, 1),
+		_Alignof(eecs_id_t)
+	);
+
+	eecs_id_t num_columns = 0;
+	for (eecs_id_t i = 0; i < table->signature.length; ++i) {
+		if (eecs_bitset_is_set(components, eecs_index_of(table->signature.components[i]))) {
+			columns[num_columns++] = i;
+		}
+	}
+
+	*num_columns_out = num_columns;
+	return columns;
+}
+
+// Callbacks are kept in system order, as a full resync would record them
+EECS_PRIVATE eecs_system_entity_callback_t*
+eecs_insert_system_callback(
+	void* memctx,
+	eecs_system_entity_callback_t* callbacks,
+	eecs_system_entity_callback_t callback
+) {
+	eecs_array_push(memctx, callbacks, callback);
+	for (
+		eecs_id_t i = eecs_array_length(callbacks) - 1;
+		i > 0 && callbacks[i - 1].system_index > callback.system_index;
+		--i
+	) {
+		callbacks[i] = callbacks[i - 1];
+		callbacks[i - 1] = callback;
+	}
+	return callbacks;
+}
+
+EECS_PRIVATE void
+eecs_remove_system_callbacks(
+	eecs_system_entity_callback_t* callbacks,
+	eecs_id_t system_index
+) {
+	eecs_id_t num_kept = 0;
+	eecs_array_indexed_foreach(eecs_system_entity_callback_t, itr, callbacks) {
+		if (itr.value->system_index != system_index) {
+			callbacks[num_kept++] = *itr.value;
+		}
+	}
+	if (callbacks != NULL) {
+		eecs_dynamic_array_header(callbacks)->length = num_kept;
+	}
+}
+
 EECS_PRIVATE void
 eecs_try_match_system_with_table(
 	eecs_world_t* world,
@@ -781,49 +2330,162 @@ eecs_try_match_system_with_table(
 		return;
 	}
 
-	eecs_signature_t signature = table->signature;
 	eecs_id_t num_requirements = eecs_component_list_length(system_options->require_components);
+	eecs_id_t num_optionals = eecs_component_list_length(system_options->optional_components);
 
 	void* memctx = world->options.memctx;
 	if (system_options->init_per_entity_fn) {
-		eecs_array_push(memctx, table->system_init_callbacks, ((eecs_system_entity_callback_t) {
-			.system_index = system_index,
-			.fn = system_options->init_per_entity_fn,
-			.userdata = system_options->userdata,
-		}));
+		table->system_init_callbacks = eecs_insert_system_callback(
+			memctx,
+			table->system_init_callbacks,
+			(eecs_system_entity_callback_t){
+				.system_index = system_index,
+				.fn = system_options->init_per_entity_fn,
+				.userdata = system_options->userdata,
+			}
+		);
 	}
 
 	if (system_options->cleanup_per_entity_fn) {
-		eecs_array_push(memctx, table->system_cleanup_callbacks, ((eecs_system_entity_callback_t) {
-			.system_index = system_index,
-			.fn = system_options->cleanup_per_entity_fn,
-			.userdata = system_options->userdata,
-		}));
+		table->system_cleanup_callbacks = eecs_insert_system_callback(
+			memctx,
+			table->system_cleanup_callbacks,
+			(eecs_system_entity_callback_t){
+				.system_index = system_index,
+				.fn = system_options->cleanup_per_entity_fn,
+				.userdata = system_options->userdata,
+			}
+		);
 	}
 
 	if (system_options->update_fn) {
 		eecs_array_push(memctx, system_data->matched_tables, (eecs_system_table_match_t){ 0 });
 		eecs_system_table_match_t* match = &eecs_array_back(system_data->matched_tables);
 		match->table = table;
-		if (num_requirements > 0) {
+		if (num_requirements + num_optionals > 0) {
 			match->component_storage_offsets = eecs_arena_alloc(
 				world,
 				&world->version_arena,
-				sizeof(ptrdiff_t) * num_requirements,
+				sizeof(ptrdiff_t) * (num_requirements + num_optionals),
 				_Alignof(ptrdiff_t)
 			);
 		}
 
 		for (eecs_id_t i = 0; i < num_requirements; ++i) {
-			eecs_component_t requirement = system_options->require_components[i];
+			match->component_storage_offsets[i] = eecs_find_component_offset(
+				table, system_options->require_components[i]
+			);
+		}
+		for (eecs_id_t i = 0; i < num_optionals; ++i) {
+			match->component_storage_offsets[num_requirements + i] = eecs_find_component_offset(
+				table, system_options->optional_components[i]
+			);
+		}
 
-			for (eecs_id_t j = 0; j < signature.length; ++j) {
-				if (signature.components[j].from_1_index == requirement.from_1_index) {
-					match->component_storage_offsets[i] = table->component_storage_offsets[j];
-					break;
+		if (table->num_enableable_columns > 0 && num_requirements + num_optionals > 0) {
+			match->enable_mask_offsets = eecs_arena_alloc(
+				world,
+				&world->version_arena,
+				sizeof(ptrdiff_t) * (num_requirements + num_optionals),
+				_Alignof(ptrdiff_t)
+			);
+			match->enabled_columns = eecs_arena_alloc(
+				world,
+				&world->version_arena,
+				sizeof(eecs_id_t) * num_requirements,
+				_Alignof(eecs_id_t)
+			);
+			for (eecs_id_t i = 0; i < num_requirements; ++i) {
+				eecs_component_t component = system_options->require_components[i];
+				eecs_id_t column = eecs_find_column(table, component);
+				match->enable_mask_offsets[i] = eecs_find_enable_mask_offset(table, component);
+				if (system_options->skip_disabled_chunks && match->enable_mask_offsets[i] >= 0) {
+					match->enabled_columns[match->num_enabled_columns++] = column;
 				}
 			}
+			for (eecs_id_t i = 0; i < num_optionals; ++i) {
+				match->enable_mask_offsets[num_requirements + i] = eecs_find_enable_mask_offset(
+					table, system_options->optional_components[i]
+				);
+			}
 		}
+
+		// Undeclared accesses are assumed to write every component in the batch
+		const eecs_bitset_t* write_bitset = system_data->write_bitset != NULL
+			? system_data->write_bitset
+			: system_data->batch_bitset;
+		match->write_columns = eecs_collect_columns(
+			world, table, write_bitset, &match->num_write_columns
+		);
+		if (system_data->changed_bitset != NULL) {
+			match->changed_columns = eecs_collect_columns(
+				world, table, system_data->changed_bitset, &match->num_changed_columns
+			);
+		}
+	}
+}
+
+EECS_PRIVATE void
+eecs_copy_system_callbacks(
+	void* memctx,
+	eecs_array(eecs_system_entity_callback_t)* callbacks_out,
+	eecs_array(eecs_system_entity_callback_t) callbacks
+) {
+	eecs_id_t num_callbacks = eecs_array_length(callbacks);
+	if (num_callbacks == 0) { return; }
+
+	eecs_array_resize(memctx, *callbacks_out, num_callbacks);
+	memcpy(*callbacks_out, callbacks, sizeof(eecs_system_entity_callback_t) * num_callbacks);
+}
+
+EECS_PRIVATE void*
+eecs_arena_copy(eecs_world_t* world, const void* data, size_t size, size_t alignment) {
+	if (data == NULL) { return NULL; }
+
+	void* copy = eecs_arena_alloc(world, &world->version_arena, eecs_max(size, (size_t)1), alignment);
+	memcpy(copy, data, size);
+	return copy;
+}
+
+// A match only depends on the layout of its table so a fork clones the ones
+// of the world it was forked from instead of matching every table again
+EECS_PRIVATE void
+eecs_clone_system_matches(eecs_world_t* fork, const eecs_world_t* world, eecs_id_t system_index) {
+	const eecs_system_options_t* system_options = &world->ecs->systems[system_index];
+	eecs_system_data_t* fork_data = &fork->system_data[system_index];
+	eecs_id_t num_requirements = eecs_component_list_length(system_options->require_components);
+	eecs_id_t num_optionals = eecs_component_list_length(system_options->optional_components);
+	size_t num_offsets = (size_t)(num_requirements + num_optionals);
+
+	void* memctx = fork->options.memctx;
+	eecs_array_indexed_foreach(eecs_system_table_match_t, itr, world->system_data[system_index].matched_tables) {
+		const eecs_system_table_match_t* match = itr.value;
+		eecs_array_push(memctx, fork_data->matched_tables, ((eecs_system_table_match_t){
+			.table = fork->tables[match->table->index],
+			.component_storage_offsets = eecs_arena_copy(
+				fork, match->component_storage_offsets,
+				sizeof(ptrdiff_t) * num_offsets, _Alignof(ptrdiff_t)
+			),
+			.enable_mask_offsets = eecs_arena_copy(
+				fork, match->enable_mask_offsets,
+				sizeof(ptrdiff_t) * num_offsets, _Alignof(ptrdiff_t)
+			),
+			.num_enabled_columns = match->num_enabled_columns,
+			.enabled_columns = eecs_arena_copy(
+				fork, match->enabled_columns,
+				sizeof(eecs_id_t) * (size_t)num_requirements, _Alignof(eecs_id_t)
+			),
+			.num_write_columns = match->num_write_columns,
+			.write_columns = eecs_arena_copy(
+				fork, match->write_columns,
+				sizeof(eecs_id_t) * (size_t)match->num_write_columns, _Alignof(eecs_id_t)
+			),
+			.num_changed_columns = match->num_changed_columns,
+			.changed_columns = eecs_arena_copy(
+				fork, match->changed_columns,
+				sizeof(eecs_id_t) * (size_t)match->num_changed_columns, _Alignof(eecs_id_t)
+			),
+		}));
 	}
 }
 
@@ -855,7 +2517,7 @@ eecs_record_component_callbacks(
 		if (component_options->cleanup_fn) {
 			eecs_array_push(
 				memctx,
-				table->component_init_callbacks,
+				table->component_cleanup_callbacks,
 				((eecs_component_entity_callback_t){
 					.component_index = component_index,
 					.signature_index = i,
@@ -867,20 +2529,212 @@ eecs_record_component_callbacks(
 	}
 }
 
-EECS_PRIVATE void
-eecs_sync_world(eecs_world_t* world) {
-	const eecs_t* ecs = world->ecs;
+EECS_PRIVATE eecs_bitset_t*
+eecs_make_component_bitset(
+	eecs_world_t* world,
+	eecs_arena_t* arena,
+	const eecs_component_t* components
+) {
+	eecs_id_t num_available_components = eecs_array_length(world->ecs->components);
+	eecs_bitset_t* bitset = eecs_arena_alloc(
+		world, arena,
+		eecs_bitset_memory_size(num_available_components),
+		_Alignof(eecs_bitset_t)
+	);
+	eecs_bitset_init(bitset, num_available_components);
 
-	if (world->version != ecs->version) {
-		world->version = ecs->version;
+	for (eecs_id_t i = 0; components != NULL && components[i].from_1_index != 0; ++i) {
+		eecs_bitset_set(bitset, eecs_index_of(components[i]));
+	}
 
-		void* memctx = world->options.memctx;
+	return bitset;
+}
 
-		eecs_id_t old_num_systems = eecs_array_length(world->system_data);
-		eecs_id_t new_num_systems = eecs_array_length(ecs->systems);
-		eecs_array_resize(memctx, world->system_data, new_num_systems);
+EECS_PRIVATE void
+eecs_clear_schedules(eecs_world_t* world) {
+	void* memctx = world->options.memctx;
+	eecs_array_indexed_foreach(eecs_schedule_t, itr, world->schedules) {
+		eecs_array_free(memctx, itr.value->systems);
+		eecs_array_free(memctx, itr.value->stage_ends);
+	}
+	eecs_array_clear(world->schedules);
+}
 
+EECS_PRIVATE bool
+eecs_is_sparse_component(const eecs_t* ecs, eecs_component_t component) {
+	eecs_id_t component_index = eecs_index_of(component);
+	return 0 <= component_index && component_index < eecs_array_length(ecs->components)
+		&& ecs->components[component_index].storage == EECS_STORAGE_SPARSE;
+}
+
+// Move the sparse components out of the require and exclude bitsets into a
+// filter. Its arrays come from arena or from the heap when it is NULL.
+EECS_PRIVATE eecs_sparse_filter_t
+eecs_make_sparse_filter(
+	eecs_world_t* world,
+	eecs_arena_t* arena,
+	const eecs_component_t* require_components,
+	const eecs_component_t* exclude_components,
+	const eecs_component_t* optional_components,
+	eecs_bitset_t* require_bitset,
+	eecs_bitset_t* exclude_bitset
+) {
+	eecs_sparse_filter_t filter = { 0 };
+	if (eecs_array_length(world->sparse_components) == 0) { return filter; }
+
+	const eecs_t* ecs = world->ecs;
+	eecs_id_t num_required = eecs_component_list_length(require_components);
+	eecs_id_t num_excluded = eecs_component_list_length(exclude_components);
+	eecs_id_t num_optional = eecs_component_list_length(optional_components);
+	for (eecs_id_t i = 0; i < num_required; ++i) {
+		filter.num_required += eecs_is_sparse_component(ecs, require_components[i]);
+	}
+	for (eecs_id_t i = 0; i < num_excluded; ++i) {
+		filter.num_excluded += eecs_is_sparse_component(ecs, exclude_components[i]);
+	}
+	if (filter.num_required + filter.num_excluded == 0) { return filter; }
+
+	size_t components_size = sizeof(eecs_id_t) * (size_t)(filter.num_required + filter.num_excluded);
+	size_t sizes_size = sizeof(size_t) * (size_t)eecs_max(num_required + num_optional, 1);
+	if (arena != NULL) {
+		filter.components = eecs_arena_alloc(world, arena, components_size, _Alignof(eecs_id_t));
+		filter.batch_component_sizes = eecs_arena_alloc(world, arena, sizes_size, _Alignof(size_t));
+	} else {
+		filter.components = eecs_malloc(world->options.memctx, components_size);
+		filter.batch_component_sizes = eecs_malloc(world->options.memctx, sizes_size);
+	}
+
+	eecs_id_t num_components = 0;
+	for (eecs_id_t i = 0; i < num_required; ++i) {
+		if (eecs_is_sparse_component(ecs, require_components[i])) {
+			filter.components[num_components++] = eecs_index_of(require_components[i]);
+			eecs_bitset_clear(require_bitset, eecs_index_of(require_components[i]));
+		}
+	}
+	for (eecs_id_t i = 0; i < num_excluded; ++i) {
+		if (eecs_is_sparse_component(ecs, exclude_components[i])) {
+			filter.components[num_components++] = eecs_index_of(exclude_components[i]);
+			eecs_bitset_clear(exclude_bitset, eecs_index_of(exclude_components[i]));
+		}
+	}
+
+	filter.num_batch_components = num_required + num_optional;
+	for (eecs_id_t i = 0; i < num_required; ++i) {
+		filter.batch_component_sizes[i] = ecs->components[eecs_index_of(require_components[i])].size;
+	}
+	for (eecs_id_t i = 0; i < num_optional; ++i) {
+		filter.batch_component_sizes[num_required + i] = ecs->components[eecs_index_of(optional_components[i])].size;
+	}
+
+	return filter;
+}
+
+EECS_PRIVATE void
+eecs_init_system_data(eecs_world_t* world, eecs_id_t system_index) {
+	const eecs_system_options_t* system_options = &world->ecs->systems[system_index];
+	eecs_system_data_t* system_data = &world->system_data[system_index];
+
+	system_data->require_bitset = eecs_make_component_bitset(
+		world, &world->version_arena, system_options->require_components
+	);
+	system_data->exclude_bitset = eecs_make_component_bitset(
+		world, &world->version_arena, system_options->exclude_components
+	);
+	system_data->batch_bitset = eecs_make_component_bitset(
+		world, &world->version_arena, system_options->optional_components
+	);
+	for (eecs_id_t j = 0; j < system_data->require_bitset->num_masks; ++j) {
+		system_data->batch_bitset->masks[j] |= system_data->require_bitset->masks[j];
+	}
+
+	if (
+		system_options->read_components != NULL
+		|| system_options->write_components != NULL
+	) {
+		system_data->read_bitset = eecs_make_component_bitset(
+			world, &world->version_arena, system_options->read_components
+		);
+		for (eecs_id_t j = 0; j < system_data->batch_bitset->num_masks; ++j) {
+			system_data->read_bitset->masks[j] |= system_data->batch_bitset->masks[j];
+		}
+		system_data->write_bitset = eecs_make_component_bitset(
+			world, &world->version_arena, system_options->write_components
+		);
+	} else {
+		system_data->read_bitset = NULL;
+		system_data->write_bitset = NULL;
+	}
+
+	if (system_options->changed_components != NULL) {
+		system_data->changed_bitset = eecs_make_component_bitset(
+			world, &world->version_arena, system_options->changed_components
+		);
+		// Checking ticks reads them so writers must not run concurrently
+		if (system_data->read_bitset != NULL) {
+			for (eecs_id_t j = 0; j < system_data->read_bitset->num_masks; ++j) {
+				system_data->read_bitset->masks[j] |= system_data->changed_bitset->masks[j];
+			}
+		}
+	} else {
+		system_data->changed_bitset = NULL;
+	}
+
+	// After the access bitsets so that sparse components still order systems
+	system_data->sparse_filter = eecs_make_sparse_filter(
+		world, &world->version_arena,
+		system_options->require_components,
+		system_options->exclude_components,
+		system_options->optional_components,
+		system_data->require_bitset,
+		system_data->exclude_bitset
+	);
+	eecs_id_t num_batch_components = system_data->sparse_filter.num_batch_components;
+	for (eecs_id_t i = 0; i < world->num_workers; ++i) {
+		eecs_worker_t* worker = &world->workers[i];
+		if (eecs_array_length(worker->run_offsets) < num_batch_components) {
+			eecs_array_resize(world->options.memctx, worker->run_offsets, num_batch_components);
+		}
+	}
+}
+
+EECS_PRIVATE void
+eecs_sync_world(eecs_world_t* world) {
+	const eecs_t* ecs = world->ecs;
+	if (world->version == ecs->version) { return; }
+
+	eecs_id_t synced_version = world->version;
+	world->version = ecs->version;
+	eecs_stat_add(world->stats, num_syncs, 1);
+
+	void* memctx = world->options.memctx;
+
+	// The storage of a component never changes so only new ones need a set
+	eecs_id_t old_num_components = eecs_array_length(world->sparse_sets);
+	eecs_id_t new_num_components = eecs_array_length(ecs->components);
+	eecs_array_resize(memctx, world->sparse_sets, new_num_components);
+	for (eecs_id_t i = old_num_components; i < new_num_components; ++i) {
+		world->sparse_sets[i].component_size = ecs->components[i].size;
+		if (ecs->components[i].storage == EECS_STORAGE_SPARSE) {
+			eecs_array_push(memctx, world->sparse_components, i);
+		}
+	}
+
+	eecs_id_t old_num_systems = eecs_array_length(world->system_data);
+	eecs_id_t new_num_systems = eecs_array_length(ecs->systems);
+	eecs_array_resize(memctx, world->system_data, new_num_systems);
+
+	eecs_id_t num_changed_systems = 0;
+	for (eecs_id_t i = 0; i < old_num_systems; ++i) {
+		num_changed_systems += ecs->system_versions[i] > synced_version;
+	}
+
+	// Re-registered systems leave their previous data in version_arena.
+	// Reclaim it with a full resync once it outweighs the live data.
+	world->num_stale_systems += num_changed_systems;
+	if (world->num_stale_systems > new_num_systems) {
+		world->num_stale_systems = 0;
 		eecs_arena_reset(world, &world->version_arena);
+		eecs_clear_schedules(world);
 
 		eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
 			eecs_table_t* table = *itr.value;
@@ -892,76 +2746,134 @@ eecs_sync_world(eecs_world_t* world) {
 			eecs_record_component_callbacks(world, table);
 		}
 
-		eecs_id_t num_available_components = eecs_array_length(ecs->components);
 		for (eecs_id_t i = 0; i < new_num_systems; ++i) {
-			const eecs_system_options_t* system_options = &ecs->systems[i];
-			eecs_system_data_t* system_data = &world->system_data[i];
-			eecs_array_clear(system_data->matched_tables);
-
-			system_data->require_bitset = eecs_arena_alloc(
-				world, &world->version_arena,
-				eecs_bitset_memory_size(num_available_components),
-				_Alignof(eecs_bitset_t)
-			);
-			eecs_bitset_init(system_data->require_bitset, num_available_components);
-			for (
-				eecs_id_t j = 0;
-				system_options->require_components != NULL
-				&& system_options->require_components[j].from_1_index != 0;
-				++j
-			) {
-				eecs_bitset_set(
-					system_data->require_bitset,
-					eecs_index_of(system_options->require_components[j])
-				);
+			eecs_array_clear(world->system_data[i].matched_tables);
+			eecs_init_system_data(world, i);
+			eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+				eecs_try_match_system_with_table(world, i, *itr.value);
+			}
+		}
+	} else {
+		// Only tables with a re-registered component need their callbacks again
+		eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+		eecs_id_t num_components = eecs_array_length(ecs->components);
+		eecs_bitset_t* changed_components = eecs_arena_alloc(
+			world, &world->tmp_arena,
+			eecs_bitset_memory_size(num_components),
+			_Alignof(eecs_bitset_t)
+		);
+		eecs_bitset_init(changed_components, num_components);
+		for (eecs_id_t i = 0; i < num_components; ++i) {
+			if (ecs->component_versions[i] > synced_version) {
+				eecs_bitset_set(changed_components, i);
 			}
+		}
 
-			system_data->exclude_bitset = eecs_arena_alloc(
-				world, &world->version_arena,
-				eecs_bitset_memory_size(num_available_components),
-				_Alignof(eecs_bitset_t)
-			);
-			eecs_bitset_init(system_data->exclude_bitset, num_available_components);
-			for (
-				eecs_id_t j = 0;
-				system_options->exclude_components != NULL
-				&& system_options->exclude_components[j].from_1_index != 0;
-				++j
-			) {
-				eecs_bitset_set(
-					system_data->exclude_bitset,
-					eecs_index_of(system_options->exclude_components[j])
-				);
+		eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+			eecs_table_t* table = *itr.value;
+			if (eecs_bitset_is_any_set(table->bitset, changed_components)) {
+				eecs_array_clear(table->component_init_callbacks);
+				eecs_array_clear(table->component_cleanup_callbacks);
+				eecs_record_component_callbacks(world, table);
+			}
+		}
+		eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+
+		if (num_changed_systems > 0 || new_num_systems > old_num_systems) {
+			eecs_clear_schedules(world);
+		}
+
+		for (eecs_id_t i = 0; i < new_num_systems; ++i) {
+			if (i < old_num_systems) {
+				if (ecs->system_versions[i] <= synced_version) { continue; }
+
+				eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+					eecs_table_t* table = *itr.value;
+					eecs_remove_system_callbacks(table->system_init_callbacks, i);
+					eecs_remove_system_callbacks(table->system_cleanup_callbacks, i);
+				}
+				eecs_array_clear(world->system_data[i].matched_tables);
 			}
 
+			eecs_init_system_data(world, i);
 			eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
 				eecs_try_match_system_with_table(world, i, *itr.value);
 			}
 		}
+	}
 
-		for (eecs_id_t i = old_num_systems; i < new_num_systems; ++i) {
-			const eecs_system_options_t* system_options = &ecs->systems[i];
-			if (system_options->init_per_world_fn) {
-				system_options->init_per_world_fn(world, system_options->userdata);
-			}
+	for (eecs_id_t i = old_num_systems; i < new_num_systems; ++i) {
+		const eecs_system_options_t* system_options = &ecs->systems[i];
+		if (system_options->init_per_world_fn) {
+			system_options->init_per_world_fn(world, system_options->userdata);
 		}
 	}
 }
 
+EECS_PRIVATE uint64_t
+eecs_signature_hash(eecs_signature_t signature) {
+	// FNV-1a over component ids
+	uint64_t hash = UINT64_C(14695981039346656037);
+	for (eecs_id_t i = 0; i < signature.length; ++i) {
+		hash ^= (uint64_t)(uint32_t)signature.components[i].from_1_index;
+		hash *= UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
 EECS_PRIVATE eecs_table_t*
-eecs_get_table(eecs_world_t* world, eecs_signature_t signature) {
-	// TODO: Consider a hash table
+eecs_find_table(eecs_world_t* world, eecs_signature_t signature, uint64_t hash) {
+	if (world->table_index_capacity == 0) { return NULL; }
+
 	size_t sig_size = sizeof(*signature.components) * signature.length;
-	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
-		eecs_signature_t table_signature = (*itr.value)->signature;
+	uint64_t mask = (uint64_t)world->table_index_capacity - 1;
+	for (uint64_t i = hash & mask; ; i = (i + 1) & mask) {
+		eecs_table_t* table = world->table_index[i];
+		if (table == NULL) { return NULL; }
+
 		if (
-			table_signature.length == signature.length
-			&& memcmp(table_signature.components, signature.components, sig_size) == 0
+			table->signature_hash == hash
+			&& table->signature.length == signature.length
+			&& memcmp(table->signature.components, signature.components, sig_size) == 0
 		) {
-			return *itr.value;
+			return table;
+		}
+	}
+}
+
+EECS_PRIVATE void
+eecs_index_table(eecs_world_t* world, eecs_table_t* table) {
+	void* memctx = world->options.memctx;
+	eecs_id_t num_tables = eecs_array_length(world->tables);
+
+	// Keep load factor under 3/4
+	if ((num_tables + 1) * 4 > world->table_index_capacity * 3) {
+		eecs_id_t new_capacity = eecs_max(world->table_index_capacity * 2, 16);
+		eecs_table_t** new_index = eecs_malloc(memctx, sizeof(eecs_table_t*) * new_capacity);
+		memset(new_index, 0, sizeof(eecs_table_t*) * new_capacity);
+
+		uint64_t mask = (uint64_t)new_capacity - 1;
+		eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+			uint64_t i = (*itr.value)->signature_hash & mask;
+			while (new_index[i] != NULL) { i = (i + 1) & mask; }
+			new_index[i] = *itr.value;
 		}
+
+		eecs_free(memctx, world->table_index);
+		world->table_index = new_index;
+		world->table_index_capacity = new_capacity;
 	}
 
+	uint64_t mask = (uint64_t)world->table_index_capacity - 1;
+	uint64_t i = table->signature_hash & mask;
+	while (world->table_index[i] != NULL) { i = (i + 1) & mask; }
+	world->table_index[i] = table;
+}
+
+// Creates a table without matching it against systems and queries
+EECS_PRIVATE eecs_table_t*
+eecs_create_table(eecs_world_t* world, eecs_signature_t signature, uint64_t hash) {
+	size_t sig_size = sizeof(*signature.components) * signature.length;
 	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
 	void* memctx = world->options.memctx;
 	eecs_component_t* sig_content_copy = eecs_malloc(memctx, sig_size);
@@ -974,6 +2886,8 @@ eecs_get_table(eecs_world_t* world, eecs_signature_t signature) {
 			.length = signature.length,
 			.components = sig_content_copy,
 		},
+		.signature_hash = hash,
+		.index = eecs_array_length(world->tables),
 		.bitset = eecs_malloc(
 			memctx, eecs_bitset_memory_size(num_available_components)
 		),
@@ -983,12 +2897,41 @@ eecs_get_table(eecs_world_t* world, eecs_signature_t signature) {
 		.component_sizes = eecs_malloc(
 			memctx, sizeof(size_t) * signature.length
 		),
+		.data_columns = eecs_malloc(
+			memctx, sizeof(eecs_id_t) * eecs_max(signature.length, 1)
+		),
+		.enableable_columns = eecs_malloc(
+			memctx, sizeof(eecs_id_t) * eecs_max(signature.length, 1)
+		),
+		.enable_mask_offsets = eecs_malloc(
+			memctx, sizeof(ptrdiff_t) * eecs_max(signature.length, 1)
+		),
+		.num_component_columns = num_available_components,
+		.component_columns = eecs_malloc(
+			memctx, sizeof(eecs_id_t) * eecs_max(num_available_components, 1)
+		),
 	};
 	eecs_bitset_init(table->bitset, num_available_components);
+	for (eecs_id_t i = 0; i < num_available_components; ++i) {
+		table->component_columns[i] = -1;
+	}
+	const eecs_t* ecs = world->ecs;
+	const eecs_component_options_t* components = ecs->components;
 	for (eecs_id_t i = 0; i < signature.length; ++i) {
-		eecs_bitset_set(table->bitset, eecs_index_of(signature.components[i]));
+		eecs_id_t component_index = eecs_index_of(signature.components[i]);
+		eecs_bitset_set(table->bitset, component_index);
+		table->component_columns[component_index] = i;
+		if (components[component_index].size > 0) {
+			table->data_columns[table->num_data_columns++] = i;
+		}
+		if (components[component_index].enableable) {
+			table->enableable_columns[table->num_enableable_columns++] = i;
+		}
+		table->enable_mask_offsets[i] = -1;
 	}
+	eecs_index_table(world, table);
 	eecs_array_push(memctx, world->tables, table);  // NOLINT(bugprone-sizeof-expression)
+	eecs_stat_add(world->stats, num_tables_created, 1);
 
 	// Calculate how many entities can fit in a chunk and storage offset
 	// Sort by alignment to avoid wastage
@@ -1003,8 +2946,6 @@ eecs_get_table(eecs_world_t* world, eecs_signature_t signature) {
 		component_slots[i].component = signature.components[i];
 	}
 
-	const eecs_t* ecs = world->ecs;
-	const eecs_component_options_t* components = ecs->components;
 #define eecs_alignment_cmp_lt(lhs, rhs) \
 	(components[eecs_index_of(lhs.component)].alignment < components[eecs_index_of(rhs.component)].alignment)
 	eecs_insertion_sort(
@@ -1019,159 +2960,688 @@ eecs_get_table(eecs_world_t* world, eecs_signature_t signature) {
 	for (eecs_id_t i = 0; i < signature.length; ++i) {
 		const eecs_component_slot_t* slot = &component_slots[i];
 		const eecs_component_options_t* component_options = &components[eecs_index_of(slot->component)];
+		if (component_options->size == 0) { continue; }
+
 		struct_size = eecs_align_ptr(struct_size, component_options->alignment);
 		max_align = eecs_max(max_align, component_options->alignment);
 		struct_size += component_options->size;
 		data_size += component_options->size;
 	}
 	struct_size = eecs_align_ptr(struct_size, max_align);
-	uintptr_t alignment_overhead = struct_size - data_size;
-	uintptr_t num_entities_per_chunk = (world->options.table_chunk_size - alignment_overhead) / data_size;
+	uintptr_t column_alignment = eecs_max(world->options.column_alignment, 1);
+	// Each column after the entity ids may be padded to the column alignment
+	uintptr_t alignment_overhead = struct_size - data_size
+		+ (uintptr_t)table->num_data_columns * (column_alignment - 1);
+	// Each enableable column takes a bit per entity, rounded up to whole masks
+	uintptr_t num_enableable_columns = (uintptr_t)table->num_enableable_columns;
+	if (num_enableable_columns > 0) {
+		alignment_overhead += num_enableable_columns * sizeof(eecs_mask_t) + _Alignof(eecs_mask_t) - 1;
+	}
+	uintptr_t num_entities_per_chunk = (world->options.table_chunk_size - alignment_overhead) * CHAR_BIT
+		/ (data_size * CHAR_BIT + num_enableable_columns);
+	uintptr_t batch_width = (uintptr_t)world->options.batch_width;
+	num_entities_per_chunk -= num_entities_per_chunk % batch_width;
+	EECS_ASSERT(num_entities_per_chunk > 0, "Table chunk is too small");
 	table->num_entities_per_chunk = (eecs_id_t)num_entities_per_chunk;
 
-	// Layout each components
+	// Layout each components. Tags point right past the entity ids, which
+	// keeps them in the chunk even when a batch is narrowed down.
 	uintptr_t data_offset = (uintptr_t)(sizeof(eecs_id_t) * num_entities_per_chunk);
 	for (eecs_id_t i = 0; i < signature.length; ++i) {
 		const eecs_component_slot_t* slot = &component_slots[i];
 		const eecs_component_options_t* component_options = &components[eecs_index_of(slot->component)];
-		data_offset = eecs_align_ptr(data_offset, component_options->alignment);
+		if (component_options->size == 0) {
+			table->component_storage_offsets[slot->index] = (ptrdiff_t)(sizeof(eecs_id_t) * num_entities_per_chunk);
+			table->component_sizes[slot->index] = 0;
+			continue;
+		}
+
+		data_offset = eecs_align_ptr(data_offset, eecs_max(component_options->alignment, column_alignment));
 		table->component_storage_offsets[slot->index] = data_offset;
 		table->component_sizes[slot->index] = component_options->size;
 		data_offset += component_options->size * num_entities_per_chunk;
 	}
+	size_t enable_masks_size = sizeof(eecs_mask_t) * (size_t)eecs_num_enable_masks(table->num_entities_per_chunk);
+	for (eecs_id_t j = 0; j < table->num_enableable_columns; ++j) {
+		data_offset = eecs_align_ptr(data_offset, _Alignof(eecs_mask_t));
+		table->enable_mask_offsets[table->enableable_columns[j]] = (ptrdiff_t)data_offset;
+		data_offset += enable_masks_size;
+	}
 	EECS_ASSERT(data_offset <= world->options.table_chunk_size, "Layout failed");
 
 	eecs_record_component_callbacks(world, table);
 
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+	return table;
+}
+
+EECS_PRIVATE eecs_table_t*
+eecs_get_table(eecs_world_t* world, eecs_signature_t signature) {
+	uint64_t hash = eecs_signature_hash(signature);
+	eecs_table_t* existing_table = eecs_find_table(world, signature, hash);
+	if (existing_table != NULL) { return existing_table; }
+
+	eecs_table_t* table = eecs_create_table(world, signature, hash);
+
 	// Find matching systems
 	eecs_array_indexed_foreach(eecs_system_data_t, itr, world->system_data) {
 		eecs_try_match_system_with_table(world, itr.index, table);
 	}
+	eecs_array_indexed_foreach(eecs_query_t*, itr, world->queries) {
+		eecs_try_match_query_with_table(*itr.value, table);
+	}
 
-	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
 	return table;
 }
 
-EECS_PRIVATE eecs_entity_data_t*
-eecs_get_entity_data(eecs_world_t* world, eecs_entity_t handle) {
-	eecs_id_t from_1_index = handle.from_1_index;
-	if (!(1 <= from_1_index && from_1_index <= eecs_array_length(world->entities))) {
-		return NULL;
+// Returns the shared directory after adding a reference for a fork
+EECS_PRIVATE eecs_shared_entities_t*
+eecs_share_entities(eecs_world_t* world) {
+	eecs_shared_entities_t* shared = world->shared_entities;
+	if (shared != NULL) {
+		eecs_add_block_owner(&shared->share);
+		return shared;
 	}
 
-	eecs_entity_data_t* entity_data = &world->entities[from_1_index - 1];
-	return entity_data->gen == handle.gen ? entity_data : NULL;
+	void* memctx = world->options.memctx;
+	eecs_id_t num_tables = eecs_array_length(world->tables);
+	shared = eecs_malloc(memctx, sizeof(eecs_shared_entities_t));
+	shared->share.num_owners = 2;
+	shared->num_tables = num_tables;
+	shared->tables = eecs_malloc(memctx, sizeof(eecs_table_address_t) * eecs_max(num_tables, 1));
+	for (eecs_id_t i = 0; i < num_tables; ++i) {
+		shared->tables[i] = (eecs_table_address_t){
+			.address = (uintptr_t)world->tables[i],
+			.index = i,
+		};
+	}
+	// Tables are usually allocated in increasing addresses
+#define eecs_table_address_cmp_lt(lhs, rhs) (lhs.address < rhs.address)
+	eecs_insertion_sort(num_tables, shared->tables, eecs_table_address_t, eecs_table_address_cmp_lt);
+
+	world->shared_entities = shared;
+	return shared;
 }
 
-EECS_PRIVATE void
-eecs_delete_entity_from_table(
+// Returns whether the caller was the last owner
+EECS_PRIVATE bool
+eecs_release_shared_entities(eecs_world_t* world) {
+	eecs_shared_entities_t* shared = world->shared_entities;
+	world->shared_entities = NULL;
+	world->rebase_entities = false;
+	if (!eecs_remove_block_owner(&shared->share)) { return false; }
+
+	eecs_free(world->options.memctx, shared->tables);
+	eecs_free(world->options.memctx, shared);
+	return true;
+}
+
+EECS_PRIVATE eecs_table_t*
+eecs_rebase_table(
 	eecs_world_t* world,
-	eecs_table_t* table,
-	eecs_id_t pos_in_table
+	const eecs_shared_entities_t* shared,
+	uintptr_t address
 ) {
-	// Move the last entity into the destroyed slot
-	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
-	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
-	char* chunk = table->chunks[chunk_index];
+	eecs_id_t low = 0;
+	eecs_id_t high = shared->num_tables;
+	while (low < high) {
+		eecs_id_t mid = low + (high - low) / 2;
+		if (shared->tables[mid].address < address) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
 
-	eecs_id_t last_slot = --table->num_entities;
-	eecs_id_t last_chunk_index = last_slot / table->num_entities_per_chunk;
-	eecs_id_t last_pos_in_chunk = last_slot % table->num_entities_per_chunk;
-	char* last_chunk = table->chunks[last_chunk_index];
+	return low < shared->num_tables && shared->tables[low].address == address
+		? world->tables[shared->tables[low].index]
+		: NULL;
+}
 
-	eecs_id_t last_entity_from_1_index;
-	((eecs_id_t*)chunk)[pos_in_chunk] = last_entity_from_1_index = ((eecs_id_t*)last_chunk)[last_pos_in_chunk];
+EECS_PRIVATE eecs_entity_data_t*
+eecs_entity_slot(const eecs_world_t* world, eecs_id_t from_1_index) {
+	size_t slot_index = (size_t)(from_1_index - 1);
+	return &world->entity_pages[slot_index / EECS_ENTITY_PAGE_SIZE]->slots[slot_index % EECS_ENTITY_PAGE_SIZE];
+}
 
-	const ptrdiff_t* component_storage_offsets = table->component_storage_offsets;
-	const size_t* component_sizes = table->component_sizes;
-	for (eecs_id_t i = 0; i < table->signature.length; ++i) {
-		size_t component_size = component_sizes[i];
-		ptrdiff_t component_storage_offset = component_storage_offsets[i];
-		char* component_data = chunk
-			+ component_storage_offset
-			+ pos_in_chunk * component_size;
-		char* last_component_data = last_chunk
-			+ component_storage_offset
-			+ last_pos_in_chunk * component_size;
+EECS_PRIVATE void
+eecs_free_entity_pages(void* memctx, eecs_array(eecs_entity_page_t*) pages) {
+	eecs_array_indexed_foreach(eecs_entity_page_t*, itr, pages) {
+		eecs_free(memctx, *itr.value);
+	}
+	eecs_array_free(memctx, pages);
+}
 
-		memcpy(component_data, last_component_data, component_size);
+// Must be called before writing to the directory
+EECS_PRIVATE void
+eecs_own_entities(eecs_world_t* world) {
+	eecs_shared_entities_t* shared = world->shared_entities;
+	if (shared == NULL) { return; }
+
+	void* memctx = world->options.memctx;
+	eecs_array(eecs_entity_page_t*) pages = world->entity_pages;
+	eecs_id_t num_pages = eecs_array_length(pages);
+	bool rebase = world->rebase_entities;
+
+	// Once every other world let go, the pages can be taken over as is
+	eecs_array(eecs_entity_page_t*) own_pages = pages;
+	if (eecs_is_block_shared(&shared->share)) {
+		own_pages = NULL;
+		eecs_array_resize(memctx, own_pages, num_pages);
+		for (eecs_id_t i = 0; i < num_pages; ++i) {
+			own_pages[i] = eecs_malloc(memctx, sizeof(eecs_entity_page_t));
+			memcpy(own_pages[i], pages[i], sizeof(eecs_entity_page_t));
+		}
+	}
+	world->entity_pages = own_pages;
+
+	if (rebase) {
+		uintptr_t last_address = 0;
+		eecs_table_t* last_table = NULL;
+		for (eecs_id_t i = 1; i <= world->num_entity_slots; ++i) {
+			eecs_entity_data_t* entity_data = eecs_entity_slot(world, i);
+			uintptr_t address = (uintptr_t)entity_data->table;
+			if (address == 0) { continue; }
+
+			if (address != last_address) {
+				last_address = address;
+				last_table = eecs_rebase_table(world, shared, address);
+			}
+			entity_data->table = last_table;
+		}
 	}
-	world->entities[last_entity_from_1_index - 1].pos_in_table = pos_in_table;
 
-	// If last chunk is empty, release it
-	if (last_pos_in_chunk == 0) {
-		eecs_release_chunk(world, eecs_array_pop(table->chunks));
+	if (eecs_release_shared_entities(world) && own_pages != pages) {
+		eecs_free_entity_pages(memctx, pages);
 	}
 }
 
-EECS_PRIVATE void
-eecs_destroy_entity_now(eecs_world_t* world, eecs_entity_data_t* entity_data) {
-	eecs_id_t from_1_index = entity_data - world->entities + 1;
-	eecs_table_t* table = entity_data->table;
-	eecs_entity_t handle = {
-		.from_1_index = from_1_index,
-		.gen = entity_data->gen,
-	};
-	eecs_id_t pos_in_table = entity_data->pos_in_table;
-	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
-	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
+EECS_PRIVATE eecs_entity_data_t*
+eecs_get_entity_data(eecs_world_t* world, eecs_entity_t handle) {
+	if (world->rebase_entities) { eecs_own_entities(world); }
 
-	// Cleanup entity by systems
-	eecs_array_indexed_foreach_rev(
-		eecs_system_entity_callback_t, itr, table->system_cleanup_callbacks
-	) {
-		itr.value->fn(world, handle, itr.value->userdata);
+	eecs_id_t from_1_index = handle.from_1_index;
+	if (!(1 <= from_1_index && from_1_index <= world->num_entity_slots)) {
+		return NULL;
 	}
 
-	// Cleanup components
-	const ptrdiff_t* component_storage_offsets = table->component_storage_offsets;
-	const size_t* component_sizes = table->component_sizes;
-	char* chunk = table->chunks[chunk_index];
-	eecs_array_indexed_foreach_rev(
-		eecs_component_entity_callback_t, itr, table->component_cleanup_callbacks
-	) {
-		char* component_data = chunk
-			+ component_storage_offsets[itr.value->signature_index]
-			+ pos_in_chunk * component_sizes[itr.value->signature_index];
+	eecs_entity_data_t* entity_data = eecs_entity_slot(world, from_1_index);
+	return entity_data->gen == handle.gen ? entity_data : NULL;
+}
 
-		itr.value->fn(world, handle, component_data, itr.value->userdata);
+// Append slots of the current generation, without adding a page until the
+// last one is full. Returns the from_1_index of the first new slot.
+EECS_PRIVATE eecs_id_t
+eecs_grow_entity_slots(eecs_world_t* world, eecs_id_t count) {
+	void* memctx = world->options.memctx;
+	eecs_id_t first_from_1_index = world->num_entity_slots + 1;
+	world->num_entity_slots += count;
+
+	size_t num_pages = ((size_t)world->num_entity_slots + EECS_ENTITY_PAGE_SIZE - 1) / EECS_ENTITY_PAGE_SIZE;
+	while ((size_t)eecs_array_length(world->entity_pages) < num_pages) {
+		eecs_entity_page_t* page = eecs_malloc(memctx, sizeof(eecs_entity_page_t));
+		memset(page, 0, sizeof(eecs_entity_page_t));
+		eecs_array_push(memctx, world->entity_pages, page);  // NOLINT(bugprone-sizeof-expression)
 	}
 
-	eecs_delete_entity_from_table(world, table, pos_in_table);
+	for (eecs_id_t i = first_from_1_index; i <= world->num_entity_slots; ++i) {
+		*eecs_entity_slot(world, i) = (eecs_entity_data_t){ .gen = world->new_entity_gen };
+	}
+	return first_from_1_index;
+}
 
-	// Recycle data slot
-	entity_data = &world->entities[from_1_index - 1];
-	++entity_data->gen;
-	entity_data->pos_in_table = world->next_free_entity_slot;
-	world->next_free_entity_slot = from_1_index;
+// Drop the slots past num_slots along with the pages left empty. The free
+// lists must be relinked afterward.
+EECS_PRIVATE void
+eecs_truncate_entity_slots(eecs_world_t* world, eecs_id_t num_slots) {
+	void* memctx = world->options.memctx;
+	eecs_id_t num_pages = (num_slots + EECS_ENTITY_PAGE_SIZE - 1) / EECS_ENTITY_PAGE_SIZE;
+	while (eecs_array_length(world->entity_pages) > num_pages) {
+		eecs_free(memctx, eecs_array_pop(world->entity_pages));
+	}
+	eecs_array_shrink_to_fit(memctx, world->entity_pages);
+	world->num_entity_slots = num_slots;
+	world->relink_free_entity_slots = true;
 }
 
-EECS_PRIVATE eecs_deferred_op_t*
-eecs_alloc_deferred_op(eecs_world_t* world, eecs_deferred_op_type_t type, eecs_entity_t handle) {
-	eecs_deferred_op_t* op = eecs_arena_alloc(
-		world,
-		&world->deferred_arena,
-		sizeof(eecs_deferred_op_t),
-		_Alignof(eecs_deferred_op_t)
-	);
-	*op = (eecs_deferred_op_t){
-		.type = type,
-		.handle = handle,
-	};
+// The slot must be owned and already have its next generation
+EECS_PRIVATE void
+eecs_push_free_entity_slot(eecs_world_t* world, eecs_id_t from_1_index) {
+	eecs_id_t page_index = (from_1_index - 1) / EECS_ENTITY_PAGE_SIZE;
+	eecs_entity_page_t* page = world->entity_pages[page_index];
+	if (page->next_free_slot == 0) {
+		page->next_free_page = world->next_free_entity_page;
+		world->next_free_entity_page = page_index + 1;
+	}
+
+	eecs_entity_data_t* entity_data = eecs_entity_slot(world, from_1_index);
+	entity_data->table = NULL;
+	entity_data->pos_in_table = page->next_free_slot;
+	page->next_free_slot = from_1_index;
+}
 
-	if (world->first_deferred_ops == NULL) {
-		world->first_deferred_ops = op;
+// Link every free slot again so that the lowest ones are reused first
+EECS_PRIVATE void
+eecs_relink_free_entity_slots(eecs_world_t* world) {
+	world->relink_free_entity_slots = false;
+	world->next_free_entity_page = 0;
+	eecs_array_indexed_foreach(eecs_entity_page_t*, itr, world->entity_pages) {
+		(*itr.value)->next_free_slot = 0;
+		(*itr.value)->next_free_page = 0;
 	}
 
-	if (world->last_deferred_ops != NULL) {
-		world->last_deferred_ops->next = op;
+	for (eecs_id_t i = world->num_entity_slots; i > 0; --i) {
+		if (eecs_entity_slot(world, i)->table == NULL) {
+			eecs_push_free_entity_slot(world, i);
+		}
 	}
-	world->last_deferred_ops = op;
+}
 
-	return op;
+// from_1_index of a free slot taken from the first page having some, or 0
+// when there is none. The directory must be owned.
+EECS_PRIVATE eecs_id_t
+eecs_pop_free_entity_slot(eecs_world_t* world) {
+	if (world->relink_free_entity_slots) { eecs_relink_free_entity_slots(world); }
+	if (world->next_free_entity_page == 0) { return 0; }
+
+	eecs_entity_page_t* page = world->entity_pages[world->next_free_entity_page - 1];
+	eecs_id_t from_1_index = page->next_free_slot;
+	page->next_free_slot = eecs_entity_slot(world, from_1_index)->pos_in_table;
+	if (page->next_free_slot == 0) {
+		world->next_free_entity_page = page->next_free_page;
+		page->next_free_page = 0;
+	}
+	return from_1_index;
 }
 
-EECS_PRIVATE void
+// Position in the sparse set + 1 or 0 when the entity lacks the component.
+// The sets of table components are always empty.
+EECS_PRIVATE eecs_id_t
+eecs_find_sparse_position(const eecs_world_t* world, eecs_id_t component_index, eecs_id_t from_1_index) {
+	if (!(0 <= component_index && component_index < eecs_array_length(world->sparse_sets))) {
+		return 0;
+	}
+
+	const eecs_sparse_set_t* set = &world->sparse_sets[component_index];
+	return from_1_index <= eecs_array_length(set->positions)
+		? set->positions[from_1_index - 1]
+		: 0;
+}
+
+EECS_PRIVATE char*
+eecs_get_sparse_component(const eecs_world_t* world, eecs_id_t component_index, eecs_id_t from_1_index) {
+	eecs_id_t position = eecs_find_sparse_position(world, component_index, from_1_index);
+	if (position == 0) { return NULL; }
+
+	const eecs_sparse_set_t* set = &world->sparse_sets[component_index];
+	return set->data + set->component_size * (size_t)(position - 1);
+}
+
+EECS_PRIVATE bool
+eecs_passes_sparse_filter(
+	const eecs_world_t* world,
+	const eecs_sparse_filter_t* filter,
+	eecs_id_t from_1_index
+) {
+	for (eecs_id_t i = 0; i < filter->num_required; ++i) {
+		if (eecs_find_sparse_position(world, filter->components[i], from_1_index) == 0) {
+			return false;
+		}
+	}
+
+	eecs_id_t num_components = filter->num_required + filter->num_excluded;
+	for (eecs_id_t i = filter->num_required; i < num_components; ++i) {
+		if (eecs_find_sparse_position(world, filter->components[i], from_1_index) > 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Add an entity to a set which does not have it yet, without calling
+// init_fn. Returns its component, left uninitialized.
+EECS_PRIVATE char*
+eecs_push_sparse_member(eecs_world_t* world, eecs_sparse_set_t* set, eecs_id_t from_1_index) {
+	void* memctx = world->options.memctx;
+	eecs_id_t num_slots = eecs_array_length(set->positions);
+	if (from_1_index > num_slots) {
+		eecs_array_resize(memctx, set->positions, eecs_max(from_1_index, num_slots * 2));
+	}
+
+	eecs_id_t capacity = eecs_array_capacity(set->entities);
+	eecs_array_push(memctx, set->entities, from_1_index);
+	if (eecs_array_capacity(set->entities) != capacity) {
+		// Zero-size components still get an address
+		set->data = eecs_realloc(
+			memctx, set->data,
+			eecs_max(set->component_size * (size_t)eecs_array_capacity(set->entities), (size_t)1)
+		);
+	}
+
+	eecs_id_t position = eecs_array_length(set->entities);
+	set->positions[from_1_index - 1] = position;
+	return set->data + set->component_size * (size_t)(position - 1);
+}
+
+// Swap-remove a member without calling cleanup_fn
+EECS_PRIVATE void
+eecs_erase_sparse_member(eecs_sparse_set_t* set, eecs_id_t from_1_index) {
+	eecs_id_t position = set->positions[from_1_index - 1];
+	eecs_id_t last_position = eecs_array_length(set->entities);
+	eecs_id_t last_from_1_index = eecs_array_pop(set->entities);
+	if (position != last_position) {
+		set->entities[position - 1] = last_from_1_index;
+		set->positions[last_from_1_index - 1] = position;
+		memcpy(
+			set->data + set->component_size * (size_t)(position - 1),
+			set->data + set->component_size * (size_t)(last_position - 1),
+			set->component_size
+		);
+	}
+	set->positions[from_1_index - 1] = 0;
+}
+
+// Adding a component which the entity already has is a no-op
+EECS_PRIVATE void
+eecs_add_sparse_component(eecs_world_t* world, eecs_entity_t handle, eecs_component_init_t init) {
+	eecs_id_t component_index = eecs_index_of(init.component);
+	if (eecs_find_sparse_position(world, component_index, handle.from_1_index) > 0) { return; }
+
+	eecs_sparse_set_t* set = &world->sparse_sets[component_index];
+	char* component_data = eecs_push_sparse_member(world, set, handle.from_1_index);
+	if (init.data == NULL) {
+		memset(component_data, 0, set->component_size);
+	} else {
+		memcpy(component_data, init.data, set->component_size);
+	}
+
+	const eecs_component_options_t* component_options = &world->ecs->components[component_index];
+	if (component_options->init_fn) {
+		component_options->init_fn(world, handle, component_data, component_options->userdata);
+	}
+}
+
+EECS_PRIVATE void
+eecs_remove_sparse_component(eecs_world_t* world, eecs_entity_t handle, eecs_id_t component_index) {
+	char* component_data = eecs_get_sparse_component(world, component_index, handle.from_1_index);
+	if (component_data == NULL) { return; }
+
+	const eecs_component_options_t* component_options = &world->ecs->components[component_index];
+	if (component_options->cleanup_fn) {
+		component_options->cleanup_fn(world, handle, component_data, component_options->userdata);
+	}
+
+	// The callback may have removed it already
+	if (eecs_find_sparse_position(world, component_index, handle.from_1_index) > 0) {
+		eecs_erase_sparse_member(&world->sparse_sets[component_index], handle.from_1_index);
+	}
+}
+
+EECS_PRIVATE void
+eecs_remove_sparse_components(eecs_world_t* world, eecs_entity_t handle) {
+	eecs_array_indexed_foreach_rev(eecs_id_t, itr, world->sparse_components) {
+		eecs_remove_sparse_component(world, handle, *itr.value);
+	}
+}
+
+// Add the sparse components of an init list to a new entity, the first
+// occurrence of a component wins as for tables
+EECS_PRIVATE void
+eecs_init_sparse_components(
+	eecs_world_t* world,
+	eecs_entity_t handle,
+	const eecs_component_init_t* init,
+	eecs_id_t entity_index
+) {
+	const eecs_t* ecs = world->ecs;
+	for (eecs_id_t i = 0; init != NULL && init[i].component.from_1_index != 0; ++i) {
+		if (!eecs_is_sparse_component(ecs, init[i].component)) { continue; }
+		// Callbacks may have destroyed the entity
+		if (eecs_get_entity_data(world, handle) == NULL) { return; }
+
+		eecs_component_init_t sparse_init = init[i];
+		if (sparse_init.per_entity && sparse_init.data != NULL) {
+			size_t component_size = ecs->components[eecs_index_of(sparse_init.component)].size;
+			sparse_init.data = (const char*)sparse_init.data + component_size * (size_t)entity_index;
+		}
+		eecs_add_sparse_component(world, handle, sparse_init);
+	}
+}
+
+// The sparse part of a morph. As for tables, a component which is both
+// removed and added is removed.
+EECS_PRIVATE void
+eecs_morph_sparse_components(
+	eecs_world_t* world,
+	eecs_entity_t handle,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+) {
+	const eecs_t* ecs = world->ecs;
+	eecs_id_t num_removed_components = eecs_component_list_length(removed_components);
+	for (eecs_id_t i = 0; i < num_removed_components; ++i) {
+		if (eecs_is_sparse_component(ecs, removed_components[i])) {
+			eecs_remove_sparse_component(world, handle, eecs_index_of(removed_components[i]));
+		}
+	}
+
+	for (eecs_id_t i = 0; new_components != NULL && new_components[i].component.from_1_index != 0; ++i) {
+		eecs_component_t component = new_components[i].component;
+		if (!eecs_is_sparse_component(ecs, component)) { continue; }
+
+		bool removed = false;
+		for (eecs_id_t j = 0; j < num_removed_components && !removed; ++j) {
+			removed = removed_components[j].from_1_index == component.from_1_index;
+		}
+		// Callbacks may have destroyed the entity
+		if (!removed && eecs_get_entity_data(world, handle) != NULL) {
+			eecs_add_sparse_component(world, handle, new_components[i]);
+		}
+	}
+}
+
+// Copy the table components of a morph to tmp_arena, which the caller must
+// checkpoint. Returns false and leaves the lists as they are when no
+// component is sparse.
+EECS_PRIVATE bool
+eecs_split_sparse_morph(
+	eecs_world_t* world,
+	const eecs_component_init_t** new_components_inout,
+	const eecs_component_t** removed_components_inout
+) {
+	if (eecs_array_length(world->sparse_components) == 0) { return false; }
+
+	const eecs_t* ecs = world->ecs;
+	const eecs_component_init_t* new_components = *new_components_inout;
+	const eecs_component_t* removed_components = *removed_components_inout;
+	eecs_id_t num_new_components = eecs_component_init_list_length(new_components);
+	eecs_id_t num_removed_components = eecs_component_list_length(removed_components);
+
+	bool has_sparse = false;
+	for (eecs_id_t i = 0; i < num_new_components && !has_sparse; ++i) {
+		has_sparse = eecs_is_sparse_component(ecs, new_components[i].component);
+	}
+	for (eecs_id_t i = 0; i < num_removed_components && !has_sparse; ++i) {
+		has_sparse = eecs_is_sparse_component(ecs, removed_components[i]);
+	}
+	if (!has_sparse) { return false; }
+
+	eecs_component_init_t* table_new_components = eecs_arena_alloc(
+		world, &world->tmp_arena,
+		sizeof(eecs_component_init_t) * (num_new_components + 1),
+		_Alignof(eecs_component_init_t)
+	);
+	eecs_id_t num_table_new_components = 0;
+	for (eecs_id_t i = 0; i < num_new_components; ++i) {
+		if (!eecs_is_sparse_component(ecs, new_components[i].component)) {
+			table_new_components[num_table_new_components++] = new_components[i];
+		}
+	}
+	table_new_components[num_table_new_components] = (eecs_component_init_t)EECS_END_OF_LIST;
+
+	eecs_component_t* table_removed_components = eecs_arena_alloc(
+		world, &world->tmp_arena,
+		sizeof(eecs_component_t) * (num_removed_components + 1),
+		_Alignof(eecs_component_t)
+	);
+	eecs_id_t num_table_removed_components = 0;
+	for (eecs_id_t i = 0; i < num_removed_components; ++i) {
+		if (!eecs_is_sparse_component(ecs, removed_components[i])) {
+			table_removed_components[num_table_removed_components++] = removed_components[i];
+		}
+	}
+	table_removed_components[num_table_removed_components] = (eecs_component_t)EECS_END_OF_LIST;
+
+	*new_components_inout = table_new_components;
+	*removed_components_inout = table_removed_components;
+	return true;
+}
+
+EECS_PRIVATE void
+eecs_delete_entity_from_table(
+	eecs_world_t* world,
+	eecs_table_t* table,
+	eecs_id_t pos_in_table
+) {
+	// Move the last entity into the destroyed slot
+	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
+	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
+	char* chunk = eecs_own_chunk(world, table, chunk_index);
+
+	eecs_id_t last_slot = --table->num_entities;
+	eecs_id_t last_chunk_index = last_slot / table->num_entities_per_chunk;
+	eecs_id_t last_pos_in_chunk = last_slot % table->num_entities_per_chunk;
+	char* last_chunk = table->chunks[last_chunk_index];
+
+	eecs_id_t last_entity_from_1_index;
+	((eecs_id_t*)chunk)[pos_in_chunk] = last_entity_from_1_index = ((eecs_id_t*)last_chunk)[last_pos_in_chunk];
+
+	const ptrdiff_t* component_storage_offsets = table->component_storage_offsets;
+	const size_t* component_sizes = table->component_sizes;
+	for (eecs_id_t j = 0; j < table->num_data_columns; ++j) {
+		eecs_id_t i = table->data_columns[j];
+		size_t component_size = component_sizes[i];
+		ptrdiff_t component_storage_offset = component_storage_offsets[i];
+		char* component_data = chunk
+			+ component_storage_offset
+			+ pos_in_chunk * component_size;
+		char* last_component_data = last_chunk
+			+ component_storage_offset
+			+ last_pos_in_chunk * component_size;
+
+		memcpy(component_data, last_component_data, component_size);
+	}
+	for (eecs_id_t j = 0; j < table->num_enableable_columns; ++j) {
+		eecs_id_t i = table->enableable_columns[j];
+		eecs_copy_enable_bits(table, i, pos_in_table, table, i, last_slot, 1);
+	}
+	eecs_entity_slot(world, last_entity_from_1_index)->pos_in_table = pos_in_table;
+	eecs_mark_rows_changed(world, table, pos_in_table, 1);
+
+	// If last chunk is empty, release it
+	if (last_pos_in_chunk == 0) {
+		eecs_pop_table_chunk(world, table);
+	}
+}
+
+EECS_PRIVATE void
+eecs_destroy_entity_now(eecs_world_t* world, eecs_entity_t handle) {
+	eecs_id_t from_1_index = handle.from_1_index;
+	eecs_own_entities(world);
+	eecs_entity_data_t* entity_data = eecs_entity_slot(world, from_1_index);
+	eecs_table_t* table = entity_data->table;
+	eecs_id_t pos_in_table = entity_data->pos_in_table;
+	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
+	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
+
+	// Cleanup entity by systems
+	eecs_array_indexed_foreach_rev(
+		eecs_system_entity_callback_t, itr, table->system_cleanup_callbacks
+	) {
+		itr.value->fn(world, handle, itr.value->userdata);
+	}
+
+	// Cleanup components
+	const ptrdiff_t* component_storage_offsets = table->component_storage_offsets;
+	const size_t* component_sizes = table->component_sizes;
+	char* chunk = eecs_own_chunk(world, table, chunk_index);
+	eecs_array_indexed_foreach_rev(
+		eecs_component_entity_callback_t, itr, table->component_cleanup_callbacks
+	) {
+		char* component_data = chunk
+			+ component_storage_offsets[itr.value->signature_index]
+			+ pos_in_chunk * component_sizes[itr.value->signature_index];
+
+		itr.value->fn(world, handle, component_data, itr.value->userdata);
+	}
+	eecs_remove_sparse_components(world, handle);
+
+	eecs_delete_entity_from_table(world, table, pos_in_table);
+	eecs_stat_add(world->stats, num_entities_destroyed, 1);
+
+	// Recycle data slot
+	++eecs_entity_slot(world, from_1_index)->gen;
+	eecs_push_free_entity_slot(world, from_1_index);
+}
+
+EECS_PRIVATE eecs_worker_t*
+eecs_current_worker(eecs_world_t* world) {
+#ifdef EECS_THREADS
+	eecs_worker_t* worker = eecs_thread_worker;
+	if (worker != NULL && worker->world == world) { return worker; }
+#endif
+	return &world->workers[0];
+}
+
+EECS_PRIVATE bool
+eecs_should_defer(eecs_world_t* world, const eecs_entity_data_t* entity_data) {
+	return world->parallel_update
+		|| world->bulk_depth > 0
+		|| entity_data->table == world->current_update_table;
+}
+
+EECS_PRIVATE eecs_arena_t*
+eecs_deferred_arena(eecs_world_t* world) {
+	return world->parallel_update
+		? &eecs_current_worker(world)->deferred_arena
+		: &world->deferred_arena;
+}
+
+EECS_PRIVATE eecs_deferred_op_t*
+eecs_alloc_deferred_op(eecs_world_t* world, eecs_deferred_op_type_t type, eecs_entity_t handle) {
+	eecs_deferred_op_t* op = eecs_arena_alloc(
+		world,
+		eecs_deferred_arena(world),
+		sizeof(eecs_deferred_op_t),
+		_Alignof(eecs_deferred_op_t)
+	);
+	*op = (eecs_deferred_op_t){
+		.type = type,
+		.handle = handle,
+	};
+
+	eecs_deferred_op_t** first_deferred_ops = &world->first_deferred_ops;
+	eecs_deferred_op_t** last_deferred_ops = &world->last_deferred_ops;
+	if (world->parallel_update) {
+		eecs_parallel_task_t* task = eecs_current_worker(world)->current_task;
+		first_deferred_ops = &task->first_deferred_ops;
+		last_deferred_ops = &task->last_deferred_ops;
+	}
+
+	if (*first_deferred_ops == NULL) {
+		*first_deferred_ops = op;
+	}
+
+	if (*last_deferred_ops != NULL) {
+		(*last_deferred_ops)->next = op;
+	}
+	*last_deferred_ops = op;
+
+	return op;
+}
+
+EECS_PRIVATE void
 eecs_parse_component_init(
 	eecs_world_t* world,
 	const eecs_component_init_t* init,
@@ -1196,11 +3666,13 @@ eecs_parse_component_init(
 		_Alignof(eecs_component_init_t)
 	);
 
-	// Dedupe
+	// Dedupe, sparse components are added once the entity exists
+	bool has_sparse_components = eecs_array_length(world->sparse_components) > 0;
 	eecs_id_t num_new_components = 0;
 	for (eecs_id_t i = 0; i < num_inits; ++i) {
 		eecs_id_t bit_index = eecs_index_of(init[i].component);
 		if (eecs_bitset_is_set(bitset, bit_index)) { continue; }
+		if (has_sparse_components && eecs_is_sparse_component(world->ecs, init[i].component)) { continue; }
 
 		eecs_bitset_set(bitset, bit_index);
 		init_copy[num_new_components++] = init[i];
@@ -1245,18 +3717,20 @@ eecs_insert_entity_into_table(
 
 	char* chunk;
 	if (chunk_index >= eecs_array_length(table->chunks)) {
-		chunk = eecs_allocate_chunk(world);
-		eecs_array_push(world->options.memctx, table->chunks, chunk);
+		chunk = eecs_push_table_chunk(world, table);
 	} else {
-		chunk = table->chunks[chunk_index];
+		chunk = eecs_own_chunk(world, table, chunk_index);
 	}
 
+	eecs_mark_rows_changed(world, table, pos_in_table, 1);
+
 	// Write entity data into chunk
 	eecs_id_t* entity_ids = (eecs_id_t*)chunk;
 	entity_ids[pos_in_chunk] = entity_from_1_index;
 	const ptrdiff_t* component_storage_offsets = table->component_storage_offsets;
 	const size_t* component_sizes = table->component_sizes;
-	for (eecs_id_t i = 0; i < table->signature.length; ++i) {
+	for (eecs_id_t j = 0; j < table->num_data_columns; ++j) {
+		eecs_id_t i = table->data_columns[j];
 		size_t component_size = component_sizes[i];
 
 		char* component_data = chunk
@@ -1270,6 +3744,9 @@ eecs_insert_entity_into_table(
 			memcpy(component_data, init_data, component_size);
 		}
 	}
+	for (eecs_id_t j = 0; j < table->num_enableable_columns; ++j) {
+		eecs_set_rows_enabled(table, table->enableable_columns[j], pos_in_table, 1, true);
+	}
 
 	*pos_in_table_out = pos_in_table;
 	*chunk_out = chunk;
@@ -1282,25 +3759,20 @@ eecs_create_entity_for_table(
 	eecs_table_t* table,
 	const eecs_component_init_t* init
 ) {
-	void* memctx = world->options.memctx;
+	eecs_own_entities(world);
 
-	eecs_entity_t entity_handle;
-	eecs_entity_data_t* entity_data;
-	if (world->next_free_entity_slot == 0) {
-		eecs_array_push(memctx, world->entities, (eecs_entity_data_t){ 0 });
-		eecs_id_t from_1_index = eecs_array_length(world->entities);
-		entity_data = &world->entities[from_1_index - 1];
-		entity_handle.from_1_index = from_1_index;
-		entity_handle.gen = 0;
-	} else {
-		eecs_id_t from_1_index = world->next_free_entity_slot;
-		entity_data = &world->entities[from_1_index - 1];
-		world->next_free_entity_slot = entity_data->pos_in_table;
-		entity_handle.from_1_index = from_1_index;
-		entity_handle.gen = entity_data->gen;
+	eecs_id_t from_1_index = eecs_pop_free_entity_slot(world);
+	if (from_1_index == 0) {
+		from_1_index = eecs_grow_entity_slots(world, 1);
 	}
+	eecs_entity_data_t* entity_data = eecs_entity_slot(world, from_1_index);
+	eecs_entity_t entity_handle = {
+		.from_1_index = from_1_index,
+		.gen = entity_data->gen,
+	};
 
 	entity_data->table = table;
+	eecs_stat_add(world->stats, num_entities_created, 1);
 	char* chunk;
 	eecs_id_t pos_in_chunk;
 	eecs_insert_entity_into_table(
@@ -1327,93 +3799,273 @@ eecs_create_entity_for_table(
 }
 
 EECS_PRIVATE void
-eecs_morph_entity_now(
+eecs_fill_components(
+	char* dst,
+	const eecs_component_init_t* init,
+	size_t component_size,
+	eecs_id_t first_entity,
+	eecs_id_t num_entities
+) {
+	size_t total_size = component_size * (size_t)num_entities;
+	if (init->data == NULL) {
+		memset(dst, 0, total_size);
+	} else if (init->per_entity) {
+		memcpy(dst, (const char*)init->data + component_size * (size_t)first_entity, total_size);
+	} else if (total_size > 0) {
+		// Broadcast by doubling the filled range
+		memcpy(dst, init->data, component_size);
+		for (size_t filled = component_size; filled < total_size; filled *= 2) {
+			memcpy(dst + filled, dst, eecs_min(filled, total_size - filled));
+		}
+	}
+}
+
+EECS_PRIVATE void
+eecs_create_entities_for_table(
 	eecs_world_t* world,
-	eecs_entity_data_t* entity_data,
-	const eecs_component_init_t* new_components,
-	const eecs_component_t* removed_components
+	eecs_table_t* table,
+	const eecs_component_init_t* init,
+	eecs_id_t count,
+	eecs_entity_t* handles_out
 ) {
-	eecs_id_t from_1_index = entity_data - world->entities + 1;
-	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
-	eecs_table_t* table = entity_data->table;
-	eecs_entity_t handle = {
-		.from_1_index = from_1_index,
-		.gen = entity_data->gen,
-	};
+	eecs_id_t first_pos_in_table = table->num_entities;
+	eecs_stat_add(world->stats, num_entities_created, count);
+	eecs_own_entities(world);
+
+	// Reuse free slots then grow the directory once for the rest
+	eecs_id_t num_reused = 0;
+	for (; num_reused < count; ++num_reused) {
+		eecs_id_t from_1_index = eecs_pop_free_entity_slot(world);
+		if (from_1_index == 0) { break; }
+
+		handles_out[num_reused] = (eecs_entity_t){
+			.from_1_index = from_1_index,
+			.gen = eecs_entity_slot(world, from_1_index)->gen,
+		};
+	}
 
-	eecs_id_t num_new_components = eecs_component_init_list_length(new_components);
-	eecs_id_t num_removed_components = eecs_component_list_length(removed_components);
-	eecs_id_t num_available_components = eecs_array_length(world->ecs->components);
+	if (num_reused < count) {
+		eecs_id_t first_from_1_index = eecs_grow_entity_slots(world, count - num_reused);
+		for (eecs_id_t i = num_reused; i < count; ++i) {
+			handles_out[i] = (eecs_entity_t){
+				.from_1_index = first_from_1_index + (i - num_reused),
+				.gen = world->new_entity_gen,
+			};
+		}
+	}
 
-	eecs_bitset_t* remove_bitset = eecs_arena_alloc(
-		world, &world->tmp_arena,
-		eecs_bitset_memory_size(num_available_components),
-		_Alignof(eecs_bitset_t)
-	);
-	eecs_bitset_init(remove_bitset, num_available_components);
-	for (eecs_id_t i = 0; i < num_removed_components; ++i) {
-		eecs_bitset_set(remove_bitset, eecs_index_of(removed_components[i]));
+	for (eecs_id_t i = 0; i < count; ++i) {
+		eecs_entity_data_t* entity_data = eecs_entity_slot(world, handles_out[i].from_1_index);
+		entity_data->gen = handles_out[i].gen;
+		entity_data->table = table;
+		entity_data->pos_in_table = first_pos_in_table + i;
 	}
 
-	eecs_bitset_t* add_bitset = eecs_arena_alloc(
-		world, &world->tmp_arena,
-		eecs_bitset_memory_size(num_available_components),
-		_Alignof(eecs_bitset_t)
-	);
-	eecs_bitset_init(add_bitset, num_available_components);
-	eecs_component_init_t* init_data = eecs_arena_alloc(
-		world, &world->tmp_arena,
-		sizeof(eecs_component_init_t) * (num_new_components + entity_data->table->signature.length),
-		_Alignof(eecs_component_init_t)
-	);
-	eecs_id_t new_sig_length = 0;
+	// Reserve chunks
+	eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+	table->num_entities += count;
+	eecs_id_t num_chunks = (table->num_entities + num_entities_per_chunk - 1) / num_entities_per_chunk;
+	while (eecs_array_length(table->chunks) < num_chunks) {
+		eecs_push_table_chunk(world, table);
+	}
+	eecs_mark_rows_changed(world, table, first_pos_in_table, count);
 
-	eecs_id_t pos_in_table = entity_data->pos_in_table;
-	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
-	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
-	char* chunk = table->chunks[chunk_index];
-	for (eecs_id_t i = 0; i < table->signature.length; ++i) {
-		eecs_id_t component_index = eecs_index_of(table->signature.components[i]);
-		if (eecs_bitset_is_set(remove_bitset, component_index)) { continue; }
+	// Write each column of each chunk at once
+	const ptrdiff_t* component_storage_offsets = table->component_storage_offsets;
+	const size_t* component_sizes = table->component_sizes;
+	for (eecs_id_t num_written = 0; num_written < count;) {
+		eecs_id_t pos_in_table = first_pos_in_table + num_written;
+		eecs_id_t pos_in_chunk = pos_in_table % num_entities_per_chunk;
+		eecs_id_t num_entities = eecs_min(count - num_written, num_entities_per_chunk - pos_in_chunk);
+		char* chunk = eecs_own_chunk(world, table, pos_in_table / num_entities_per_chunk);
+
+		eecs_id_t* entity_ids = (eecs_id_t*)chunk + pos_in_chunk;
+		for (eecs_id_t i = 0; i < num_entities; ++i) {
+			entity_ids[i] = handles_out[num_written + i].from_1_index;
+		}
 
-		char* component_data = chunk
-			+ table->component_storage_offsets[i]
-			+ pos_in_chunk * table->component_sizes[i];
+		for (eecs_id_t j = 0; j < table->num_data_columns; ++j) {
+			eecs_id_t i = table->data_columns[j];
+			size_t component_size = component_sizes[i];
+			eecs_fill_components(
+				chunk + component_storage_offsets[i] + pos_in_chunk * component_size,
+				&init[i],
+				component_size,
+				num_written,
+				num_entities
+			);
+		}
+		for (eecs_id_t j = 0; j < table->num_enableable_columns; ++j) {
+			eecs_set_rows_enabled(table, table->enableable_columns[j], pos_in_table, num_entities, true);
+		}
 
-		eecs_bitset_set(add_bitset, component_index);
-		init_data[new_sig_length++] = (eecs_component_init_t){
-			.component = table->signature.components[i],
-			.data = component_data,
-		};
+		num_written += num_entities;
 	}
 
-	for (eecs_id_t i = 0; i < num_new_components; ++i) {
-		eecs_id_t component_index = eecs_index_of(new_components[i].component);
-		if (eecs_bitset_is_set(remove_bitset, component_index)) { continue; }
-		if (eecs_bitset_is_set(add_bitset, component_index)) { continue; }
+	// Run each callback over all new entities.
+	// Callbacks may change the world so positions are looked up again.
+	eecs_array_indexed_foreach(eecs_component_entity_callback_t, itr, table->component_init_callbacks) {
+		for (eecs_id_t i = 0; i < count; ++i) {
+			eecs_entity_data_t* entity_data = eecs_get_entity_data(world, handles_out[i]);
+			if (entity_data == NULL || entity_data->table != table) { continue; }
 
-		eecs_bitset_set(add_bitset, component_index);
-		init_data[new_sig_length++] = new_components[i];
+			eecs_id_t pos_in_table = entity_data->pos_in_table;
+			char* component_data = eecs_own_chunk(world, table, pos_in_table / num_entities_per_chunk)
+				+ component_storage_offsets[itr.value->signature_index]
+				+ (pos_in_table % num_entities_per_chunk) * component_sizes[itr.value->signature_index];
+
+			itr.value->fn(world, handles_out[i], component_data, itr.value->userdata);
+		}
 	}
 
-	eecs_insertion_sort(
-		new_sig_length, init_data,
-		eecs_component_init_t, eecs_component_init_cmp_lt
+	eecs_array_indexed_foreach(eecs_system_entity_callback_t, itr, table->system_init_callbacks) {
+		for (eecs_id_t i = 0; i < count; ++i) {
+			eecs_entity_data_t* entity_data = eecs_get_entity_data(world, handles_out[i]);
+			if (entity_data == NULL || entity_data->table != table) { continue; }
+
+			itr.value->fn(world, handles_out[i], itr.value->userdata);
+		}
+	}
+}
+
+EECS_PRIVATE eecs_table_edge_t*
+eecs_find_table_edge(eecs_array(eecs_table_edge_t) edges, eecs_component_t component) {
+	eecs_array_indexed_foreach(eecs_table_edge_t, itr, edges) {
+		if (itr.value->component.from_1_index == component.from_1_index) {
+			return itr.value;
+		}
+	}
+
+	return NULL;
+}
+
+EECS_PRIVATE eecs_id_t*
+eecs_build_column_map(
+	eecs_world_t* world,
+	const eecs_table_t* from_table,
+	const eecs_table_t* to_table
+) {
+	// Both signatures are sorted so they can be merged in one pass
+	eecs_id_t* column_map = eecs_malloc(
+		world->options.memctx, sizeof(eecs_id_t) * eecs_max(to_table->signature.length, 1)
+	);
+	eecs_id_t from_index = 0;
+	for (eecs_id_t i = 0; i < to_table->signature.length; ++i) {
+		eecs_id_t component = to_table->signature.components[i].from_1_index;
+		while (
+			from_index < from_table->signature.length
+			&& from_table->signature.components[from_index].from_1_index < component
+		) {
+			++from_index;
+		}
+
+		column_map[i] = from_index < from_table->signature.length
+			&& from_table->signature.components[from_index].from_1_index == component
+			? from_index
+			: -1;
+	}
+
+	return column_map;
+}
+
+EECS_PRIVATE void
+eecs_add_table_edge(
+	eecs_world_t* world,
+	eecs_array(eecs_table_edge_t)* edges,
+	eecs_component_t component,
+	const eecs_table_t* from_table,
+	eecs_table_t* to_table
+) {
+	eecs_array(eecs_table_edge_t) edge_array = *edges;
+	eecs_array_push(world->options.memctx, edge_array, ((eecs_table_edge_t){
+		.component = component,
+		.table = to_table,
+		.column_map = eecs_build_column_map(world, from_table, to_table),
+	}));
+	*edges = edge_array;
+}
+
+EECS_PRIVATE eecs_table_edge_t*
+eecs_get_table_edge(
+	eecs_world_t* world,
+	eecs_table_t* table,
+	eecs_component_t component,
+	bool add
+) {
+	eecs_table_edge_t* edge = eecs_find_table_edge(
+		add ? table->add_edges : table->remove_edges,
+		component
 	);
+	if (edge != NULL) { return edge; }
+
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
 	eecs_component_t* components = eecs_arena_alloc(
 		world, &world->tmp_arena,
-		sizeof(eecs_component_t) * new_sig_length,
+		sizeof(eecs_component_t) * (table->signature.length + 1),
 		_Alignof(eecs_component_t)
 	);
-	for (eecs_id_t i = 0; i < new_sig_length; ++i) {
-		components[i] = init_data[i].component;
+
+	bool has_component = eecs_bitset_is_set(table->bitset, eecs_index_of(component));
+	eecs_id_t new_sig_length = 0;
+	if (add && !has_component) {
+		bool inserted = false;
+		for (eecs_id_t i = 0; i < table->signature.length; ++i) {
+			if (!inserted && component.from_1_index < table->signature.components[i].from_1_index) {
+				components[new_sig_length++] = component;
+				inserted = true;
+			}
+			components[new_sig_length++] = table->signature.components[i];
+		}
+		if (!inserted) { components[new_sig_length++] = component; }
+	} else if (!add && has_component) {
+		for (eecs_id_t i = 0; i < table->signature.length; ++i) {
+			if (table->signature.components[i].from_1_index != component.from_1_index) {
+				components[new_sig_length++] = table->signature.components[i];
+			}
+		}
+	} else {
+		memcpy(components, table->signature.components, sizeof(eecs_component_t) * table->signature.length);
+		new_sig_length = table->signature.length;
 	}
-	eecs_signature_t new_signature = {
+
+	eecs_table_t* new_table = eecs_get_table(world, (eecs_signature_t){
 		.components = components,
 		.length = new_sig_length,
-	};
+	});
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
 
-	eecs_table_t* new_table = eecs_get_table(world, new_signature);
+	if (add) {
+		eecs_add_table_edge(world, &table->add_edges, component, table, new_table);
+		// Also record the reverse edge since it is known
+		if (new_table != table && eecs_find_table_edge(new_table->remove_edges, component) == NULL) {
+			eecs_add_table_edge(world, &new_table->remove_edges, component, new_table, table);
+		}
+		return &eecs_array_back(table->add_edges);
+	} else {
+		eecs_add_table_edge(world, &table->remove_edges, component, table, new_table);
+		if (new_table != table && eecs_find_table_edge(new_table->add_edges, component) == NULL) {
+			eecs_add_table_edge(world, &new_table->add_edges, component, new_table, table);
+		}
+		return &eecs_array_back(table->remove_edges);
+	}
+}
+
+EECS_PRIVATE void
+eecs_move_entity_to_table(
+	eecs_world_t* world,
+	eecs_entity_t handle,
+	eecs_table_t* new_table,
+	const eecs_component_init_t* init_data
+) {
+	eecs_id_t from_1_index = handle.from_1_index;
+	eecs_own_entities(world);
+	eecs_entity_data_t* entity_data = eecs_entity_slot(world, from_1_index);
+	eecs_table_t* table = entity_data->table;
+
+	eecs_id_t pos_in_table = entity_data->pos_in_table;
+	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
+	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
+	char* chunk = eecs_own_chunk(world, table, chunk_index);
 
 	// Call clean up for systems present in the old table but not the new table
 	eecs_array_indexed_foreach_rev(
@@ -1441,18 +4093,29 @@ eecs_morph_entity_now(
 	}
 
 	// Copy data to new table
-	entity_data = &world->entities[from_1_index - 1];
+	entity_data = eecs_entity_slot(world, from_1_index);
 	char* new_chunk;
 	eecs_id_t new_pos_in_table, new_pos_in_chunk;
 	eecs_insert_entity_into_table(
 		world, new_table, from_1_index, init_data,
 		&new_pos_in_table, &new_chunk, &new_pos_in_chunk
 	);
-	entity_data->table = new_table;
-	entity_data->pos_in_table = new_pos_in_table;
+	// Components which stay keep their enable bits
+	for (eecs_id_t j = 0; j < new_table->num_enableable_columns; ++j) {
+		eecs_id_t i = new_table->enableable_columns[j];
+		eecs_id_t column = eecs_find_column(table, new_table->signature.components[i]);
+		if (column >= 0) {
+			eecs_copy_enable_bits(new_table, i, new_pos_in_table, table, column, pos_in_table, 1);
+		}
+	}
 
-	// Delete the old entity slot in the old chunk
+	// Delete the old entity slot in the old chunk.
+	// This must happen before updating the entity's position since it may be
+	// the last entity in the old table.
 	eecs_delete_entity_from_table(world, table, pos_in_table);
+	entity_data->table = new_table;
+	entity_data->pos_in_table = new_pos_in_table;
+	eecs_stat_add(world->stats, num_entities_morphed, 1);
 
 	// Call init for components present in the new table but not the old table
 	eecs_array_indexed_foreach(
@@ -1478,457 +4141,4310 @@ eecs_morph_entity_now(
 			itr.value->fn(world, handle, itr.value->userdata);
 		}
 	}
+}
+
+EECS_PRIVATE void
+eecs_morph_entity_along_edge(
+	eecs_world_t* world,
+	eecs_entity_t handle,
+	eecs_component_t component,
+	const void* component_init_data,
+	bool add
+) {
+	eecs_entity_data_t* entity_data = eecs_entity_slot(world, handle.from_1_index);
+	eecs_table_t* table = entity_data->table;
+	eecs_table_edge_t* edge = eecs_get_table_edge(world, table, component, add);
+	eecs_table_t* new_table = edge->table;
+	// Adding an existing component or removing a missing one is a no-op
+	if (new_table == table) { return; }
+
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+	eecs_component_init_t* init_data = eecs_arena_alloc(
+		world, &world->tmp_arena,
+		sizeof(eecs_component_init_t) * new_table->signature.length,
+		_Alignof(eecs_component_init_t)
+	);
+
+	eecs_id_t pos_in_table = entity_data->pos_in_table;
+	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
+	// Owned now so that it is not copied away from under init_data
+	char* chunk = eecs_own_chunk(world, table, pos_in_table / table->num_entities_per_chunk);
+	const eecs_id_t* column_map = edge->column_map;
+	for (eecs_id_t j = 0; j < new_table->num_data_columns; ++j) {
+		eecs_id_t i = new_table->data_columns[j];
+		eecs_id_t column = column_map[i];
+		init_data[i] = (eecs_component_init_t){
+			.component = new_table->signature.components[i],
+			.data = column >= 0
+				? chunk
+					+ table->component_storage_offsets[column]
+					+ pos_in_chunk * table->component_sizes[column]
+				: component_init_data,
+		};
+	}
+
+	eecs_move_entity_to_table(world, handle, new_table, init_data);
 
 	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
 }
 
 EECS_PRIVATE void
-eecs_do_run_system(
+eecs_morph_entity_in_tables(
 	eecs_world_t* world,
-	const eecs_system_options_t* system_options,
-	eecs_system_data_t* system_data
+	eecs_entity_t handle,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
 ) {
-	if (system_options->pre_update_fn) {
-		system_options->pre_update_fn(world, system_options->userdata);
+	eecs_id_t num_new_components = eecs_component_init_list_length(new_components);
+	eecs_id_t num_removed_components = eecs_component_list_length(removed_components);
+
+	// Single component changes follow the cached transition graph
+	if (num_new_components == 1 && num_removed_components == 0) {
+		eecs_morph_entity_along_edge(
+			world, handle,
+			new_components[0].component, new_components[0].data,
+			true
+		);
+		return;
+	} else if (num_new_components == 0 && num_removed_components == 1) {
+		eecs_morph_entity_along_edge(
+			world, handle,
+			removed_components[0], NULL,
+			false
+		);
+		return;
 	}
 
-	eecs_array_indexed_foreach(
-		eecs_system_table_match_t,
-		match_itr,
-		system_data->matched_tables
-	) {
-		eecs_table_t* table = match_itr.value->table;
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+	eecs_entity_data_t* entity_data = eecs_entity_slot(world, handle.from_1_index);
+	eecs_table_t* table = entity_data->table;
+	eecs_id_t num_available_components = eecs_array_length(world->ecs->components);
 
-		eecs_arena_reset(world, &world->deferred_arena);
-		world->first_deferred_ops = world->last_deferred_ops = NULL;
-		world->current_update_table = table;
+	eecs_bitset_t* remove_bitset = eecs_arena_alloc(
+		world, &world->tmp_arena,
+		eecs_bitset_memory_size(num_available_components),
+		_Alignof(eecs_bitset_t)
+	);
+	eecs_bitset_init(remove_bitset, num_available_components);
+	for (eecs_id_t i = 0; i < num_removed_components; ++i) {
+		eecs_bitset_set(remove_bitset, eecs_index_of(removed_components[i]));
+	}
 
-		ptrdiff_t* component_storage_offsets = match_itr.value->component_storage_offsets;
-		eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+	eecs_bitset_t* add_bitset = eecs_arena_alloc(
+		world, &world->tmp_arena,
+		eecs_bitset_memory_size(num_available_components),
+		_Alignof(eecs_bitset_t)
+	);
+	eecs_bitset_init(add_bitset, num_available_components);
+	eecs_component_init_t* init_data = eecs_arena_alloc(
+		world, &world->tmp_arena,
+		sizeof(eecs_component_init_t) * (num_new_components + entity_data->table->signature.length),
+		_Alignof(eecs_component_init_t)
+	);
+	eecs_id_t new_sig_length = 0;
 
-		eecs_array_indexed_foreach(char*, chunk_itr, table->chunks) {
-			eecs_id_t last_chunk_index = eecs_array_length(table->chunks) - 1;
-			eecs_id_t num_entities_in_last_chunk = table->num_entities % num_entities_per_chunk;
-			eecs_batch_t batch = {
-				.world = world,
-				.chunk = *chunk_itr.value,
-				.offsets = component_storage_offsets,
-				.size = chunk_itr.index == last_chunk_index
-					? num_entities_in_last_chunk
-					: num_entities_per_chunk,
-			};
+	eecs_id_t pos_in_table = entity_data->pos_in_table;
+	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
+	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
+	char* chunk = eecs_own_chunk(world, table, chunk_index);
+	for (eecs_id_t i = 0; i < table->signature.length; ++i) {
+		eecs_id_t component_index = eecs_index_of(table->signature.components[i]);
+		if (eecs_bitset_is_set(remove_bitset, component_index)) { continue; }
 
-			system_options->update_fn(world, batch, system_options->userdata);
-		}
+		char* component_data = chunk
+			+ table->component_storage_offsets[i]
+			+ pos_in_chunk * table->component_sizes[i];
 
-		for (
-			eecs_deferred_op_t* op = world->first_deferred_ops;
-			op != NULL;
-			op = op->next
-		) {
-			eecs_entity_data_t* entity_data = eecs_get_entity_data(world, op->handle);
-			if (entity_data == NULL) { continue; }
+		eecs_bitset_set(add_bitset, component_index);
+		init_data[new_sig_length++] = (eecs_component_init_t){
+			.component = table->signature.components[i],
+			.data = component_data,
+		};
+	}
 
-			switch (op->type) {
-				case EECS_DESTROY_ENTITY:
-					eecs_destroy_entity_now(world, entity_data);
-					break;
-				case EECS_MORPH_ENTITY:
-					eecs_morph_entity_now(
-						world, entity_data,
-						op->new_components, op->removed_components
-					);
-					break;
-			}
-		}
+	for (eecs_id_t i = 0; i < num_new_components; ++i) {
+		eecs_id_t component_index = eecs_index_of(new_components[i].component);
+		if (eecs_bitset_is_set(remove_bitset, component_index)) { continue; }
+		if (eecs_bitset_is_set(add_bitset, component_index)) { continue; }
+
+		eecs_bitset_set(add_bitset, component_index);
+		init_data[new_sig_length++] = new_components[i];
 	}
-	world->current_update_table = NULL;
 
-	if (system_options->post_update_fn) {
-		system_options->post_update_fn(world, system_options->userdata);
+	eecs_insertion_sort(
+		new_sig_length, init_data,
+		eecs_component_init_t, eecs_component_init_cmp_lt
+	);
+	eecs_component_t* components = eecs_arena_alloc(
+		world, &world->tmp_arena,
+		sizeof(eecs_component_t) * new_sig_length,
+		_Alignof(eecs_component_t)
+	);
+	for (eecs_id_t i = 0; i < new_sig_length; ++i) {
+		components[i] = init_data[i].component;
 	}
+	eecs_signature_t new_signature = {
+		.components = components,
+		.length = new_sig_length,
+	};
+
+	eecs_table_t* new_table = eecs_get_table(world, new_signature);
+	eecs_move_entity_to_table(world, handle, new_table, init_data);
+
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
 }
 
-// Public
+EECS_PRIVATE void
+eecs_morph_entity_now(
+	eecs_world_t* world,
+	eecs_entity_t handle,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+) {
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+	const eecs_component_init_t* table_new_components = new_components;
+	const eecs_component_t* table_removed_components = removed_components;
+	if (!eecs_split_sparse_morph(world, &table_new_components, &table_removed_components)) {
+		eecs_morph_entity_in_tables(world, handle, new_components, removed_components);
+		return;
+	}
 
-eecs_t*
-eecs_create(eecs_options_t options) {
-	eecs_t* ecs = eecs_malloc(options.memctx, sizeof(eecs_t));
-	*ecs = (eecs_t){
-		.options = options,
-	};
+	eecs_morph_sparse_components(world, handle, new_components, removed_components);
 
-	return ecs;
+	if (
+		eecs_get_entity_data(world, handle) != NULL
+		&& (table_new_components[0].component.from_1_index != 0 || table_removed_components[0].from_1_index != 0)
+	) {
+		eecs_morph_entity_in_tables(world, handle, table_new_components, table_removed_components);
+	}
+
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
 }
 
-void
-eecs_destroy(eecs_t* ecs) {
-	void* memctx = ecs->options.memctx;
+typedef struct eecs_bulk_entry_s {
+	eecs_table_t* table;
+	// Table index then position, the sort order
+	uint64_t key;
+	eecs_id_t pos_in_table;
+	eecs_id_t from_1_index;
+} eecs_bulk_entry_t;
 
-	eecs_array_free(memctx, ecs->systems);
-	eecs_array_free(memctx, ecs->components);
-	eecs_free(memctx, ecs);
+EECS_PRIVATE eecs_id_t
+eecs_apply_deferred_ops(eecs_world_t* world, eecs_deferred_op_t* first_op);
+
+EECS_PRIVATE bool
+eecs_is_deferring(const eecs_world_t* world) {
+	return world->parallel_update
+		|| world->bulk_depth > 0
+		|| world->current_update_table != NULL;
 }
 
-void
-eecs_register_component(
-	eecs_t* ecs,
-	eecs_component_t* handle,
-	eecs_component_options_t options
-) {
-	void* memctx = ecs->options.memctx;
-	EECS_ASSERT(options.alignment > 0, "Invalid alignment");
-	if (handle->from_1_index == 0) {
-		eecs_array_push(memctx, ecs->components, options);
-		handle->from_1_index = eecs_array_length(ecs->components);
-	} else {
-		ecs->components[eecs_index_of(*handle)] = options;
-	}
+EECS_PRIVATE char*
+eecs_row_data(const eecs_table_t* table, eecs_id_t column, eecs_id_t pos_in_table) {
+	eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+	return table->chunks[pos_in_table / num_entities_per_chunk]
+		+ table->component_storage_offsets[column]
+		+ (pos_in_table % num_entities_per_chunk) * table->component_sizes[column];
+}
 
-	++ecs->version;
+// Like eecs_row_data for rows handed out to callbacks
+EECS_PRIVATE char*
+eecs_own_row_data(eecs_world_t* world, eecs_table_t* table, eecs_id_t column, eecs_id_t pos_in_table) {
+	eecs_own_rows(world, table, pos_in_table, 1);
+	return eecs_row_data(table, column, pos_in_table);
 }
 
-void
-eecs_register_system(
-	eecs_t* ecs,
-	eecs_system_t* handle,
-	eecs_system_options_t options
+EECS_PRIVATE eecs_id_t*
+eecs_row_id(const eecs_table_t* table, eecs_id_t pos_in_table) {
+	eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+	return (eecs_id_t*)table->chunks[pos_in_table / num_entities_per_chunk]
+		+ pos_in_table % num_entities_per_chunk;
+}
+
+// LSD radix sort by key, skipping the bytes which are the same in every key.
+// Returns whichever buffer holds the result.
+EECS_PRIVATE eecs_bulk_entry_t*
+eecs_radix_sort_bulk_entries(
+	eecs_bulk_entry_t* entries,
+	eecs_bulk_entry_t* tmp,
+	eecs_id_t count
 ) {
-	void* memctx = ecs->options.memctx;
-	if (handle->from_1_index == 0) {
-		eecs_array_push(memctx, ecs->systems, options);
-		handle->from_1_index = eecs_array_length(ecs->systems);
-	} else {
-		ecs->systems[eecs_index_of(*handle)] = options;
+	enum { NUM_DIGITS = sizeof(uint64_t) };
+	eecs_id_t histograms[NUM_DIGITS][256] = { 0 };
+	for (eecs_id_t i = 0; i < count; ++i) {
+		uint64_t key = entries[i].key;
+		for (int digit = 0; digit < NUM_DIGITS; ++digit) {
+			++histograms[digit][(key >> (digit * 8)) & 0xff];
+		}
 	}
 
-	++ecs->version;
-}
+	for (int digit = 0; digit < NUM_DIGITS; ++digit) {
+		eecs_id_t* histogram = histograms[digit];
+		if (histogram[(entries[0].key >> (digit * 8)) & 0xff] == count) { continue; }
 
-eecs_world_t*
-eecs_create_world(eecs_t* ecs, eecs_world_options_t options) {
-	options.memctx = options.memctx != NULL ? options.memctx : ecs->options.memctx;
-	options.table_chunk_memctx = options.table_chunk_memctx != NULL
-		? options.table_chunk_memctx
-		: options.memctx;
-	options.table_chunk_size = options.table_chunk_size > 0
-		? options.table_chunk_size
-		: EECS_DEFAULT_TABLE_CHUNK_SIZE;
+		eecs_id_t offset = 0;
+		for (int i = 0; i < 256; ++i) {
+			eecs_id_t bucket_size = histogram[i];
+			histogram[i] = offset;
+			offset += bucket_size;
+		}
 
-	eecs_world_t* world = eecs_malloc(options.memctx, sizeof(eecs_world_t));
+		for (eecs_id_t i = 0; i < count; ++i) {
+			tmp[histogram[(entries[i].key >> (digit * 8)) & 0xff]++] = entries[i];
+		}
 
-	*world = (eecs_world_t){
-		.ecs = ecs,
-		.options = options,
-	};
+		eecs_bulk_entry_t* swap = entries;
+		entries = tmp;
+		tmp = swap;
+	}
 
-	eecs_sync_world(world);
+	return entries;
+}
 
-	return world;
+EECS_PRIVATE int
+eecs_count_trailing_zeros(uint64_t bits) {
+	static const uint8_t positions[64] = {
+		0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+		62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+		63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+		46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6,
+	};
+	return positions[((bits & (~bits + 1)) * UINT64_C(0x03f79d71b4cb0a89)) >> 58];
 }
 
-void
-eecs_destroy_world(eecs_world_t* world) {
+// Resolve, sort and dedupe the handles by table then row.
+// When the handles cover a good part of their tables, rows are marked in a
+// bitmap per table and read back in order. Otherwise they are radix sorted.
+EECS_PRIVATE eecs_id_t
+eecs_collect_bulk_entries(
+	eecs_world_t* world,
+	const eecs_entity_t* handles,
+	eecs_id_t count,
+	eecs_bulk_entry_t* entries_out
+) {
 	void* memctx = world->options.memctx;
-	const eecs_t* ecs = world->ecs;
-
-	// Destroy all entities
-	eecs_array_indexed_foreach(eecs_table_t*, table_itr, world->tables) {
-		eecs_table_t* table = *table_itr.value;
-		eecs_id_t last_chunk_index = eecs_array_length(table->chunks) - 1;
-		eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
-		eecs_id_t num_entities_in_last_chunk = table->num_entities % num_entities_per_chunk;
-		const ptrdiff_t* component_storage_offsets = table->component_storage_offsets;
-		const size_t* component_sizes = table->component_sizes;
+	eecs_id_t num_tables = eecs_array_length(world->tables);
+	// Word offset of each table's bitmap, -1 for untouched tables
+	eecs_id_t* bitmap_offsets = eecs_malloc(memctx, sizeof(eecs_id_t) * eecs_max(num_tables, 1));
+	for (eecs_id_t i = 0; i < num_tables; ++i) { bitmap_offsets[i] = -1; }
+
+	eecs_id_t num_entries = 0;
+	for (eecs_id_t i = 0; i < count; ++i) {
+		const eecs_entity_data_t* entity_data = eecs_get_entity_data(world, handles[i]);
+		if (entity_data == NULL) { continue; }
+
+		eecs_table_t* table = entity_data->table;
+		bitmap_offsets[table->index] = 0;
+		entries_out[num_entries++] = (eecs_bulk_entry_t){
+			.table = table,
+			.key = ((uint64_t)table->index << 32) | (uint32_t)entity_data->pos_in_table,
+			.pos_in_table = entity_data->pos_in_table,
+			.from_1_index = handles[i].from_1_index,
+		};
+	}
 
-		eecs_array_indexed_foreach(char*, chunk_itr, table->chunks) {
-			char* chunk = *chunk_itr.value;
+	eecs_id_t num_words = 0;
+	for (eecs_id_t i = 0; i < num_tables; ++i) {
+		if (bitmap_offsets[i] < 0) { continue; }
 
-			eecs_id_t num_entities = chunk_itr.index == last_chunk_index
-				? num_entities_in_last_chunk
-				: num_entities_per_chunk;
+		bitmap_offsets[i] = num_words;
+		num_words += (world->tables[i]->num_entities + 63) / 64;
+	}
 
-			eecs_id_t* entity_ids = (eecs_id_t*)chunk;
-			for (eecs_id_t i = 0; i < num_entities; ++i) {
-				eecs_id_t from_1_index = entity_ids[i];
-				eecs_entity_t handle = {
-					.from_1_index = from_1_index,
-					.gen = world->entities[from_1_index - 1].gen,
-				};
+	eecs_id_t num_unique_entries = 0;
+	if (num_words <= num_entries) {
+		uint64_t* bitmaps = eecs_malloc(memctx, sizeof(uint64_t) * eecs_max(num_words, 1));
+		memset(bitmaps, 0, sizeof(uint64_t) * num_words);
+		for (eecs_id_t i = 0; i < num_entries; ++i) {
+			eecs_id_t pos_in_table = entries_out[i].pos_in_table;
+			bitmaps[bitmap_offsets[entries_out[i].table->index] + pos_in_table / 64] |= UINT64_C(1) << (pos_in_table % 64);
+		}
 
-				eecs_array_indexed_foreach_rev(
-					eecs_system_entity_callback_t, itr, table->system_cleanup_callbacks
-				) {
-					itr.value->fn(world, handle, itr.value->userdata);
+		for (eecs_id_t i = 0; i < num_tables; ++i) {
+			if (bitmap_offsets[i] < 0) { continue; }
+
+			eecs_table_t* table = world->tables[i];
+			const uint64_t* bitmap = &bitmaps[bitmap_offsets[i]];
+			eecs_id_t table_num_words = (table->num_entities + 63) / 64;
+			for (eecs_id_t word_index = 0; word_index < table_num_words; ++word_index) {
+				for (uint64_t word = bitmap[word_index]; word != 0; word &= word - 1) {
+					eecs_id_t pos_in_table = word_index * 64 + eecs_count_trailing_zeros(word);
+					entries_out[num_unique_entries++] = (eecs_bulk_entry_t){
+						.table = table,
+						.key = ((uint64_t)i << 32) | (uint32_t)pos_in_table,
+						.pos_in_table = pos_in_table,
+						.from_1_index = *eecs_row_id(table, pos_in_table),
+					};
 				}
+			}
+		}
 
-				eecs_array_indexed_foreach_rev(
-					eecs_component_entity_callback_t, itr, table->component_cleanup_callbacks
-				) {
-					char* component_data = chunk
-						+ component_storage_offsets[itr.value->signature_index]
-						+ i * component_sizes[itr.value->signature_index];
+		eecs_free(memctx, bitmaps);
+	} else if (num_entries > 0) {
+		eecs_bulk_entry_t* tmp = eecs_malloc(memctx, sizeof(eecs_bulk_entry_t) * num_entries);
+		eecs_bulk_entry_t* sorted_entries = eecs_radix_sort_bulk_entries(entries_out, tmp, num_entries);
 
-					itr.value->fn(world, handle, component_data, itr.value->userdata);
-				}
+		for (eecs_id_t i = 0; i < num_entries; ++i) {
+			if (
+				num_unique_entries > 0
+				&& entries_out[num_unique_entries - 1].key == sorted_entries[i].key
+			) {
+				continue;
 			}
+			entries_out[num_unique_entries++] = sorted_entries[i];
 		}
+
+		eecs_free(memctx, tmp);
 	}
 
-	// Call cleanup on systems
-	eecs_array_indexed_foreach_rev(eecs_system_data_t, itr, world->system_data) {
-		eecs_system_options_t* system = &ecs->systems[itr.index];
-		if (system->cleanup_per_world_fn) {
-			system->cleanup_per_world_fn(world, system->userdata);
-		}
+	eecs_free(memctx, bitmap_offsets);
+	return num_unique_entries;
+}
 
-		eecs_array_free(memctx, itr.value->matched_tables);
-	}
-	eecs_array_free(memctx, world->system_data);
+EECS_PRIVATE eecs_id_t
+eecs_bulk_group_end(const eecs_bulk_entry_t* entries, eecs_id_t begin, eecs_id_t count) {
+	eecs_id_t end = begin + 1;
+	while (end < count && entries[end].table == entries[begin].table) { ++end; }
+	return end;
+}
 
-	eecs_array_free(memctx, world->entities);
+typedef struct eecs_bulk_scope_s {
+	eecs_deferred_op_t* first_deferred_ops;
+	eecs_deferred_op_t* last_deferred_ops;
+	eecs_arena_checkpoint_t deferred_checkpoint;
+} eecs_bulk_scope_t;
+
+// Structural changes made by callbacks during a bulk operation are queued
+// and applied once it is done
+EECS_PRIVATE eecs_bulk_scope_t
+eecs_begin_bulk(eecs_world_t* world) {
+	eecs_bulk_scope_t scope = {
+		.first_deferred_ops = world->first_deferred_ops,
+		.last_deferred_ops = world->last_deferred_ops,
+		.deferred_checkpoint = eecs_arena_checkpoint(world, &world->deferred_arena),
+	};
+	world->first_deferred_ops = world->last_deferred_ops = NULL;
+	++world->bulk_depth;
+	return scope;
+}
 
-	eecs_array_indexed_foreach(eecs_template_data_t, itr, world->templates) {
-		eecs_id_t signature_length = itr.value->table->signature.length;
-		for (eecs_id_t i = 0; i < signature_length; ++i) {
-			void* component_data = (void*)itr.value->init_data[i].data;
-			eecs_free(memctx, component_data);
-		}
-		eecs_free(memctx, itr.value->init_data);
+EECS_PRIVATE void
+eecs_end_bulk(eecs_world_t* world, eecs_bulk_scope_t scope) {
+	--world->bulk_depth;
+	eecs_deferred_op_t* first_op = world->first_deferred_ops;
+	world->first_deferred_ops = scope.first_deferred_ops;
+	world->last_deferred_ops = scope.last_deferred_ops;
+
+	eecs_apply_deferred_ops(world, first_op);
+	eecs_arena_rollback(world, &world->deferred_arena, scope.deferred_checkpoint);
+}
+
+EECS_PRIVATE void
+eecs_copy_rows_within_table(
+	eecs_world_t* world,
+	eecs_table_t* table,
+	eecs_id_t src_pos,
+	eecs_id_t dst_pos,
+	eecs_id_t num_rows
+) {
+	eecs_own_rows(world, table, dst_pos, num_rows);
+	memcpy(eecs_row_id(table, dst_pos), eecs_row_id(table, src_pos), sizeof(eecs_id_t) * num_rows);
+	for (eecs_id_t j = 0; j < table->num_data_columns; ++j) {
+		eecs_id_t i = table->data_columns[j];
+		memcpy(
+			eecs_row_data(table, i, dst_pos),
+			eecs_row_data(table, i, src_pos),
+			table->component_sizes[i] * num_rows
+		);
+	}
+	for (eecs_id_t j = 0; j < table->num_enableable_columns; ++j) {
+		eecs_id_t i = table->enableable_columns[j];
+		eecs_copy_enable_bits(table, i, dst_pos, table, i, src_pos, num_rows);
 	}
-	eecs_array_free(memctx, world->templates);
 
-	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
-		eecs_table_t* table = *itr.value;
+	const eecs_id_t* entity_ids = eecs_row_id(table, dst_pos);
+	for (eecs_id_t i = 0; i < num_rows; ++i) {
+		eecs_entity_slot(world, entity_ids[i])->pos_in_table = dst_pos + i;
+	}
+	eecs_mark_rows_changed(world, table, dst_pos, num_rows);
+}
 
-		eecs_free(memctx, (void*)table->signature.components);
-		eecs_free(memctx, table->component_storage_offsets);
-		eecs_free(memctx, table->component_sizes);
-		eecs_array_free(memctx, table->system_init_callbacks);
-		eecs_array_free(memctx, table->system_cleanup_callbacks);
-		eecs_array_free(memctx, table->component_init_callbacks);
-		eecs_array_free(memctx, table->component_cleanup_callbacks);
+// Remove the given rows, sorted by position, by moving the surviving rows at
+// the end of the table into the holes, one run of contiguous rows at a time
+EECS_PRIVATE void
+eecs_remove_rows_from_table(
+	eecs_world_t* world,
+	eecs_table_t* table,
+	const eecs_bulk_entry_t* entries,
+	eecs_id_t count
+) {
+	eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+	eecs_id_t new_num_entities = table->num_entities - count;
 
-		eecs_array_indexed_foreach(char*, chunk_itr, table->chunks) {
-			eecs_free(world->options.table_chunk_memctx, *chunk_itr.value);
-		}
-		eecs_array_free(memctx, table->chunks);
-		eecs_free(memctx, table->bitset);
-		eecs_free(memctx, table);
+	eecs_id_t num_holes = 0;
+	while (num_holes < count && entries[num_holes].pos_in_table < new_num_entities) {
+		++num_holes;
 	}
-	eecs_array_free(memctx, world->tables);
 
-	eecs_arena_reset(world, &world->version_arena);
-	eecs_arena_reset(world, &world->deferred_arena);
-	eecs_arena_reset(world, &world->tmp_arena);
+	eecs_id_t next_removed = num_holes;
+	eecs_id_t filler_pos = new_num_entities;
+	for (eecs_id_t hole_index = 0; hole_index < num_holes;) {
+		while (next_removed < count && entries[next_removed].pos_in_table == filler_pos) {
+			++next_removed;
+			++filler_pos;
+		}
 
-	for (
-		eecs_table_chunk_header_t* itr = world->next_free_table_chunks;
-		itr != NULL;
-	) {
-		eecs_table_chunk_header_t* next = itr->next;
-		eecs_free(world->options.table_chunk_memctx, itr);
-		itr = next;
+		eecs_id_t hole_pos = entries[hole_index].pos_in_table;
+		eecs_id_t run = 1;
+		while (
+			hole_index + run < num_holes
+			&& entries[hole_index + run].pos_in_table == hole_pos + run
+			&& (hole_pos + run) % num_entities_per_chunk != 0
+			&& (filler_pos + run) % num_entities_per_chunk != 0
+			&& !(next_removed < count && entries[next_removed].pos_in_table == filler_pos + run)
+		) {
+			++run;
+		}
+
+		eecs_copy_rows_within_table(world, table, filler_pos, hole_pos, run);
+		hole_index += run;
+		filler_pos += run;
 	}
 
-	eecs_free(memctx, world);
+	table->num_entities = new_num_entities;
+	eecs_id_t num_chunks = (new_num_entities + num_entities_per_chunk - 1) / num_entities_per_chunk;
+	while (eecs_array_length(table->chunks) > num_chunks) {
+		eecs_pop_table_chunk(world, table);
+	}
 }
 
-void
-eecs_set_per_world_userdata(
+// Append the given rows of from_table to to_table, copying runs of contiguous
+// rows one column at a time. Returns the position of the first new row.
+EECS_PRIVATE eecs_id_t
+eecs_append_rows_to_table(
 	eecs_world_t* world,
-	eecs_system_t system,
-	void* userdata
+	const eecs_table_t* from_table,
+	const eecs_bulk_entry_t* entries,
+	eecs_id_t count,
+	eecs_table_t* to_table,
+	const eecs_id_t* column_map,
+	const eecs_component_init_t* new_components
 ) {
-	// This can only be called by a system callback so it must already be synced
-	EECS_ASSERT(world->version == world->ecs->version, "World not synced");
+	eecs_id_t first_pos = to_table->num_entities;
+	eecs_id_t from_num_entities_per_chunk = from_table->num_entities_per_chunk;
+	eecs_id_t to_num_entities_per_chunk = to_table->num_entities_per_chunk;
+
+	to_table->num_entities += count;
+	eecs_id_t num_chunks = (to_table->num_entities + to_num_entities_per_chunk - 1) / to_num_entities_per_chunk;
+	while (eecs_array_length(to_table->chunks) < num_chunks) {
+		eecs_push_table_chunk(world, to_table);
+	}
+	eecs_mark_rows_changed(world, to_table, first_pos, count);
+
+	for (eecs_id_t i = 0; i < count;) {
+		eecs_id_t src_pos = entries[i].pos_in_table;
+		eecs_id_t dst_pos = first_pos + i;
+
+		eecs_id_t run = 1;
+		while (
+			i + run < count
+			&& entries[i + run].pos_in_table == src_pos + run
+			&& (src_pos + run) % from_num_entities_per_chunk != 0
+			&& (dst_pos + run) % to_num_entities_per_chunk != 0
+		) {
+			++run;
+		}
 
-	world->system_data[eecs_index_of(system)].per_world_data = userdata;
+		eecs_own_rows(world, to_table, dst_pos, run);
+		memcpy(eecs_row_id(to_table, dst_pos), eecs_row_id(from_table, src_pos), sizeof(eecs_id_t) * run);
+		for (eecs_id_t c = 0; c < to_table->num_data_columns; ++c) {
+			eecs_id_t j = to_table->data_columns[c];
+			size_t component_size = to_table->component_sizes[j];
+			char* dst = eecs_row_data(to_table, j, dst_pos);
+
+			if (column_map[j] >= 0) {
+				memcpy(dst, eecs_row_data(from_table, column_map[j], src_pos), component_size * run);
+			} else {
+				// Morphed entities share the value of each new component
+				eecs_component_init_t init = { 0 };
+				for (eecs_id_t k = 0; new_components != NULL && new_components[k].component.from_1_index != 0; ++k) {
+					if (new_components[k].component.from_1_index == to_table->signature.components[j].from_1_index) {
+						init.data = new_components[k].data;
+						break;
+					}
+				}
+				eecs_fill_components(dst, &init, component_size, 0, run);
+			}
+		}
+		for (eecs_id_t c = 0; c < to_table->num_enableable_columns; ++c) {
+			eecs_id_t j = to_table->enableable_columns[c];
+			if (column_map[j] >= 0) {
+				eecs_copy_enable_bits(to_table, j, dst_pos, from_table, column_map[j], src_pos, run);
+			} else {
+				eecs_set_rows_enabled(to_table, j, dst_pos, run, true);
+			}
+		}
+
+		i += run;
+	}
+
+	return first_pos;
 }
 
-void*
-eecs_get_per_world_userdata(
+EECS_PRIVATE eecs_table_t*
+eecs_get_morph_table(
 	eecs_world_t* world,
-	eecs_system_t system
+	eecs_table_t* table,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
 ) {
-	// This can only be called by a system callback so it must already be synced
-	EECS_ASSERT(world->version == world->ecs->version, "World not synced");
-
-	return world->system_data[eecs_index_of(system)].per_world_data;
-}
+	eecs_id_t num_new_components = eecs_component_init_list_length(new_components);
+	eecs_id_t num_removed_components = eecs_component_list_length(removed_components);
 
-eecs_entity_t
-eecs_create_entity(eecs_world_t* world, const eecs_component_init_t* init) {
-	eecs_sync_world(world);
+	if (num_new_components == 1 && num_removed_components == 0) {
+		return eecs_get_table_edge(world, table, new_components[0].component, true)->table;
+	} else if (num_new_components == 0 && num_removed_components == 1) {
+		return eecs_get_table_edge(world, table, removed_components[0], false)->table;
+	}
 
 	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+	eecs_component_t* components = eecs_arena_alloc(
+		world, &world->tmp_arena,
+		sizeof(eecs_component_t) * (table->signature.length + num_new_components),
+		_Alignof(eecs_component_t)
+	);
 
-	eecs_component_init_t* init_copy;
-	eecs_table_t* table;
-	eecs_parse_component_init(world, init, &init_copy, &table);
+	eecs_id_t new_sig_length = 0;
+	for (eecs_id_t i = 0; i < table->signature.length + num_new_components; ++i) {
+		eecs_component_t component = i < table->signature.length
+			? table->signature.components[i]
+			: new_components[i - table->signature.length].component;
+
+		bool skip = false;
+		for (eecs_id_t j = 0; j < num_removed_components && !skip; ++j) {
+			skip = removed_components[j].from_1_index == component.from_1_index;
+		}
+		for (eecs_id_t j = 0; j < new_sig_length && !skip; ++j) {
+			skip = components[j].from_1_index == component.from_1_index;
+		}
 
-	eecs_entity_t entity = eecs_create_entity_for_table(world, table, init_copy);
+		if (!skip) { components[new_sig_length++] = component; }
+	}
+
+#define eecs_component_cmp_lt(lhs, rhs) ((lhs).from_1_index < (rhs).from_1_index)
+	eecs_insertion_sort(new_sig_length, components, eecs_component_t, eecs_component_cmp_lt);
+
+	eecs_table_t* new_table = eecs_get_table(world, (eecs_signature_t){
+		.components = components,
+		.length = new_sig_length,
+	});
 
 	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
-	return entity;
+	return new_table;
+}
+
+EECS_PRIVATE void
+eecs_destroy_entities_now(
+	eecs_world_t* world,
+	const eecs_entity_t* handles,
+	eecs_id_t count
+) {
+	void* memctx = world->options.memctx;
+	eecs_own_entities(world);
+	eecs_bulk_entry_t* entries = eecs_malloc(memctx, sizeof(eecs_bulk_entry_t) * eecs_max(count, 1));
+	eecs_id_t num_entries = eecs_collect_bulk_entries(world, handles, count, entries);
+
+	eecs_bulk_scope_t scope = eecs_begin_bulk(world);
+
+	// Rows only move after every cleanup callback has run
+	for (eecs_id_t i = 0; i < num_entries; ++i) {
+		const eecs_bulk_entry_t* entry = &entries[i];
+		eecs_table_t* table = entry->table;
+		eecs_entity_t handle = {
+			.from_1_index = entry->from_1_index,
+			.gen = eecs_entity_slot(world, entry->from_1_index)->gen,
+		};
+
+		eecs_array_indexed_foreach_rev(
+			eecs_system_entity_callback_t, itr, table->system_cleanup_callbacks
+		) {
+			itr.value->fn(world, handle, itr.value->userdata);
+		}
+
+		eecs_array_indexed_foreach_rev(
+			eecs_component_entity_callback_t, itr, table->component_cleanup_callbacks
+		) {
+			char* component_data = eecs_own_row_data(world, table, itr.value->signature_index, entry->pos_in_table);
+			itr.value->fn(world, handle, component_data, itr.value->userdata);
+		}
+		eecs_remove_sparse_components(world, handle);
+	}
+
+	eecs_stat_add(world->stats, num_entities_destroyed, num_entries);
+	for (eecs_id_t i = 0; i < num_entries; ++i) {
+		eecs_entity_data_t* entity_data = eecs_entity_slot(world, entries[i].from_1_index);
+		++entity_data->gen;
+		eecs_push_free_entity_slot(world, entries[i].from_1_index);
+	}
+
+	for (eecs_id_t begin = 0; begin < num_entries;) {
+		eecs_id_t end = eecs_bulk_group_end(entries, begin, num_entries);
+		eecs_remove_rows_from_table(world, entries[begin].table, &entries[begin], end - begin);
+		begin = end;
+	}
+
+	eecs_free(memctx, entries);
+	eecs_end_bulk(world, scope);
+}
+
+EECS_PRIVATE void
+eecs_morph_entities_in_tables(
+	eecs_world_t* world,
+	const eecs_entity_t* handles,
+	eecs_id_t count,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+) {
+	void* memctx = world->options.memctx;
+	eecs_own_entities(world);
+	eecs_bulk_entry_t* entries = eecs_malloc(memctx, sizeof(eecs_bulk_entry_t) * eecs_max(count, 1));
+	eecs_id_t num_entries = eecs_collect_bulk_entries(world, handles, count, entries);
+
+	eecs_bulk_scope_t scope = eecs_begin_bulk(world);
+
+	for (eecs_id_t begin = 0; begin < num_entries;) {
+		eecs_id_t end = eecs_bulk_group_end(entries, begin, num_entries);
+		const eecs_bulk_entry_t* group = &entries[begin];
+		eecs_id_t group_size = end - begin;
+		begin = end;
+
+		eecs_table_t* table = group[0].table;
+		eecs_table_t* new_table = eecs_get_morph_table(world, table, new_components, removed_components);
+		if (new_table == table) { continue; }
+
+		// Call clean up for systems and components not in the new table
+		for (eecs_id_t i = 0; i < group_size; ++i) {
+			eecs_entity_t handle = {
+				.from_1_index = group[i].from_1_index,
+				.gen = eecs_entity_slot(world, group[i].from_1_index)->gen,
+			};
+
+			eecs_array_indexed_foreach_rev(
+				eecs_system_entity_callback_t, itr, table->system_cleanup_callbacks
+			) {
+				const eecs_system_data_t* system_data = &world->system_data[itr.value->system_index];
+				if (!eecs_table_matches_system(new_table, system_data)) {
+					itr.value->fn(world, handle, itr.value->userdata);
+				}
+			}
+
+			eecs_array_indexed_foreach_rev(
+				eecs_component_entity_callback_t, itr, table->component_cleanup_callbacks
+			) {
+				if (!eecs_bitset_is_set(new_table->bitset, itr.value->component_index)) {
+					char* component_data = eecs_own_row_data(world, table, itr.value->signature_index, group[i].pos_in_table);
+					itr.value->fn(world, handle, component_data, itr.value->userdata);
+				}
+			}
+		}
+
+		// Move the rows
+		eecs_id_t* column_map = eecs_build_column_map(world, table, new_table);
+		eecs_id_t first_pos = eecs_append_rows_to_table(
+			world, table, group, group_size, new_table, column_map, new_components
+		);
+		eecs_free(memctx, column_map);
+
+		eecs_remove_rows_from_table(world, table, group, group_size);
+		eecs_stat_add(world->stats, num_entities_morphed, group_size);
+		for (eecs_id_t i = 0; i < group_size; ++i) {
+			eecs_entity_data_t* entity_data = eecs_entity_slot(world, group[i].from_1_index);
+			entity_data->table = new_table;
+			entity_data->pos_in_table = first_pos + i;
+		}
+
+		// Call init for components and systems not in the old table
+		for (eecs_id_t i = 0; i < group_size; ++i) {
+			eecs_entity_t handle = {
+				.from_1_index = group[i].from_1_index,
+				.gen = eecs_entity_slot(world, group[i].from_1_index)->gen,
+			};
+
+			eecs_array_indexed_foreach(
+				eecs_component_entity_callback_t, itr, new_table->component_init_callbacks
+			) {
+				if (!eecs_bitset_is_set(table->bitset, itr.value->component_index)) {
+					char* component_data = eecs_own_row_data(world, new_table, itr.value->signature_index, first_pos + i);
+					itr.value->fn(world, handle, component_data, itr.value->userdata);
+				}
+			}
+
+			eecs_array_indexed_foreach(
+				eecs_system_entity_callback_t, itr, new_table->system_init_callbacks
+			) {
+				const eecs_system_data_t* system_data = &world->system_data[itr.value->system_index];
+				if (!eecs_table_matches_system(table, system_data)) {
+					itr.value->fn(world, handle, itr.value->userdata);
+				}
+			}
+		}
+	}
+
+	eecs_free(memctx, entries);
+	eecs_end_bulk(world, scope);
+}
+
+EECS_PRIVATE void
+eecs_morph_entities_now(
+	eecs_world_t* world,
+	const eecs_entity_t* handles,
+	eecs_id_t count,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+) {
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+	const eecs_component_init_t* table_new_components = new_components;
+	const eecs_component_t* table_removed_components = removed_components;
+	if (!eecs_split_sparse_morph(world, &table_new_components, &table_removed_components)) {
+		eecs_morph_entities_in_tables(world, handles, count, new_components, removed_components);
+		return;
+	}
+
+	eecs_bulk_scope_t scope = eecs_begin_bulk(world);
+	for (eecs_id_t i = 0; i < count; ++i) {
+		if (eecs_get_entity_data(world, handles[i]) != NULL) {
+			eecs_morph_sparse_components(world, handles[i], new_components, removed_components);
+		}
+	}
+	eecs_end_bulk(world, scope);
+
+	if (table_new_components[0].component.from_1_index != 0 || table_removed_components[0].from_1_index != 0) {
+		eecs_morph_entities_in_tables(world, handles, count, table_new_components, table_removed_components);
+	}
+
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+}
+
+// Returns the number of ops applied
+EECS_PRIVATE eecs_id_t
+eecs_apply_deferred_ops(eecs_world_t* world, eecs_deferred_op_t* first_op) {
+	eecs_id_t num_ops = 0;
+	for (eecs_deferred_op_t* op = first_op; op != NULL; op = op->next) {
+		++num_ops;
+		switch (op->type) {
+			case EECS_DESTROY_ENTITY:
+			case EECS_MORPH_ENTITY: {
+				if (eecs_get_entity_data(world, op->handle) == NULL) { continue; }
+
+				if (op->type == EECS_DESTROY_ENTITY) {
+					eecs_destroy_entity_now(world, op->handle);
+				} else {
+					eecs_morph_entity_now(
+						world, op->handle,
+						op->new_components, op->removed_components
+					);
+				}
+			} break;
+			case EECS_DESTROY_ENTITIES:
+				eecs_destroy_entities_now(world, op->handles, op->num_handles);
+				break;
+			case EECS_MORPH_ENTITIES:
+				eecs_morph_entities_now(
+					world, op->handles, op->num_handles,
+					op->new_components, op->removed_components
+				);
+				break;
+		}
+	}
+
+	return num_ops;
+}
+
+EECS_PRIVATE eecs_component_init_t*
+eecs_copy_deferred_new_components(
+	eecs_world_t* world,
+	eecs_arena_t* deferred_arena,
+	const eecs_component_init_t* new_components
+) {
+	eecs_id_t num_new_components = eecs_component_init_list_length(new_components);
+	if (new_components == NULL || num_new_components == 0) { return NULL; }
+
+	eecs_component_init_t* new_components_copy = eecs_arena_alloc(
+		world, deferred_arena,
+		sizeof(eecs_component_init_t) * (num_new_components + 1),
+		_Alignof(eecs_component_init_t)
+	);
+	for (eecs_id_t i = 0; i < num_new_components; ++i) {
+		new_components_copy[i] = (eecs_component_init_t){ .component = new_components[i].component };
+		const void* init_data = new_components[i].data;
+		if (init_data != NULL) {
+			const eecs_component_options_t* component_options = &world->ecs->components[eecs_index_of(new_components[i].component)];
+			void* data_copy = eecs_arena_alloc(
+				world, deferred_arena,
+				component_options->size, component_options->alignment
+			);
+			memcpy(data_copy, init_data, component_options->size);
+
+			new_components_copy[i].data = data_copy;
+		}
+	}
+	new_components_copy[num_new_components] = (eecs_component_init_t){ 0 };
+
+	return new_components_copy;
+}
+
+EECS_PRIVATE eecs_component_t*
+eecs_copy_deferred_removed_components(
+	eecs_world_t* world,
+	eecs_arena_t* deferred_arena,
+	const eecs_component_t* removed_components
+) {
+	eecs_id_t num_removed_components = eecs_component_list_length(removed_components);
+	if (removed_components == NULL || num_removed_components == 0) { return NULL; }
+
+	eecs_component_t* removed_components_copy = eecs_arena_alloc(
+		world, deferred_arena,
+		sizeof(eecs_component_t) * (num_removed_components + 1),
+		_Alignof(eecs_component_t)
+	);
+	memcpy(
+		removed_components_copy,
+		removed_components,
+		sizeof(eecs_component_t) * (num_removed_components + 1)
+	);
+
+	return removed_components_copy;
+}
+
+EECS_PRIVATE void
+eecs_defer_or_run_bulk(
+	eecs_world_t* world,
+	eecs_deferred_op_type_t type,
+	const eecs_entity_t* handles,
+	eecs_id_t count,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+) {
+	void* memctx = world->options.memctx;
+	eecs_entity_t* partitioned_handles = NULL;
+	const eecs_entity_t* immediate_handles = handles;
+	eecs_id_t num_immediate = count;
+
+	if (eecs_is_deferring(world)) {
+		// Deferred handles go to the front, the others to the back
+		partitioned_handles = eecs_malloc(memctx, sizeof(eecs_entity_t) * count);
+		eecs_id_t num_deferred = 0;
+		num_immediate = 0;
+		for (eecs_id_t i = 0; i < count; ++i) {
+			const eecs_entity_data_t* entity_data = eecs_get_entity_data(world, handles[i]);
+			if (entity_data == NULL) { continue; }
+
+			if (eecs_should_defer(world, entity_data)) {
+				partitioned_handles[num_deferred++] = handles[i];
+			} else {
+				partitioned_handles[count - ++num_immediate] = handles[i];
+			}
+		}
+		immediate_handles = partitioned_handles + count - num_immediate;
+
+		if (num_deferred > 0) {
+			eecs_arena_t* deferred_arena = eecs_deferred_arena(world);
+			eecs_component_init_t* new_components_copy = NULL;
+			eecs_component_t* removed_components_copy = NULL;
+			if (type == EECS_MORPH_ENTITIES) {
+				new_components_copy = eecs_copy_deferred_new_components(world, deferred_arena, new_components);
+				removed_components_copy = eecs_copy_deferred_removed_components(world, deferred_arena, removed_components);
+			}
+
+			// Split the handles so each piece fits in an arena chunk
+			eecs_id_t max_handles_per_op = (eecs_id_t)(world->options.table_chunk_size / 2 / sizeof(eecs_entity_t));
+			for (eecs_id_t begin = 0; begin < num_deferred; begin += max_handles_per_op) {
+				eecs_id_t num_handles = eecs_min(num_deferred - begin, max_handles_per_op);
+				eecs_deferred_op_t* op = eecs_alloc_deferred_op(world, type, (eecs_entity_t){ 0 });
+				op->handles = eecs_arena_alloc(
+					world, deferred_arena,
+					sizeof(eecs_entity_t) * num_handles,
+					_Alignof(eecs_entity_t)
+				);
+				memcpy(op->handles, partitioned_handles + begin, sizeof(eecs_entity_t) * num_handles);
+				op->num_handles = num_handles;
+				op->new_components = new_components_copy;
+				op->removed_components = removed_components_copy;
+			}
+		}
+	}
+
+	if (num_immediate > 0) {
+		if (type == EECS_DESTROY_ENTITIES) {
+			eecs_destroy_entities_now(world, immediate_handles, num_immediate);
+		} else {
+			eecs_morph_entities_now(
+				world, immediate_handles, num_immediate,
+				new_components, removed_components
+			);
+		}
+	}
+
+	eecs_free(memctx, partitioned_handles);
+}
+
+EECS_PRIVATE eecs_entity_t*
+eecs_collect_matching_entities(
+	eecs_world_t* world,
+	const eecs_component_t* require_components,
+	const eecs_component_t* exclude_components,
+	eecs_id_t* count_out
+) {
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+	eecs_bitset_t* require_bitset = eecs_make_component_bitset(world, &world->tmp_arena, require_components);
+	eecs_bitset_t* exclude_bitset = eecs_make_component_bitset(world, &world->tmp_arena, exclude_components);
+	eecs_sparse_filter_t filter = eecs_make_sparse_filter(
+		world, &world->tmp_arena,
+		require_components, exclude_components, NULL,
+		require_bitset, exclude_bitset
+	);
+
+	eecs_id_t count = 0;
+	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+		const eecs_table_t* table = *itr.value;
+		if (
+			eecs_bitset_is_all_set(table->bitset, require_bitset)
+			&& !eecs_bitset_is_any_set(table->bitset, exclude_bitset)
+		) {
+			count += table->num_entities;
+		}
+	}
+
+	eecs_entity_t* handles = eecs_malloc(world->options.memctx, sizeof(eecs_entity_t) * eecs_max(count, 1));
+	eecs_id_t num_handles = 0;
+	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+		const eecs_table_t* table = *itr.value;
+		if (
+			!eecs_bitset_is_all_set(table->bitset, require_bitset)
+			|| eecs_bitset_is_any_set(table->bitset, exclude_bitset)
+		) {
+			continue;
+		}
+
+		for (eecs_id_t i = 0; i < table->num_entities; ++i) {
+			eecs_id_t from_1_index = *eecs_row_id(table, i);
+			if (filter.components != NULL && !eecs_passes_sparse_filter(world, &filter, from_1_index)) {
+				continue;
+			}
+
+			handles[num_handles++] = (eecs_entity_t){
+				.from_1_index = from_1_index,
+				.gen = eecs_entity_slot(world, from_1_index)->gen,
+			};
+		}
+	}
+
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+	*count_out = num_handles;
+	return handles;
+}
+
+EECS_PRIVATE eecs_entity_t*
+eecs_collect_batch_entities(eecs_batch_t batch) {
+	eecs_entity_t* handles = eecs_malloc(
+		batch.world->options.memctx,
+		sizeof(eecs_entity_t) * eecs_max(batch.size, 1)
+	);
+	for (eecs_id_t i = 0; i < batch.size; ++i) {
+		handles[i] = eecs_get_entity_in_batch(batch, i);
+	}
+	return handles;
+}
+
+
+EECS_PRIVATE eecs_batch_t
+eecs_make_table_batch(
+	eecs_world_t* world,
+	const eecs_table_t* table,
+	ptrdiff_t* component_storage_offsets,
+	ptrdiff_t* enable_mask_offsets,
+	eecs_id_t chunk_index
+) {
+	eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+	eecs_id_t last_chunk_index = eecs_array_length(table->chunks) - 1;
+	eecs_id_t num_entities_in_last_chunk = table->num_entities - last_chunk_index * num_entities_per_chunk;
+
+	eecs_id_t size = chunk_index == last_chunk_index
+		? num_entities_in_last_chunk
+		: num_entities_per_chunk;
+	eecs_id_t batch_width = world->options.batch_width;
+	return (eecs_batch_t){
+		.world = world,
+		.chunk = table->chunks[chunk_index],
+		.offsets = component_storage_offsets,
+		.enable_mask_offsets = enable_mask_offsets,
+		.size = size,
+		.padded_size = (size + batch_width - 1) / batch_width * batch_width,
+	};
+}
+
+EECS_PRIVATE eecs_batch_t
+eecs_make_batch(
+	eecs_world_t* world,
+	const eecs_system_table_match_t* match,
+	eecs_id_t chunk_index
+) {
+	return eecs_make_table_batch(
+		world, match->table, match->component_storage_offsets, match->enable_mask_offsets, chunk_index
+	);
+}
+
+// Find the next run of rows passing the filter, from *begin_inout onward
+EECS_PRIVATE bool
+eecs_next_sparse_run(
+	const eecs_world_t* world,
+	const eecs_sparse_filter_t* filter,
+	eecs_batch_t batch,
+	eecs_id_t* begin_inout,
+	eecs_id_t* end_out
+) {
+	const eecs_id_t* entity_ids = batch.chunk;
+	eecs_id_t begin = *begin_inout;
+	while (begin < batch.size && !eecs_passes_sparse_filter(world, filter, entity_ids[begin])) {
+		++begin;
+	}
+	if (begin >= batch.size) { return false; }
+
+	eecs_id_t end = begin + 1;
+	while (end < batch.size && eecs_passes_sparse_filter(world, filter, entity_ids[end])) {
+		++end;
+	}
+
+	*begin_inout = begin;
+	*end_out = end;
+	return true;
+}
+
+// The rows [begin, end) of a batch. Offsets are shifted so that indexing a
+// column or the entity ids from the start of the run lands on row begin.
+EECS_PRIVATE eecs_batch_t
+eecs_slice_batch(
+	eecs_batch_t batch,
+	const eecs_sparse_filter_t* filter,
+	eecs_id_t begin,
+	eecs_id_t end,
+	ptrdiff_t* offsets_out
+) {
+	for (eecs_id_t i = 0; i < filter->num_batch_components; ++i) {
+		ptrdiff_t offset = batch.offsets[i];
+		ptrdiff_t shift = (ptrdiff_t)begin
+			* ((ptrdiff_t)filter->batch_component_sizes[i] - (ptrdiff_t)sizeof(eecs_id_t));
+		offsets_out[i] = offset >= 0 ? offset + shift : -1;
+	}
+
+	return (eecs_batch_t){
+		.world = batch.world,
+		.chunk = (eecs_id_t*)batch.chunk + begin,
+		.offsets = offsets_out,
+		// Enable bits are addressed from the start of the chunk
+		.enable_mask_offsets = batch.enable_mask_offsets,
+		.first_row = batch.first_row + begin,
+		.size = end - begin,
+		.padded_size = end - begin,
+	};
+}
+
+EECS_PRIVATE bool
+eecs_chunk_changed_since_last_run(
+	const eecs_system_data_t* system_data,
+	const eecs_system_table_match_t* match,
+	eecs_id_t chunk_index
+) {
+	const eecs_table_t* table = match->table;
+	const uint64_t* change_ticks = &table->change_ticks[chunk_index * table->signature.length];
+	for (eecs_id_t i = 0; i < match->num_changed_columns; ++i) {
+		if (change_ticks[match->changed_columns[i]] > system_data->last_run_tick) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Whether an entity of the chunk has all of the match's enabled columns on
+EECS_PRIVATE bool
+eecs_chunk_has_enabled_rows(const eecs_system_table_match_t* match, eecs_id_t chunk_index) {
+	const eecs_table_t* table = match->table;
+	eecs_id_t num_bits_per_mask = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
+	eecs_id_t num_rows = eecs_min(
+		table->num_entities - chunk_index * table->num_entities_per_chunk,
+		table->num_entities_per_chunk
+	);
+	eecs_id_t num_masks = eecs_num_enable_masks(num_rows);
+	for (eecs_id_t i = 0; i < num_masks; ++i) {
+		// Bits past the last entity are left over from removed rows
+		eecs_id_t num_bits = eecs_min(num_rows - i * num_bits_per_mask, num_bits_per_mask);
+		eecs_mask_t enabled = num_bits < num_bits_per_mask
+			? ((eecs_mask_t)1 << num_bits) - 1
+			: ~(eecs_mask_t)0;
+		for (eecs_id_t j = 0; j < match->num_enabled_columns; ++j) {
+			enabled &= eecs_get_enable_masks(table, match->enabled_columns[j], chunk_index)[i];
+		}
+		if (enabled != 0) { return true; }
+	}
+
+	return false;
+}
+
+// Returns the number of entities processed
+EECS_PRIVATE eecs_id_t
+eecs_run_batch(
+	eecs_world_t* world,
+	const eecs_system_options_t* system_options,
+	const eecs_system_data_t* system_data,
+	const eecs_system_table_match_t* match,
+	eecs_id_t chunk_index
+) {
+	if (
+		system_data->changed_bitset != NULL
+		&& !eecs_chunk_changed_since_last_run(system_data, match, chunk_index)
+	) {
+		return 0;
+	}
+	if (match->num_enabled_columns > 0 && !eecs_chunk_has_enabled_rows(match, chunk_index)) {
+		return 0;
+	}
+
+	eecs_table_t* table = match->table;
+	if (match->num_write_columns > 0) {
+		eecs_own_chunk(world, table, chunk_index);
+	}
+
+	eecs_batch_t batch = eecs_make_batch(world, match, chunk_index);
+	const eecs_sparse_filter_t* filter = &system_data->sparse_filter;
+	eecs_id_t num_entities = 0;
+	if (filter->components == NULL) {
+		system_options->update_fn(world, batch, system_options->userdata);
+		num_entities = batch.size;
+	} else {
+		// Offsets were sized for every system in eecs_init_system_data
+		ptrdiff_t* run_offsets = eecs_current_worker(world)->run_offsets;
+		eecs_id_t begin = 0;
+		eecs_id_t end;
+		for (; eecs_next_sparse_run(world, filter, batch, &begin, &end); begin = end) {
+			eecs_batch_t run = eecs_slice_batch(batch, filter, begin, end, run_offsets);
+			system_options->update_fn(world, run, system_options->userdata);
+			num_entities += end - begin;
+		}
+	}
+
+	uint64_t* change_ticks = &table->change_ticks[chunk_index * table->signature.length];
+	for (eecs_id_t i = 0; i < match->num_write_columns; ++i) {
+		change_ticks[match->write_columns[i]] = system_data->run_tick;
+	}
+
+	return num_entities;
+}
+
+// Writes made by a system are stamped with the tick of its run. Structural
+// changes made during or after the run get a later tick so that every system,
+// including the one which made them, sees them on its next run.
+EECS_PRIVATE uint64_t
+eecs_advance_change_tick(eecs_world_t* world) {
+	uint64_t run_tick = ++world->change_tick;
+	++world->change_tick;
+	return run_tick;
+}
+
+EECS_PRIVATE void
+eecs_begin_system_run(eecs_system_data_t* system_data, uint64_t run_tick) {
+	system_data->last_run_tick = system_data->run_tick;
+	system_data->run_tick = run_tick;
+	eecs_stat_add(system_data->stats, num_runs, 1);
+}
+
+EECS_PRIVATE bool
+eecs_claim_parallel_task(eecs_worker_t* victim, eecs_id_t* task_index_out) {
+	if (victim->next_task >= victim->end_task) { return false; }
+
+#ifdef EECS_THREADS
+	eecs_id_t task_index = atomic_fetch_add(&victim->next_task, 1);
+#else
+	eecs_id_t task_index = victim->next_task++;
+#endif
+	*task_index_out = task_index;
+	return task_index < victim->end_task;
+}
+
+EECS_PRIVATE void
+eecs_run_parallel_tasks(eecs_world_t* world, eecs_id_t worker_index) {
+	eecs_worker_t* worker = &world->workers[worker_index];
+
+	// Drain our own queue first then steal from the others
+	for (eecs_id_t i = 0; i < world->num_workers; ++i) {
+		eecs_worker_t* victim = &world->workers[(worker_index + i) % world->num_workers];
+
+		eecs_id_t task_index;
+		while (eecs_claim_parallel_task(victim, &task_index)) {
+			eecs_parallel_task_t* task = &world->parallel_tasks[task_index];
+			const eecs_system_options_t* system_options = task->system_options;
+			worker->current_task = task;
+			uint64_t start_time = eecs_stats_now();
+
+			for (eecs_id_t match_index = task->match_begin; match_index < task->match_end; ++match_index) {
+				const eecs_system_table_match_t* match = &task->system_data->matched_tables[match_index];
+				eecs_id_t chunk_end = task->chunk_end >= 0
+					? task->chunk_end
+					: eecs_array_length(match->table->chunks);
+
+				for (eecs_id_t chunk_index = task->chunk_begin; chunk_index < chunk_end; ++chunk_index) {
+					eecs_id_t num_entities = eecs_run_batch(
+						world, system_options, task->system_data, match, chunk_index
+					);
+					eecs_stat_add(*task, num_chunks_visited, num_entities > 0);
+					eecs_stat_add(*task, num_entities_processed, num_entities);
+				}
+			}
+
+			eecs_stat_add(*task, update_time_ns, eecs_stats_now() - start_time);
+			worker->current_task = NULL;
+		}
+	}
+}
+
+#ifdef EECS_THREADS
+EECS_PRIVATE int
+eecs_worker_main(void* arg) {
+	eecs_worker_t* worker = arg;
+	eecs_world_t* world = worker->world;
+	eecs_id_t worker_index = (eecs_id_t)(worker - world->workers);
+	eecs_thread_worker = worker;
+
+	eecs_id_t generation = 0;
+	mtx_lock(&world->pool_mutex);
+	while (true) {
+		while (!world->pool_shutdown && world->pool_generation == generation) {
+			cnd_wait(&world->pool_start_cnd, &world->pool_mutex);
+		}
+		if (world->pool_shutdown) { break; }
+
+		generation = world->pool_generation;
+		mtx_unlock(&world->pool_mutex);
+
+		eecs_run_parallel_tasks(world, worker_index);
+
+		mtx_lock(&world->pool_mutex);
+		if (--world->num_busy_workers == 0) {
+			cnd_signal(&world->pool_done_cnd);
+		}
+	}
+	mtx_unlock(&world->pool_mutex);
+
+	return 0;
+}
+
+// Worlds which never run systems in parallel, such as most forks, never pay
+// for the threads
+EECS_PRIVATE void
+eecs_start_workers(eecs_world_t* world) {
+	for (eecs_id_t i = 1; i < world->num_workers; ++i) {
+		int result = thrd_create(&world->workers[i].thread, eecs_worker_main, &world->workers[i]);
+		EECS_ASSERT(result == thrd_success, "Could not create worker thread");
+		(void)result;
+	}
+	world->pool_started = true;
+}
+#endif
+
+EECS_PRIVATE eecs_id_t
+eecs_count_matched_chunks(const eecs_system_data_t* system_data) {
+	eecs_id_t num_chunks = 0;
+	eecs_array_indexed_foreach(eecs_system_table_match_t, itr, system_data->matched_tables) {
+		num_chunks += eecs_array_length(itr.value->table->chunks);
+	}
+	return num_chunks;
+}
+
+EECS_PRIVATE void
+eecs_push_parallel_tasks(
+	eecs_world_t* world,
+	const eecs_system_options_t* system_options,
+	eecs_system_data_t* system_data,
+	eecs_id_t num_chunks_per_task
+) {
+	void* memctx = world->options.memctx;
+	eecs_id_t num_matches = eecs_array_length(system_data->matched_tables);
+	if (system_options->update_fn == NULL || num_matches == 0) { return; }
+
+	// A system that is not parallel must see all its batches on one thread
+	if (!system_options->parallel) {
+		eecs_array_push(memctx, world->parallel_tasks, ((eecs_parallel_task_t){
+			.system_options = system_options,
+			.system_data = system_data,
+			.match_begin = 0,
+			.match_end = num_matches,
+			.chunk_begin = 0,
+			.chunk_end = -1,
+		}));
+		return;
+	}
+
+	// Split large tables into chunk ranges
+	for (eecs_id_t i = 0; i < num_matches; ++i) {
+		eecs_id_t table_num_chunks = eecs_array_length(system_data->matched_tables[i].table->chunks);
+		for (eecs_id_t begin = 0; begin < table_num_chunks; begin += num_chunks_per_task) {
+			eecs_array_push(memctx, world->parallel_tasks, ((eecs_parallel_task_t){
+				.system_options = system_options,
+				.system_data = system_data,
+				.match_begin = i,
+				.match_end = i + 1,
+				.chunk_begin = begin,
+				.chunk_end = eecs_min(begin + num_chunks_per_task, table_num_chunks),
+			}));
+		}
+	}
+}
+
+EECS_PRIVATE void
+eecs_run_parallel_section(eecs_world_t* world) {
+	eecs_id_t num_workers = world->num_workers;
+	eecs_id_t num_tasks = eecs_array_length(world->parallel_tasks);
+	if (num_tasks == 0) { return; }
+
+	for (eecs_id_t i = 0; i < num_workers; ++i) {
+		eecs_worker_t* worker = &world->workers[i];
+		worker->next_task = (eecs_id_t)((int64_t)num_tasks * i / num_workers);
+		worker->end_task = (eecs_id_t)((int64_t)num_tasks * (i + 1) / num_workers);
+	}
+
+	// Workers may look up entities
+	if (world->rebase_entities) { eecs_own_entities(world); }
+	world->parallel_update = true;
+
+#ifdef EECS_THREADS
+	if (num_workers > 1) {
+		if (!world->pool_started) { eecs_start_workers(world); }
+
+		mtx_lock(&world->pool_mutex);
+		++world->pool_generation;
+		world->num_busy_workers = num_workers - 1;
+		cnd_broadcast(&world->pool_start_cnd);
+		mtx_unlock(&world->pool_mutex);
+	}
+#endif
+
+	eecs_run_parallel_tasks(world, 0);
+
+#ifdef EECS_THREADS
+	if (num_workers > 1) {
+		mtx_lock(&world->pool_mutex);
+		while (world->num_busy_workers > 0) {
+			cnd_wait(&world->pool_done_cnd, &world->pool_mutex);
+		}
+		mtx_unlock(&world->pool_mutex);
+	}
+#endif
+
+	world->parallel_update = false;
+	eecs_release_copied_chunks(world);
+
+	// Apply in task order so the result does not depend on scheduling
+	eecs_array_indexed_foreach(eecs_parallel_task_t, itr, world->parallel_tasks) {
+		eecs_parallel_task_t* task = itr.value;
+		uint64_t start_time = eecs_stats_now();
+		eecs_id_t num_ops = eecs_apply_deferred_ops(world, task->first_deferred_ops);
+		eecs_stat_add(*task, update_time_ns, eecs_stats_now() - start_time);
+
+		eecs_stat_add(task->system_data->stats, num_deferred_ops_applied, num_ops);
+		eecs_stat_add(task->system_data->stats, num_chunks_visited, task->num_chunks_visited);
+		eecs_stat_add(task->system_data->stats, num_entities_processed, task->num_entities_processed);
+	}
+
+	for (eecs_id_t i = 0; i < num_workers; ++i) {
+		eecs_arena_reset(world, &world->workers[i].deferred_arena);
+	}
+}
+
+EECS_PRIVATE void
+eecs_do_run_system_parallel(
+	eecs_world_t* world,
+	const eecs_system_options_t* system_options,
+	eecs_system_data_t* system_data
+) {
+	// Aim for a few tasks per worker
+	eecs_id_t num_chunks_per_task = eecs_max(
+		eecs_count_matched_chunks(system_data) / (world->num_workers * 4), 1
+	);
+
+	eecs_array_clear(world->parallel_tasks);
+	eecs_push_parallel_tasks(world, system_options, system_data, num_chunks_per_task);
+	eecs_run_parallel_section(world);
+}
+
+EECS_PRIVATE void
+eecs_do_run_system(
+	eecs_world_t* world,
+	const eecs_system_options_t* system_options,
+	eecs_system_data_t* system_data
+) {
+	eecs_begin_system_run(system_data, eecs_advance_change_tick(world));
+	uint64_t start_time = eecs_stats_now();
+
+	if (system_options->pre_update_fn) {
+		system_options->pre_update_fn(world, system_options->userdata);
+	}
+
+	world->structure_locked = system_options->no_structural_changes;
+	if (system_options->parallel) {
+		eecs_do_run_system_parallel(world, system_options, system_data);
+	} else {
+		eecs_array_indexed_foreach(
+			eecs_system_table_match_t,
+			match_itr,
+			system_data->matched_tables
+		) {
+			eecs_table_t* table = match_itr.value->table;
+
+			eecs_arena_reset(world, &world->deferred_arena);
+			world->first_deferred_ops = world->last_deferred_ops = NULL;
+			world->current_update_table = table;
+
+			eecs_array_indexed_foreach(char*, chunk_itr, table->chunks) {
+				eecs_id_t num_entities = eecs_run_batch(
+					world, system_options, system_data, match_itr.value, chunk_itr.index
+				);
+				eecs_stat_add(system_data->stats, num_chunks_visited, num_entities > 0);
+				eecs_stat_add(system_data->stats, num_entities_processed, num_entities);
+			}
+
+			eecs_id_t num_ops = eecs_apply_deferred_ops(world, world->first_deferred_ops);
+			eecs_stat_add(system_data->stats, num_deferred_ops_applied, num_ops);
+		}
+		world->current_update_table = NULL;
+		eecs_release_copied_chunks(world);
+	}
+	world->structure_locked = false;
+
+	if (system_options->post_update_fn) {
+		system_options->post_update_fn(world, system_options->userdata);
+	}
+
+	eecs_stat_add(system_data->stats, update_time_ns, eecs_stats_now() - start_time);
+}
+
+// Hooks and structural changes happen between systems when they run one after
+// another, which a shared stage would reorder
+EECS_PRIVATE bool
+eecs_can_share_stage(const eecs_system_options_t* system_options, const eecs_system_data_t* system_data) {
+	return system_data->write_bitset != NULL
+		&& system_options->no_structural_changes
+		&& system_options->pre_update_fn == NULL
+		&& system_options->post_update_fn == NULL;
+}
+
+EECS_PRIVATE bool
+eecs_systems_conflict(const eecs_world_t* world, eecs_id_t lhs_index, eecs_id_t rhs_index) {
+	const eecs_system_data_t* lhs = &world->system_data[lhs_index];
+	const eecs_system_data_t* rhs = &world->system_data[rhs_index];
+	if (
+		!eecs_can_share_stage(&world->ecs->systems[lhs_index], lhs)
+		|| !eecs_can_share_stage(&world->ecs->systems[rhs_index], rhs)
+	) {
+		return true;
+	}
+
+	return eecs_bitset_is_any_set(lhs->write_bitset, rhs->read_bitset)
+		|| eecs_bitset_is_any_set(lhs->write_bitset, rhs->write_bitset)
+		|| eecs_bitset_is_any_set(rhs->write_bitset, lhs->read_bitset);
+}
+
+EECS_PRIVATE eecs_schedule_t*
+eecs_get_schedule(eecs_world_t* world, eecs_mask_t update_mask) {
+	eecs_array_indexed_foreach(eecs_schedule_t, itr, world->schedules) {
+		if (itr.value->update_mask == update_mask) { return itr.value; }
+	}
+
+	void* memctx = world->options.memctx;
+	const eecs_t* ecs = world->ecs;
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+
+	eecs_id_t num_systems = eecs_array_length(world->system_data);
+	eecs_id_t* stages = eecs_arena_alloc(
+		world, &world->tmp_arena,
+		sizeof(eecs_id_t) * eecs_max(num_systems, 1),
+		_Alignof(eecs_id_t)
+	);
+
+	// Each system goes into the stage after the last earlier system it
+	// conflicts with, so conflicting systems keep their registration order
+	eecs_id_t num_stages = 0;
+	for (eecs_id_t i = 0; i < num_systems; ++i) {
+		const eecs_system_options_t* system_options = &ecs->systems[i];
+		if ((update_mask & system_options->update_mask) != system_options->update_mask) {
+			stages[i] = -1;
+			continue;
+		}
+
+		eecs_id_t stage = 0;
+		for (eecs_id_t j = 0; j < i; ++j) {
+			if (stages[j] < 0) { continue; }
+
+			if (eecs_systems_conflict(world, i, j)) {
+				stage = eecs_max(stage, stages[j] + 1);
+			}
+		}
+		stages[i] = stage;
+		num_stages = eecs_max(num_stages, stage + 1);
+	}
+
+	eecs_schedule_t schedule = { .update_mask = update_mask };
+	for (eecs_id_t stage = 0; stage < num_stages; ++stage) {
+		for (eecs_id_t i = 0; i < num_systems; ++i) {
+			if (stages[i] == stage) {
+				eecs_array_push(memctx, schedule.systems, i);
+			}
+		}
+		eecs_array_push(memctx, schedule.stage_ends, eecs_array_length(schedule.systems));
+	}
+	eecs_array_push(memctx, world->schedules, schedule);
+
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+	return &eecs_array_back(world->schedules);
+}
+
+EECS_PRIVATE void
+eecs_run_stage(eecs_world_t* world, const eecs_id_t* systems, eecs_id_t num_systems) {
+	const eecs_t* ecs = world->ecs;
+
+	uint64_t run_tick = eecs_advance_change_tick(world);
+	for (eecs_id_t i = 0; i < num_systems; ++i) {
+		eecs_begin_system_run(&world->system_data[systems[i]], run_tick);
+	}
+
+	eecs_id_t num_parallel_chunks = 0;
+	for (eecs_id_t i = 0; i < num_systems; ++i) {
+		if (ecs->systems[systems[i]].parallel) {
+			num_parallel_chunks += eecs_count_matched_chunks(&world->system_data[systems[i]]);
+		}
+	}
+	eecs_id_t num_chunks_per_task = eecs_max(num_parallel_chunks / (world->num_workers * 4), 1);
+
+	eecs_array_clear(world->parallel_tasks);
+	for (eecs_id_t i = 0; i < num_systems; ++i) {
+		eecs_push_parallel_tasks(
+			world,
+			&ecs->systems[systems[i]],
+			&world->system_data[systems[i]],
+			num_chunks_per_task
+		);
+	}
+	// Only systems without hooks or structural changes share a stage
+	world->structure_locked = true;
+	eecs_run_parallel_section(world);
+	world->structure_locked = false;
+
+	// Systems overlap so each is charged for the time spent in its own tasks
+	eecs_array_indexed_foreach(eecs_parallel_task_t, itr, world->parallel_tasks) {
+		eecs_stat_add(itr.value->system_data->stats, update_time_ns, itr.value->update_time_ns);
+	}
+}
+
+// Public
+
+eecs_t*
+eecs_create(eecs_options_t options) {
+	eecs_t* ecs = eecs_malloc(options.memctx, sizeof(eecs_t));
+	*ecs = (eecs_t){
+		.options = options,
+	};
+
+	return ecs;
+}
+
+void
+eecs_destroy(eecs_t* ecs) {
+	void* memctx = ecs->options.memctx;
+
+	eecs_array_free(memctx, ecs->systems);
+	eecs_array_free(memctx, ecs->components);
+	eecs_array_free(memctx, ecs->system_versions);
+	eecs_array_free(memctx, ecs->component_versions);
+	eecs_free(memctx, ecs);
+}
+
+void
+eecs_register_component(
+	eecs_t* ecs,
+	eecs_component_t* handle,
+	eecs_component_options_t options
+) {
+	void* memctx = ecs->options.memctx;
+	EECS_ASSERT(options.alignment > 0, "Invalid alignment");
+	EECS_ASSERT(
+		options.storage == EECS_STORAGE_TABLE || options.alignment <= _Alignof(EECS_ALIGN_TYPE),
+		"Sparse components cannot be over-aligned"
+	);
+	EECS_ASSERT(
+		options.storage == EECS_STORAGE_TABLE || !options.enableable,
+		"Sparse components cannot be enableable"
+	);
+	++ecs->version;
+	if (handle->from_1_index == 0) {
+		eecs_array_push(memctx, ecs->components, options);
+		eecs_array_push(memctx, ecs->component_versions, ecs->version);
+		handle->from_1_index = eecs_array_length(ecs->components);
+	} else {
+		const eecs_component_options_t* old_options = &ecs->components[eecs_index_of(*handle)];
+		EECS_ASSERT(
+			old_options->storage == options.storage
+			&& old_options->enableable == options.enableable
+			&& (options.storage == EECS_STORAGE_TABLE || old_options->size == options.size),
+			"Cannot change the storage or enableability of a component or the size of a sparse component"
+		);
+		ecs->components[eecs_index_of(*handle)] = options;
+		ecs->component_versions[eecs_index_of(*handle)] = ecs->version;
+	}
+}
+
+void
+eecs_register_system(
+	eecs_t* ecs,
+	eecs_system_t* handle,
+	eecs_system_options_t options
+) {
+	void* memctx = ecs->options.memctx;
+	++ecs->version;
+	if (handle->from_1_index == 0) {
+		eecs_array_push(memctx, ecs->systems, options);
+		eecs_array_push(memctx, ecs->system_versions, ecs->version);
+		handle->from_1_index = eecs_array_length(ecs->systems);
+	} else {
+		ecs->systems[eecs_index_of(*handle)] = options;
+		ecs->system_versions[eecs_index_of(*handle)] = ecs->version;
+	}
+}
+
+eecs_chunk_pool_t*
+eecs_create_chunk_pool(eecs_chunk_pool_options_t options) {
+	options.chunk_size = options.chunk_size > 0
+		? options.chunk_size
+		: EECS_DEFAULT_TABLE_CHUNK_SIZE;
+	EECS_ASSERT(options.low_watermark >= 0 && options.high_watermark >= 0, "Invalid watermarks");
+	EECS_ASSERT(
+		options.chunk_alignment == 0 || options.chunk_size % options.chunk_alignment == 0,
+		"Chunk size must be a multiple of the alignment"
+	);
+
+	eecs_chunk_pool_t* pool = eecs_malloc(options.memctx, sizeof(eecs_chunk_pool_t));
+	*pool = (eecs_chunk_pool_t){
+		.options = options,
+	};
+#ifdef EECS_THREADS
+	mtx_init(&pool->mutex, mtx_plain);
+#endif
+
+#ifdef EECS_MMAP
+	if (options.reserve_size >= options.chunk_size) {
+		// Over-reserve so that the region can start on a huge page boundary
+		size_t mapping_size = options.reserve_size + EECS_HUGE_PAGE_SIZE;
+		void* mapping = mmap(
+			NULL, mapping_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+			-1, 0
+		);
+		if (mapping != MAP_FAILED) {
+			pool->mapping = mapping;
+			pool->mapping_size = mapping_size;
+			pool->page_size = (size_t)sysconf(_SC_PAGESIZE);
+			pool->region_begin = (char*)eecs_align_ptr((uintptr_t)mapping, EECS_HUGE_PAGE_SIZE);
+			pool->region_next = pool->region_begin;
+			pool->region_end = pool->region_begin
+				+ options.reserve_size / options.chunk_size * options.chunk_size;
+#ifdef MADV_HUGEPAGE
+			madvise(pool->region_begin, (size_t)(pool->region_end - pool->region_begin), MADV_HUGEPAGE);
+#endif
+		}
+	}
+#endif
+
+	for (eecs_id_t i = 0; i < options.low_watermark; ++i) {
+		eecs_table_chunk_header_t* header = eecs_carve_pooled_chunk(pool);
+		header = header != NULL
+			? header
+			: eecs_malloc_aligned(options.memctx, options.chunk_alignment, options.chunk_size);
+		header->next = pool->next_free_chunk;
+		pool->next_free_chunk = header;
+	}
+	pool->num_free_chunks = options.low_watermark;
+
+	return pool;
+}
+
+void
+eecs_destroy_chunk_pool(eecs_chunk_pool_t* pool) {
+	for (eecs_table_chunk_header_t* itr = pool->next_free_chunk; itr != NULL;) {
+		eecs_table_chunk_header_t* next = itr->next;
+#ifdef EECS_MMAP
+		if (!eecs_is_reserved_chunk(pool, itr)) {
+			eecs_free(pool->options.memctx, itr);
+		}
+#else
+		eecs_free(pool->options.memctx, itr);
+#endif
+		itr = next;
+	}
+
+#ifdef EECS_MMAP
+	if (pool->mapping != NULL) {
+		munmap(pool->mapping, pool->mapping_size);
+	}
+	eecs_array_free(pool->options.memctx, pool->decommitted_chunks);
+#endif
+
+#ifdef EECS_THREADS
+	mtx_destroy(&pool->mutex);
+#endif
+	eecs_free(pool->options.memctx, pool);
+}
+
+eecs_id_t
+eecs_get_chunk_pool_size(eecs_chunk_pool_t* pool) {
+#ifdef EECS_THREADS
+	mtx_lock(&pool->mutex);
+#endif
+	eecs_id_t num_free_chunks = pool->num_free_chunks;
+#ifdef EECS_THREADS
+	mtx_unlock(&pool->mutex);
+#endif
+	return num_free_chunks;
+}
+
+eecs_world_t*
+eecs_create_world(eecs_t* ecs, eecs_world_options_t options) {
+	options.memctx = options.memctx != NULL ? options.memctx : ecs->options.memctx;
+	if (options.chunk_pool != NULL) {
+		options.table_chunk_memctx = options.chunk_pool->options.memctx;
+		options.table_chunk_size = options.chunk_pool->options.chunk_size;
+	}
+	options.table_chunk_memctx = options.table_chunk_memctx != NULL
+		? options.table_chunk_memctx
+		: options.memctx;
+	options.table_chunk_size = options.table_chunk_size > 0
+		? options.table_chunk_size
+		: EECS_DEFAULT_TABLE_CHUNK_SIZE;
+
+	eecs_world_t* world = eecs_malloc(options.memctx, sizeof(eecs_world_t));
+
+	options.batch_width = eecs_max(options.batch_width, 1);
+	EECS_ASSERT(
+		(options.column_alignment & (options.column_alignment - 1)) == 0,
+		"Column alignment must be a power of two"
+	);
+	size_t chunk_alignment = options.chunk_pool != NULL
+		? options.chunk_pool->options.chunk_alignment
+		: options.column_alignment;
+	EECS_ASSERT(chunk_alignment >= options.column_alignment, "Chunk pool is not aligned enough");
+	EECS_ASSERT(
+		chunk_alignment == 0 || options.table_chunk_size % chunk_alignment == 0,
+		"Chunk size must be a multiple of the alignment"
+	);
+
+	*world = (eecs_world_t){
+		.ecs = ecs,
+		.options = options,
+		.change_tick = 1,
+		.chunk_alignment = chunk_alignment,
+	};
+
+#ifdef EECS_THREADS
+	world->num_workers = eecs_max(options.num_worker_threads, 0) + 1;
+#else
+	world->num_workers = 1;
+#endif
+	world->workers = eecs_malloc(options.memctx, sizeof(eecs_worker_t) * world->num_workers);
+	for (eecs_id_t i = 0; i < world->num_workers; ++i) {
+		world->workers[i] = (eecs_worker_t){
+			.world = world,
+		};
+	}
+
+#ifdef EECS_THREADS
+	mtx_init(&world->chunk_mutex, mtx_plain);
+	mtx_init(&world->pool_mutex, mtx_plain);
+	cnd_init(&world->pool_start_cnd);
+	cnd_init(&world->pool_done_cnd);
+#endif
+
+	eecs_sync_world(world);
+
+	return world;
+}
+
+void
+eecs_destroy_world(eecs_world_t* world) {
+	void* memctx = world->options.memctx;
+	const eecs_t* ecs = world->ecs;
+
+	// Destroy all entities
+	eecs_array_indexed_foreach(eecs_table_t*, table_itr, world->tables) {
+		eecs_table_t* table = *table_itr.value;
+		if (
+			eecs_array_length(table->system_cleanup_callbacks) == 0
+			&& eecs_array_length(table->component_cleanup_callbacks) == 0
+		) {
+			continue;
+		}
+
+		eecs_id_t last_chunk_index = eecs_array_length(table->chunks) - 1;
+		eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+		eecs_id_t num_entities_in_last_chunk = table->num_entities % num_entities_per_chunk;
+		const ptrdiff_t* component_storage_offsets = table->component_storage_offsets;
+		const size_t* component_sizes = table->component_sizes;
+
+		// A fork only copies its chunks when the callbacks get to write to them
+		bool write_chunks = eecs_array_length(table->component_cleanup_callbacks) > 0;
+		eecs_array_indexed_foreach(char*, chunk_itr, table->chunks) {
+			char* chunk = write_chunks
+				? eecs_own_chunk(world, table, chunk_itr.index)
+				: *chunk_itr.value;
+
+			eecs_id_t num_entities = chunk_itr.index == last_chunk_index
+				? num_entities_in_last_chunk
+				: num_entities_per_chunk;
+
+			eecs_id_t* entity_ids = (eecs_id_t*)chunk;
+			for (eecs_id_t i = 0; i < num_entities; ++i) {
+				eecs_id_t from_1_index = entity_ids[i];
+				eecs_entity_t handle = {
+					.from_1_index = from_1_index,
+					.gen = eecs_entity_slot(world, from_1_index)->gen,
+				};
+
+				eecs_array_indexed_foreach_rev(
+					eecs_system_entity_callback_t, itr, table->system_cleanup_callbacks
+				) {
+					itr.value->fn(world, handle, itr.value->userdata);
+				}
+
+				eecs_array_indexed_foreach_rev(
+					eecs_component_entity_callback_t, itr, table->component_cleanup_callbacks
+				) {
+					char* component_data = chunk
+						+ component_storage_offsets[itr.value->signature_index]
+						+ i * component_sizes[itr.value->signature_index];
+
+					itr.value->fn(world, handle, component_data, itr.value->userdata);
+				}
+			}
+		}
+	}
+
+	eecs_array_indexed_foreach(eecs_id_t, component_itr, world->sparse_components) {
+		const eecs_component_options_t* component_options = &ecs->components[*component_itr.value];
+		if (component_options->cleanup_fn == NULL) { continue; }
+
+		const eecs_sparse_set_t* set = &world->sparse_sets[*component_itr.value];
+		eecs_array_indexed_foreach(eecs_id_t, itr, set->entities) {
+			eecs_entity_t handle = {
+				.from_1_index = *itr.value,
+				.gen = eecs_entity_slot(world, *itr.value)->gen,
+			};
+			char* component_data = set->data + set->component_size * (size_t)itr.index;
+			component_options->cleanup_fn(world, handle, component_data, component_options->userdata);
+		}
+	}
+
+	// Call cleanup on systems
+	eecs_array_indexed_foreach_rev(eecs_system_data_t, itr, world->system_data) {
+		eecs_system_options_t* system = &ecs->systems[itr.index];
+		if (system->cleanup_per_world_fn) {
+			system->cleanup_per_world_fn(world, system->userdata);
+		}
+
+		eecs_array_free(memctx, itr.value->matched_tables);
+	}
+	eecs_array_free(memctx, world->system_data);
+
+	if (world->shared_entities == NULL || eecs_release_shared_entities(world)) {
+		eecs_free_entity_pages(memctx, world->entity_pages);
+	}
+
+	eecs_array_indexed_foreach(eecs_template_data_t, itr, world->templates) {
+		eecs_id_t signature_length = itr.value->table->signature.length;
+		for (eecs_id_t i = 0; i < signature_length; ++i) {
+			void* component_data = (void*)itr.value->init_data[i].data;
+			eecs_free(memctx, component_data);
+		}
+		eecs_free(memctx, itr.value->init_data);
+	}
+	eecs_array_free(memctx, world->templates);
+
+	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+		eecs_table_t* table = *itr.value;
+
+		eecs_free(memctx, (void*)table->signature.components);
+		eecs_free(memctx, table->component_storage_offsets);
+		eecs_free(memctx, table->component_sizes);
+		eecs_free(memctx, table->data_columns);
+		eecs_free(memctx, table->enableable_columns);
+		eecs_free(memctx, table->enable_mask_offsets);
+		eecs_free(memctx, table->component_columns);
+		eecs_array_free(memctx, table->system_init_callbacks);
+		eecs_array_free(memctx, table->system_cleanup_callbacks);
+		eecs_array_free(memctx, table->component_init_callbacks);
+		eecs_array_free(memctx, table->component_cleanup_callbacks);
+
+		eecs_array_indexed_foreach(eecs_table_edge_t, edge_itr, table->add_edges) {
+			eecs_free(memctx, edge_itr.value->column_map);
+		}
+		eecs_array_free(memctx, table->add_edges);
+		eecs_array_indexed_foreach(eecs_table_edge_t, edge_itr, table->remove_edges) {
+			eecs_free(memctx, edge_itr.value->column_map);
+		}
+		eecs_array_free(memctx, table->remove_edges);
+
+		eecs_array_indexed_foreach(char*, chunk_itr, table->chunks) {
+			eecs_release_table_chunk(
+				world,
+				*chunk_itr.value,
+				table->shared_chunks != NULL ? table->shared_chunks[chunk_itr.index] : NULL
+			);
+		}
+		eecs_array_free(memctx, table->chunks);
+		eecs_array_free(memctx, table->shared_chunks);
+		eecs_array_free(memctx, table->change_ticks);
+		eecs_free(memctx, table->bitset);
+		eecs_free(memctx, table);
+	}
+	eecs_array_free(memctx, world->tables);
+	eecs_free(memctx, world->table_index);
+
+	eecs_array_indexed_foreach(eecs_sparse_set_t, itr, world->sparse_sets) {
+		eecs_array_free(memctx, itr.value->positions);
+		eecs_array_free(memctx, itr.value->entities);
+		eecs_free(memctx, itr.value->data);
+	}
+	eecs_array_free(memctx, world->sparse_sets);
+	eecs_array_free(memctx, world->sparse_components);
+
+	eecs_arena_reset(world, &world->version_arena);
+	eecs_arena_reset(world, &world->deferred_arena);
+	eecs_arena_reset(world, &world->tmp_arena);
+
+#ifdef EECS_THREADS
+	mtx_lock(&world->pool_mutex);
+	world->pool_shutdown = true;
+	cnd_broadcast(&world->pool_start_cnd);
+	mtx_unlock(&world->pool_mutex);
+	if (world->pool_started) {
+		for (eecs_id_t i = 1; i < world->num_workers; ++i) {
+			thrd_join(world->workers[i].thread, NULL);
+		}
+	}
+
+	cnd_destroy(&world->pool_done_cnd);
+	cnd_destroy(&world->pool_start_cnd);
+	mtx_destroy(&world->pool_mutex);
+	mtx_destroy(&world->chunk_mutex);
+#endif
+
+	for (eecs_id_t i = 0; i < world->num_workers; ++i) {
+		eecs_arena_reset(world, &world->workers[i].deferred_arena);
+		eecs_array_free(memctx, world->workers[i].run_offsets);
+	}
+	eecs_free(memctx, world->workers);
+	eecs_array_free(memctx, world->parallel_tasks);
+	eecs_clear_schedules(world);
+	eecs_array_free(memctx, world->schedules);
+
+	while (eecs_array_length(world->queries) > 0) {
+		eecs_destroy_query(world->queries[0]);
+	}
+	eecs_array_free(memctx, world->queries);
+
+	eecs_array_free(memctx, world->copied_chunks);
+	eecs_free_chunks(world, world->next_free_table_chunks);
+
+	eecs_free(memctx, world);
+}
+
+eecs_world_t*
+eecs_fork_world(eecs_world_t* world) {
+	eecs_sync_world(world);
+	EECS_ASSERT(
+		world->current_update_table == NULL && !world->parallel_update && world->bulk_depth == 0,
+		"Cannot fork a world while it is being updated"
+	);
+
+	void* memctx = world->options.memctx;
+	eecs_world_t* fork = eecs_create_world(world->ecs, world->options);
+
+	// Tables are created in the same order so they keep their index
+	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+		eecs_table_t* table = *itr.value;
+		eecs_table_t* fork_table = eecs_create_table(fork, table->signature, table->signature_hash);
+		EECS_ASSERT(fork_table->index == table->index, "Table index mismatch");
+		eecs_copy_system_callbacks(memctx, &fork_table->system_init_callbacks, table->system_init_callbacks);
+		eecs_copy_system_callbacks(memctx, &fork_table->system_cleanup_callbacks, table->system_cleanup_callbacks);
+
+		eecs_id_t num_chunks = eecs_array_length(table->chunks);
+		if (num_chunks == 0) { continue; }
+
+		if (table->shared_chunks == NULL) {
+			eecs_array_resize(memctx, table->shared_chunks, num_chunks);
+			memset(table->shared_chunks, 0, sizeof(eecs_shared_block_t*) * num_chunks);
+		}
+		eecs_array_resize(memctx, fork_table->chunks, num_chunks);
+		eecs_array_resize(memctx, fork_table->shared_chunks, num_chunks);
+		for (eecs_id_t i = 0; i < num_chunks; ++i) {
+			table->shared_chunks[i] = eecs_share_block(world, table->shared_chunks[i]);
+			fork_table->chunks[i] = table->chunks[i];
+			fork_table->shared_chunks[i] = table->shared_chunks[i];
+		}
+
+		eecs_id_t num_ticks = eecs_array_length(table->change_ticks);
+		eecs_array_resize(memctx, fork_table->change_ticks, num_ticks);
+		memcpy(fork_table->change_ticks, table->change_ticks, sizeof(uint64_t) * num_ticks);
+		fork_table->num_entities = table->num_entities;
+	}
+
+	if (eecs_array_length(world->entity_pages) > 0) {
+		fork->entity_pages = world->entity_pages;
+		fork->shared_entities = eecs_share_entities(world);
+		fork->rebase_entities = true;
+	}
+	fork->num_entity_slots = world->num_entity_slots;
+	fork->next_free_entity_page = world->next_free_entity_page;
+	fork->relink_free_entity_slots = world->relink_free_entity_slots;
+	fork->new_entity_gen = world->new_entity_gen;
+	fork->change_tick = world->change_tick;
+
+	// Sparse sets are small next to the tables so they are copied outright
+	eecs_array_indexed_foreach(eecs_id_t, itr, world->sparse_components) {
+		const eecs_sparse_set_t* set = &world->sparse_sets[*itr.value];
+		eecs_sparse_set_t* fork_set = &fork->sparse_sets[*itr.value];
+		eecs_id_t num_slots = eecs_array_length(set->positions);
+		eecs_id_t num_members = eecs_array_length(set->entities);
+		if (num_members == 0) { continue; }
+
+		eecs_array_resize(memctx, fork_set->positions, num_slots);
+		memcpy(fork_set->positions, set->positions, sizeof(eecs_id_t) * num_slots);
+		eecs_array_resize(memctx, fork_set->entities, num_members);
+		memcpy(fork_set->entities, set->entities, sizeof(eecs_id_t) * num_members);
+		fork_set->data = eecs_realloc(
+			memctx, fork_set->data,
+			eecs_max(set->component_size * (size_t)eecs_array_capacity(fork_set->entities), (size_t)1)
+		);
+		memcpy(fork_set->data, set->data, set->component_size * (size_t)num_members);
+	}
+
+	eecs_array_indexed_foreach(eecs_system_data_t, itr, world->system_data) {
+		eecs_clone_system_matches(fork, world, itr.index);
+		fork->system_data[itr.index].run_tick = itr.value->run_tick;
+		fork->system_data[itr.index].last_run_tick = itr.value->last_run_tick;
+	}
+
+	// Templates keep their handles
+	const eecs_t* ecs = world->ecs;
+	eecs_array_indexed_foreach(eecs_template_data_t, itr, world->templates) {
+		eecs_id_t signature_length = itr.value->table->signature.length;
+		eecs_component_init_t* init_data = eecs_malloc(
+			memctx, sizeof(eecs_component_init_t) * signature_length
+		);
+		for (eecs_id_t i = 0; i < signature_length; ++i) {
+			const eecs_component_init_t* init = &itr.value->init_data[i];
+			init_data[i] = (eecs_component_init_t){ .component = init->component };
+			if (init->data != NULL) {
+				size_t size = ecs->components[eecs_index_of(init->component)].size;
+				void* data_copy = eecs_malloc(memctx, size);
+				memcpy(data_copy, init->data, size);
+				init_data[i].data = data_copy;
+			}
+		}
+
+		eecs_template_data_t template_data = {
+			.table = fork->tables[itr.value->table->index],
+			.init_data = init_data,
+		};
+		eecs_array_push(memctx, fork->templates, template_data);
+	}
+
+	return fork;
+}
+
+void
+eecs_set_per_world_userdata(
+	eecs_world_t* world,
+	eecs_system_t system,
+	void* userdata
+) {
+	// This can only be called by a system callback so it must already be synced
+	EECS_ASSERT(world->version == world->ecs->version, "World not synced");
+
+	world->system_data[eecs_index_of(system)].per_world_data = userdata;
+}
+
+void*
+eecs_get_per_world_userdata(
+	eecs_world_t* world,
+	eecs_system_t system
+) {
+	// This can only be called by a system callback so it must already be synced
+	EECS_ASSERT(world->version == world->ecs->version, "World not synced");
+
+	return world->system_data[eecs_index_of(system)].per_world_data;
+}
+
+eecs_entity_t
+eecs_create_entity(eecs_world_t* world, const eecs_component_init_t* init) {
+	eecs_sync_world(world);
+	EECS_ASSERT(!world->parallel_update, "Cannot create entities during a parallel update");
+	EECS_ASSERT(!world->structure_locked, "System declared no structural changes");
+
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+
+	eecs_component_init_t* init_copy;
+	eecs_table_t* table;
+	eecs_parse_component_init(world, init, &init_copy, &table);
+
+	eecs_entity_t entity = eecs_create_entity_for_table(world, table, init_copy);
+	if (eecs_array_length(world->sparse_components) > 0) {
+		eecs_init_sparse_components(world, entity, init, 0);
+	}
+
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+	return entity;
+}
+
+void
+eecs_create_entities(
+	eecs_world_t* world,
+	const eecs_component_init_t* init,
+	eecs_id_t count,
+	eecs_entity_t* handles_out
+) {
+	eecs_sync_world(world);
+	EECS_ASSERT(!world->parallel_update, "Cannot create entities during a parallel update");
+	EECS_ASSERT(!world->structure_locked, "System declared no structural changes");
+	EECS_ASSERT(count >= 0, "Invalid count");
+	EECS_ASSERT(count == 0 || handles_out != NULL, "Invalid handles_out");
+	if (count == 0) { return; }
+
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+
+	eecs_component_init_t* init_copy;
+	eecs_table_t* table;
+	eecs_parse_component_init(world, init, &init_copy, &table);
+
+	eecs_create_entities_for_table(world, table, init_copy, count, handles_out);
+	if (eecs_array_length(world->sparse_components) > 0) {
+		for (eecs_id_t i = 0; i < count; ++i) {
+			eecs_init_sparse_components(world, handles_out[i], init, i);
+		}
+	}
+
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+}
+
+void
+eecs_destroy_entity(eecs_world_t* world, eecs_entity_t handle) {
+	eecs_sync_world(world);
+	EECS_ASSERT(!world->structure_locked, "System declared no structural changes");
+
+	eecs_entity_data_t* entity_data = eecs_get_entity_data(world, handle);
+	if (entity_data == NULL) { return; }
+
+	if (eecs_should_defer(world, entity_data)) {
+		eecs_alloc_deferred_op(world, EECS_DESTROY_ENTITY, handle);
+	} else {
+		eecs_destroy_entity_now(world, handle);
+	}
+}
+
+void
+eecs_destroy_entities(
+	eecs_world_t* world,
+	const eecs_entity_t* handles,
+	eecs_id_t count
+) {
+	eecs_sync_world(world);
+	EECS_ASSERT(!world->structure_locked, "System declared no structural changes");
+	if (count <= 0) { return; }
+
+	eecs_defer_or_run_bulk(world, EECS_DESTROY_ENTITIES, handles, count, NULL, NULL);
+}
+
+void
+eecs_morph_entities(
+	eecs_world_t* world,
+	const eecs_entity_t* handles,
+	eecs_id_t count,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+) {
+	eecs_sync_world(world);
+	EECS_ASSERT(!world->structure_locked, "System declared no structural changes");
+	EECS_ASSERT(!eecs_has_per_entity_init(new_components), "per_entity is only supported by eecs_create_entities");
+	if (count <= 0) { return; }
+
+	eecs_defer_or_run_bulk(
+		world, EECS_MORPH_ENTITIES, handles, count,
+		new_components, removed_components
+	);
+}
+
+void
+eecs_destroy_entities_in_batch(eecs_batch_t batch) {
+	eecs_entity_t* handles = eecs_collect_batch_entities(batch);
+	eecs_destroy_entities(batch.world, handles, batch.size);
+	eecs_free(batch.world->options.memctx, handles);
+}
+
+void
+eecs_morph_entities_in_batch(
+	eecs_batch_t batch,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+) {
+	eecs_entity_t* handles = eecs_collect_batch_entities(batch);
+	eecs_morph_entities(batch.world, handles, batch.size, new_components, removed_components);
+	eecs_free(batch.world->options.memctx, handles);
+}
+
+void
+eecs_destroy_entities_matching(
+	eecs_world_t* world,
+	const eecs_component_t* require_components,
+	const eecs_component_t* exclude_components
+) {
+	eecs_sync_world(world);
+
+	eecs_id_t count;
+	eecs_entity_t* handles = eecs_collect_matching_entities(
+		world, require_components, exclude_components, &count
+	);
+	eecs_destroy_entities(world, handles, count);
+	eecs_free(world->options.memctx, handles);
+}
+
+void
+eecs_morph_entities_matching(
+	eecs_world_t* world,
+	const eecs_component_t* require_components,
+	const eecs_component_t* exclude_components,
+	const eecs_component_init_t* new_components,
+	const eecs_component_t* removed_components
+) {
+	eecs_sync_world(world);
+
+	eecs_id_t count;
+	eecs_entity_t* handles = eecs_collect_matching_entities(
+		world, require_components, exclude_components, &count
+	);
+	eecs_morph_entities(world, handles, count, new_components, removed_components);
+	eecs_free(world->options.memctx, handles);
+}
+
+void
+eecs_register_template(
+	eecs_world_t* world,
+	eecs_template_t* handle,
+	const eecs_component_init_t* init
+) {
+	eecs_sync_world(world);
+
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+	void* memctx = world->options.memctx;
+
+	eecs_template_data_t* entity_template;
+	if (handle->from_1_index == 0) {
+		eecs_array_push(memctx, world->templates, (eecs_template_data_t){ 0 });
+		entity_template = &eecs_array_back(world->templates);
+		handle->from_1_index = eecs_array_length(world->templates);
+	} else {
+		entity_template = &world->templates[eecs_index_of(*handle)];
+
+		eecs_id_t old_signature_length = entity_template->table->signature.length;
+		for (eecs_id_t i = 0; i < old_signature_length; ++i) {
+			eecs_free(memctx, (void*)entity_template->init_data[i].data);
+		}
+	}
+
+	for (eecs_id_t i = 0; init != NULL && init[i].component.from_1_index != 0; ++i) {
+		EECS_ASSERT(
+			!eecs_is_sparse_component(world->ecs, init[i].component),
+			"Templates cannot have sparse components"
+		);
+	}
+
+	eecs_component_init_t* init_copy;
+	eecs_table_t* table;
+	eecs_parse_component_init(world, init, &init_copy, &table);
+
+	entity_template->table = table;
+	entity_template->init_data = eecs_realloc(
+		memctx,
+		entity_template->init_data,
+		sizeof(eecs_component_init_t) * table->signature.length
+	);
+
+	const eecs_t* ecs = world->ecs;
+	for (eecs_id_t i = 0; i < table->signature.length; ++i) {
+		const eecs_component_options_t* component_options = &ecs->components[eecs_index_of(init_copy[i].component)];
+		eecs_component_init_t* init_data = &entity_template->init_data[i];
+
+		init_data->component = init_copy[i].component;
+
+		if (init_copy[i].data != NULL) {
+			void* data_copy = eecs_malloc(memctx, component_options->size);
+			memcpy(data_copy, init_copy[i].data, component_options->size);
+
+			init_data->data = data_copy;
+		} else {
+			init_data->data = NULL;
+		}
+	}
+
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+}
+
+eecs_entity_t
+eecs_create_entity_from_template(
+	eecs_world_t* world,
+	eecs_template_t entity_template,
+	const eecs_component_init_t* overrides
+) {
+	eecs_sync_world(world);
+	EECS_ASSERT(!world->parallel_update, "Cannot create entities during a parallel update");
+	EECS_ASSERT(!world->structure_locked, "System declared no structural changes");
+
+	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+
+	EECS_ASSERT(entity_template.from_1_index > 0, "Invalid template");
+	const eecs_template_data_t* template_data = &world->templates[eecs_index_of(entity_template)];
+	eecs_table_t* table = template_data->table;
+
+	eecs_component_init_t* init_data;
+
+	if (overrides != NULL) {
+		init_data = eecs_arena_alloc(
+			world, &world->tmp_arena,
+			sizeof(eecs_component_init_t) * table->signature.length,
+			_Alignof(eecs_component_init_t)
+		);
+		memcpy(
+			init_data,
+			template_data->init_data,
+			sizeof(eecs_component_init_t) * table->signature.length
+		);
+
+		for (eecs_id_t i = 0; overrides[i].component.from_1_index != 0; ++i) {
+			eecs_id_t column = eecs_find_column(table, overrides[i].component);
+			if (column >= 0) {
+				init_data[column].data = overrides[i].data;
+			}
+		}
+	} else {
+		init_data = template_data->init_data;
+	}
+
+	eecs_entity_t entity = eecs_create_entity_for_table(world, table, init_data);
+
+	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+	return entity;
+}
+
+EECS_PRIVATE eecs_bitset_t*
+eecs_make_query_bitset(eecs_world_t* world, const eecs_component_t* components) {
+	eecs_id_t num_available_components = eecs_array_length(world->ecs->components);
+	eecs_bitset_t* bitset = eecs_malloc(
+		world->options.memctx, eecs_bitset_memory_size(num_available_components)
+	);
+	eecs_bitset_init(bitset, num_available_components);
+
+	for (eecs_id_t i = 0; components != NULL && components[i].from_1_index != 0; ++i) {
+		eecs_bitset_set(bitset, eecs_index_of(components[i]));
+	}
+
+	return bitset;
+}
+
+eecs_query_t*
+eecs_create_query(eecs_world_t* world, eecs_query_options_t options) {
+	eecs_sync_world(world);
+	void* memctx = world->options.memctx;
+	eecs_id_t num_required = eecs_component_list_length(options.require_components);
+	eecs_id_t num_optional = eecs_component_list_length(options.optional_components);
+
+	eecs_query_t* query = eecs_malloc(memctx, sizeof(eecs_query_t));
+	*query = (eecs_query_t){
+		.world = world,
+		.index = eecs_array_length(world->queries),
+		.require_bitset = eecs_make_query_bitset(world, options.require_components),
+		.exclude_bitset = eecs_make_query_bitset(world, options.exclude_components),
+		.num_components = num_required + num_optional,
+		.components = eecs_malloc(
+			memctx, sizeof(eecs_component_t) * eecs_max(num_required + num_optional, 1)
+		),
+	};
+	for (eecs_id_t i = 0; i < num_required; ++i) {
+		query->components[i] = options.require_components[i];
+	}
+	for (eecs_id_t i = 0; i < num_optional; ++i) {
+		query->components[num_required + i] = options.optional_components[i];
+	}
+	query->sparse_filter = eecs_make_sparse_filter(
+		world, NULL,
+		options.require_components,
+		options.exclude_components,
+		options.optional_components,
+		query->require_bitset,
+		query->exclude_bitset
+	);
+	if (query->sparse_filter.components != NULL) {
+		query->run_offsets = eecs_malloc(
+			memctx, sizeof(ptrdiff_t) * eecs_max(query->num_components, 1)
+		);
+	}
+	eecs_array_push(memctx, world->queries, query);
+
+	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+		eecs_try_match_query_with_table(query, *itr.value);
+	}
+
+	return query;
+}
+
+void
+eecs_destroy_query(eecs_query_t* query) {
+	eecs_world_t* world = query->world;
+	void* memctx = world->options.memctx;
+
+	eecs_query_t* last_query = eecs_array_pop(world->queries);
+	world->queries[query->index] = last_query;
+	last_query->index = query->index;
+
+	eecs_array_free(memctx, query->matched_tables);
+	eecs_array_free(memctx, query->component_storage_offsets);
+	eecs_array_free(memctx, query->enable_mask_offsets);
+	eecs_free(memctx, query->components);
+	eecs_free(memctx, query->sparse_filter.components);
+	eecs_free(memctx, query->sparse_filter.batch_component_sizes);
+	eecs_free(memctx, query->run_offsets);
+	eecs_free(memctx, query->require_bitset);
+	eecs_free(memctx, query->exclude_bitset);
+	eecs_free(memctx, query);
+}
+
+eecs_query_iterator_t
+eecs_iterate_query(eecs_query_t* query) {
+	return (eecs_query_iterator_t){ .query = query };
+}
+
+bool
+eecs_next_query_batch(eecs_query_iterator_t* itr, eecs_batch_t* batch) {
+	eecs_query_t* query = itr->query;
+	const eecs_sparse_filter_t* filter = &query->sparse_filter;
+	for (; itr->match_index < eecs_array_length(query->matched_tables); ++itr->match_index) {
+		eecs_table_t* table = query->matched_tables[itr->match_index];
+		ptrdiff_t* offsets = query->num_components > 0
+			? &query->component_storage_offsets[itr->match_index * query->num_components]
+			: NULL;
+		ptrdiff_t* enable_mask_offsets = table->num_enableable_columns > 0 && query->num_components > 0
+			? &query->enable_mask_offsets[itr->match_index * query->num_components]
+			: NULL;
+		if (filter->components == NULL) {
+			if (itr->chunk_index < eecs_array_length(table->chunks)) {
+				// Queries do not declare their accesses
+				eecs_own_chunk(query->world, table, itr->chunk_index);
+				*batch = eecs_make_table_batch(query->world, table, offsets, enable_mask_offsets, itr->chunk_index++);
+				return true;
+			}
+		} else {
+			for (; itr->chunk_index < eecs_array_length(table->chunks); ++itr->chunk_index) {
+				eecs_batch_t chunk_batch = eecs_make_table_batch(query->world, table, offsets, enable_mask_offsets, itr->chunk_index);
+				eecs_id_t begin = itr->row_index;
+				eecs_id_t end;
+				if (eecs_next_sparse_run(query->world, filter, chunk_batch, &begin, &end)) {
+					eecs_own_chunk(query->world, table, itr->chunk_index);
+					chunk_batch = eecs_make_table_batch(query->world, table, offsets, enable_mask_offsets, itr->chunk_index);
+					*batch = eecs_slice_batch(chunk_batch, filter, begin, end, query->run_offsets);
+					itr->row_index = end;
+					return true;
+				}
+
+				itr->row_index = 0;
+			}
+		}
+
+		itr->chunk_index = 0;
+	}
+
+	return false;
+}
+
+void
+eecs_run_systems(eecs_world_t* world, eecs_mask_t update_mask) {
+	EECS_ASSERT(
+		world->current_update_table == NULL && !world->parallel_update,
+		"eecs_run_systems is not reentrant"
+	);
+
+	eecs_sync_world(world);
+
+	world->update_mask = update_mask;
+
+	const eecs_t* ecs = world->ecs;
+	if (world->num_workers > 1) {
+		const eecs_schedule_t* schedule = eecs_get_schedule(world, update_mask);
+
+		eecs_id_t stage_begin = 0;
+		eecs_array_indexed_foreach(eecs_id_t, stage_itr, schedule->stage_ends) {
+			eecs_id_t stage_end = *stage_itr.value;
+			const eecs_id_t* systems = &schedule->systems[stage_begin];
+
+			if (stage_end - stage_begin == 1) {
+				eecs_do_run_system(world, &ecs->systems[systems[0]], &world->system_data[systems[0]]);
+			} else {
+				eecs_run_stage(world, systems, stage_end - stage_begin);
+			}
+
+			stage_begin = stage_end;
+		}
+	} else {
+		eecs_array_indexed_foreach(
+			eecs_system_data_t,
+			sys_itr,
+			world->system_data
+		) {
+			const eecs_system_options_t* system_options = &ecs->systems[sys_itr.index];
+			if ((update_mask & system_options->update_mask) == system_options->update_mask) {
+				eecs_do_run_system(world, system_options, sys_itr.value);
+			}
+		}
+	}
+
+	world->update_mask = EECS_UPDATE_NONE;
+}
+
+void
+eecs_run_system(eecs_world_t* world, eecs_mask_t update_mask, eecs_system_t system) {
+	EECS_ASSERT(
+		world->current_update_table == NULL && !world->parallel_update,
+		"eecs_run_system is not reentrant"
+	);
+
+	eecs_sync_world(world);
+
+	world->update_mask = update_mask;
+
+	const eecs_system_options_t* system_options = &world->ecs->systems[eecs_index_of(system)];
+	eecs_system_data_t* system_data = &world->system_data[eecs_index_of(system)];
+	eecs_do_run_system(world, system_options, system_data);
+
+	world->update_mask = EECS_UPDATE_NONE;
+}
+
+void
+eecs_mark_component_changed(
+	eecs_world_t* world,
+	eecs_entity_t entity,
+	eecs_component_t component
+) {
+	const eecs_entity_data_t* entity_data = eecs_get_entity_data(world, entity);
+	if (entity_data == NULL) { return; }
+
+	eecs_table_t* table = entity_data->table;
+	eecs_id_t column = eecs_find_column(table, component);
+	if (column < 0) { return; }
+
+	eecs_id_t chunk_index = entity_data->pos_in_table / table->num_entities_per_chunk;
+	table->change_ticks[chunk_index * table->signature.length + column] = world->change_tick;
+}
+
+void
+eecs_set_component_enabled(
+	eecs_world_t* world,
+	eecs_entity_t entity,
+	eecs_component_t component,
+	bool enabled
+) {
+	EECS_ASSERT(
+		world->ecs->components[eecs_index_of(component)].enableable,
+		"Component is not enableable"
+	);
+	const eecs_entity_data_t* entity_data = eecs_get_entity_data(world, entity);
+	if (entity_data == NULL) { return; }
+
+	eecs_table_t* table = entity_data->table;
+	eecs_id_t column = eecs_find_column(table, component);
+	eecs_id_t pos_in_table = entity_data->pos_in_table;
+	// Unchanged bits do not unshare the chunk nor wake changed filters
+	if (column < 0 || eecs_is_row_enabled(table, column, pos_in_table) == enabled) { return; }
+
+	eecs_own_rows(world, table, pos_in_table, 1);
+	eecs_set_rows_enabled(table, column, pos_in_table, 1, enabled);
+	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
+	table->change_ticks[chunk_index * table->signature.length + column] = world->change_tick;
+}
+
+bool
+eecs_is_component_enabled(
+	eecs_world_t* world,
+	eecs_entity_t entity,
+	eecs_component_t component
+) {
+	const eecs_entity_data_t* entity_data = eecs_get_entity_data(world, entity);
+	if (entity_data == NULL) { return false; }
+
+	const eecs_table_t* table = entity_data->table;
+	eecs_id_t column = eecs_find_column(table, component);
+	if (column < 0) {
+		return eecs_get_sparse_component(world, eecs_index_of(component), entity.from_1_index) != NULL;
+	}
+
+	return table->enable_mask_offsets[column] < 0
+		|| eecs_is_row_enabled(table, column, entity_data->pos_in_table);
+}
+
+eecs_mask_t
+eecs_get_current_update_mask(eecs_world_t* world) {
+	return world->update_mask;
+}
+
+bool
+eecs_get_world_stats(eecs_world_t* world, eecs_world_stats_t* stats) {
+#ifdef EECS_STATS
+	*stats = world->stats;
+	return true;
+#else
+	(void)world;
+	(void)stats;
+	return false;
+#endif
+}
+
+bool
+eecs_get_system_stats(
+	eecs_world_t* world,
+	eecs_system_t system,
+	eecs_system_stats_t* stats
+) {
+#ifdef EECS_STATS
+	eecs_sync_world(world);
+
+	const eecs_system_data_t* system_data = &world->system_data[eecs_index_of(system)];
+	*stats = system_data->stats;
+	stats->num_matched_tables = eecs_array_length(system_data->matched_tables);
+	return true;
+#else
+	(void)world;
+	(void)system;
+	(void)stats;
+	return false;
+#endif
+}
+
+void
+eecs_reset_stats(eecs_world_t* world) {
+#ifdef EECS_STATS
+	world->stats = (eecs_world_stats_t){ 0 };
+	eecs_array_indexed_foreach(eecs_system_data_t, itr, world->system_data) {
+		itr.value->stats = (eecs_system_stats_t){ 0 };
+	}
+#else
+	(void)world;
+#endif
+}
+
+EECS_PRIVATE eecs_id_t
+eecs_count_arena_chunks(const eecs_arena_t* arena) {
+	eecs_id_t num_chunks = 0;
+	for (const eecs_arena_chunk_t* itr = arena->current_chunk; itr != NULL; itr = itr->previous) {
+		++num_chunks;
+	}
+	return num_chunks;
+}
+
+void
+eecs_get_world_memory(eecs_world_t* world, eecs_world_memory_t* memory) {
+	*memory = (eecs_world_memory_t){
+		.table_chunk_size = world->options.table_chunk_size,
+		.num_tables = eecs_array_length(world->tables),
+		.num_version_arena_chunks = eecs_count_arena_chunks(&world->version_arena),
+		.num_deferred_arena_chunks = eecs_count_arena_chunks(&world->deferred_arena),
+		.num_tmp_arena_chunks = eecs_count_arena_chunks(&world->tmp_arena),
+		.num_entity_slots = world->num_entity_slots,
+		.entity_slot_capacity = eecs_array_length(world->entity_pages) * EECS_ENTITY_PAGE_SIZE,
+	};
+
+	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+		memory->num_table_chunks += eecs_array_length((*itr.value)->chunks);
+	}
+
+	for (eecs_id_t i = 0; i < world->num_workers; ++i) {
+		memory->num_deferred_arena_chunks += eecs_count_arena_chunks(&world->workers[i].deferred_arena);
+	}
+
+	eecs_lock_chunks(world);
+	for (
+		const eecs_table_chunk_header_t* itr = world->next_free_table_chunks;
+		itr != NULL;
+		itr = itr->next
+	) {
+		++memory->num_pooled_chunks;
+	}
+	eecs_unlock_chunks(world);
+
+	// The free lists may be waiting for a relink, the NULL tables are not
+	for (eecs_id_t i = 1; i <= world->num_entity_slots; ++i) {
+		if (eecs_entity_slot(world, i)->table == NULL) {
+			++memory->num_free_entity_slots;
+		}
+	}
+}
+
+eecs_id_t
+eecs_get_table_memory(
+	eecs_world_t* world,
+	eecs_table_memory_t* tables,
+	eecs_id_t max_tables
+) {
+	eecs_id_t num_tables = eecs_array_length(world->tables);
+	for (eecs_id_t i = 0; i < num_tables && i < max_tables; ++i) {
+		const eecs_table_t* table = world->tables[i];
+
+		size_t entity_size = sizeof(eecs_id_t);
+		for (eecs_id_t j = 0; j < table->signature.length; ++j) {
+			entity_size += table->component_sizes[j];
+		}
+		size_t used_size = entity_size * (size_t)table->num_entities_per_chunk;
+
+		tables[i] = (eecs_table_memory_t){
+			.components = table->signature.components,
+			.num_components = table->signature.length,
+			.num_entities = table->num_entities,
+			.num_chunks = eecs_array_length(table->chunks),
+			.num_entities_per_chunk = table->num_entities_per_chunk,
+			.entity_size = entity_size,
+			.alignment_waste_per_entity =
+				(world->options.table_chunk_size - used_size)
+				/ (size_t)table->num_entities_per_chunk,
+		};
+	}
+
+	return num_tables;
+}
+
+void
+eecs_compact_world(eecs_world_t* world, eecs_id_t max_pooled_chunks) {
+	EECS_ASSERT(
+		world->current_update_table == NULL && !world->parallel_update && world->bulk_depth == 0,
+		"Cannot compact a world while it is being updated"
+	);
+	EECS_ASSERT(max_pooled_chunks >= 0, "Invalid max_pooled_chunks");
+
+	void* memctx = world->options.memctx;
+	eecs_own_entities(world);
+
+	// Rows are always dense thanks to swap-remove and empty trailing chunks
+	// are released right away so only the bookkeeping arrays can be trimmed
+	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+		eecs_table_t* table = *itr.value;
+		eecs_array_shrink_to_fit(memctx, table->chunks);
+		eecs_array_shrink_to_fit(memctx, table->shared_chunks);
+		eecs_array_shrink_to_fit(memctx, table->change_ticks);
+	}
+
+	eecs_array_indexed_foreach(eecs_id_t, itr, world->sparse_components) {
+		eecs_sparse_set_t* set = &world->sparse_sets[*itr.value];
+		if (set->data == NULL) { continue; }
+
+		eecs_id_t num_slots = eecs_array_length(set->positions);
+		while (num_slots > 0 && set->positions[num_slots - 1] == 0) { --num_slots; }
+		eecs_array_resize(memctx, set->positions, num_slots);
+		eecs_array_shrink_to_fit(memctx, set->positions);
+
+		eecs_array_shrink_to_fit(memctx, set->entities);
+		set->data = eecs_realloc(
+			memctx, set->data,
+			eecs_max(set->component_size * (size_t)eecs_array_capacity(set->entities), (size_t)1)
+		);
+	}
+
+	eecs_table_chunk_header_t** link = &world->next_free_table_chunks;
+	for (eecs_id_t i = 0; i < max_pooled_chunks && *link != NULL; ++i) {
+		link = &(*link)->next;
+	}
+	eecs_free_chunks(world, *link);
+	*link = NULL;
+
+	// Drop the trailing free slots and their pages, remembering their generations
+	eecs_id_t num_slots = world->num_entity_slots;
+	while (num_slots > 0 && eecs_entity_slot(world, num_slots)->table == NULL) {
+		world->new_entity_gen = eecs_max(world->new_entity_gen, eecs_entity_slot(world, num_slots)->gen);
+		--num_slots;
+	}
+	eecs_truncate_entity_slots(world, num_slots);
+	eecs_relink_free_entity_slots(world);
+
+	eecs_array_free(memctx, world->parallel_tasks);
+	world->parallel_tasks = NULL;
+}
+
+EECS_PRIVATE bool
+eecs_snapshot_read(eecs_snapshot_reader_t* reader, void* out, size_t size) {
+	if (reader->size - reader->pos < size) { return false; }
+	memcpy(out, reader->data + reader->pos, size);
+	reader->pos += size;
+	return true;
+}
+
+EECS_PRIVATE const char*
+eecs_snapshot_skip(eecs_snapshot_reader_t* reader, size_t size) {
+	if (reader->size - reader->pos < size) { return NULL; }
+	const char* data = reader->data + reader->pos;
+	reader->pos += size;
+	return data;
+}
+
+EECS_PRIVATE eecs_snapshot_entity_t
+eecs_make_snapshot_entity(const eecs_entity_data_t* entity_data) {
+	return (eecs_snapshot_entity_t){
+		.table_index = entity_data->table != NULL ? entity_data->table->index : -1,
+		.gen = entity_data->gen,
+		.pos_in_table = entity_data->table != NULL ? entity_data->pos_in_table : 0,
+	};
+}
+
+bool
+eecs_save_world(eecs_world_t* world, eecs_write_fn_t write_fn, void* userdata) {
+	eecs_sync_world(world);
+	EECS_ASSERT(
+		world->current_update_table == NULL && !world->parallel_update && world->bulk_depth == 0,
+		"Cannot save a world while it is being updated"
+	);
+	if (world->rebase_entities) { eecs_own_entities(world); }
+
+	const eecs_t* ecs = world->ecs;
+	size_t chunk_size = world->options.table_chunk_size;
+	eecs_id_t num_slots = world->num_entity_slots;
+
+	eecs_id_t num_sparse_sets = 0;
+	eecs_array_indexed_foreach(eecs_id_t, itr, world->sparse_components) {
+		num_sparse_sets += eecs_array_length(world->sparse_sets[*itr.value].entities) > 0;
+	}
+
+	eecs_snapshot_header_t header = {
+		.version = EECS_SNAPSHOT_VERSION,
+		.byte_order = EECS_SNAPSHOT_BYTE_ORDER,
+		.id_size = sizeof(eecs_id_t),
+		.chunk_size = chunk_size,
+		.num_components = (uint64_t)eecs_array_length(ecs->components),
+		.num_tables = (uint64_t)eecs_array_length(world->tables),
+		.num_entity_slots = (uint64_t)num_slots,
+		.new_entity_gen = (uint64_t)world->new_entity_gen,
+		.num_sparse_sets = (uint64_t)num_sparse_sets,
+	};
+	memcpy(header.magic, EECS_SNAPSHOT_MAGIC, sizeof(header.magic));
+	if (!write_fn(&header, sizeof(header), userdata)) { return false; }
+
+	eecs_array_indexed_foreach(eecs_component_options_t, itr, ecs->components) {
+		eecs_snapshot_component_t component = {
+			.size = itr.value->size,
+			.alignment = itr.value->alignment,
+			.storage = (uint64_t)itr.value->storage,
+			.enableable = itr.value->enableable,
+		};
+		if (!write_fn(&component, sizeof(component), userdata)) { return false; }
+	}
+
+	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+		const eecs_table_t* table = *itr.value;
+		eecs_snapshot_table_t table_header = {
+			.num_columns = (uint64_t)table->signature.length,
+			.num_entities = (uint64_t)table->num_entities,
+			.num_entities_per_chunk = (uint64_t)table->num_entities_per_chunk,
+			.num_chunks = (uint64_t)eecs_array_length(table->chunks),
+		};
+		if (!write_fn(&table_header, sizeof(table_header), userdata)) { return false; }
+
+		for (eecs_id_t i = 0; i < table->signature.length; ++i) {
+			eecs_snapshot_column_t column = {
+				.component_index = (uint64_t)eecs_index_of(table->signature.components[i]),
+				.storage_offset = (uint64_t)table->component_storage_offsets[i],
+				.enable_mask_offset = (uint64_t)table->enable_mask_offsets[i],
+			};
+			if (!write_fn(&column, sizeof(column), userdata)) { return false; }
+		}
+
+		eecs_array_indexed_foreach(char*, chunk_itr, table->chunks) {
+			if (!write_fn(*chunk_itr.value, chunk_size, userdata)) { return false; }
+		}
+	}
+
+	bool succeeded = true;
+	eecs_snapshot_entity_t entities[256];
+	for (eecs_id_t begin = 0; succeeded && begin < num_slots; begin += 256) {
+		eecs_id_t end = eecs_min(begin + 256, num_slots);
+		for (eecs_id_t i = begin; i < end; ++i) {
+			entities[i - begin] = eecs_make_snapshot_entity(eecs_entity_slot(world, i + 1));
+		}
+		succeeded = write_fn(entities, sizeof(entities[0]) * (size_t)(end - begin), userdata);
+	}
+
+	eecs_array_indexed_foreach(eecs_id_t, itr, world->sparse_components) {
+		const eecs_sparse_set_t* set = &world->sparse_sets[*itr.value];
+		eecs_id_t num_members = eecs_array_length(set->entities);
+		if (!succeeded || num_members == 0) { continue; }
+
+		eecs_snapshot_sparse_set_t set_header = {
+			.component_index = (uint64_t)*itr.value,
+			.num_entities = (uint64_t)num_members,
+		};
+		succeeded = write_fn(&set_header, sizeof(set_header), userdata)
+			&& write_fn(set->entities, sizeof(eecs_id_t) * (size_t)num_members, userdata)
+			&& write_fn(set->data, set->component_size * (size_t)num_members, userdata);
+	}
+
+	return succeeded;
+}
+
+bool
+eecs_load_world(
+	eecs_world_t* world,
+	const void* snapshot,
+	size_t size,
+	eecs_load_options_t options
+) {
+	eecs_sync_world(world);
+	EECS_ASSERT(
+		world->current_update_table == NULL && !world->parallel_update && world->bulk_depth == 0,
+		"Cannot load into a world while it is being updated"
+	);
+	EECS_ASSERT(
+		world->num_entity_slots == 0,
+		"Snapshots can only be loaded into a world without entities"
+	);
+
+	const eecs_t* ecs = world->ecs;
+	void* memctx = world->options.memctx;
+	eecs_id_t num_available_components = eecs_array_length(ecs->components);
+	eecs_snapshot_reader_t reader = { .data = snapshot, .size = size };
+	uint64_t max_id = ((uint64_t)1 << (sizeof(eecs_id_t) * CHAR_BIT - 1)) - 1;
+
+	eecs_snapshot_header_t header;
+	if (
+		!eecs_snapshot_read(&reader, &header, sizeof(header))
+		|| memcmp(header.magic, EECS_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+		|| header.version != EECS_SNAPSHOT_VERSION
+		|| header.byte_order != EECS_SNAPSHOT_BYTE_ORDER
+		|| header.id_size != sizeof(eecs_id_t)
+		|| header.chunk_size < sizeof(eecs_id_t)
+		|| header.num_entity_slots > max_id
+		|| header.num_tables > max_id
+		|| header.num_components > max_id
+		|| header.num_sparse_sets > header.num_components
+	) {
+		return false;
+	}
+
+	eecs_id_t num_components = (eecs_id_t)header.num_components;
+	eecs_id_t num_tables = (eecs_id_t)header.num_tables;
+	eecs_id_t num_slots = (eecs_id_t)header.num_entity_slots;
+	size_t chunk_size = (size_t)header.chunk_size;
+
+	// Validate everything before touching the world so that a bad snapshot
+	// leaves it empty
+	size_t* component_sizes = eecs_malloc(memctx, sizeof(size_t) * (size_t)eecs_max(num_components, 1));
+	eecs_component_t* component_map = eecs_malloc(
+		memctx, sizeof(eecs_component_t) * (size_t)eecs_max(num_components, 1)
+	);
+	eecs_bitset_t* mapped_components = eecs_malloc(memctx, eecs_bitset_memory_size(num_available_components));
+	eecs_bitset_init(mapped_components, num_available_components);
+	eecs_bitset_t* sparse_components = eecs_malloc(memctx, eecs_bitset_memory_size(num_components));
+	eecs_bitset_init(sparse_components, num_components);
+	eecs_bitset_t* enableable_components = eecs_malloc(memctx, eecs_bitset_memory_size(num_components));
+	eecs_bitset_init(enableable_components, num_components);
+	eecs_bitset_t* table_components = eecs_malloc(memctx, eecs_bitset_memory_size(num_components));
+	// Offset of each table in the snapshot
+	size_t* table_positions = eecs_malloc(memctx, sizeof(size_t) * (size_t)eecs_max(num_tables, 1));
+	eecs_id_t* table_sizes = eecs_malloc(memctx, sizeof(eecs_id_t) * (size_t)eecs_max(num_tables, 1));
+	// Saved chunks of each table and their capacity
+	const char** table_chunks = eecs_malloc(memctx, sizeof(const char*) * (size_t)eecs_max(num_tables, 1));
+	eecs_id_t* table_entities_per_chunk = eecs_malloc(memctx, sizeof(eecs_id_t) * (size_t)eecs_max(num_tables, 1));
+	eecs_component_t* signature = eecs_malloc(
+		memctx, sizeof(eecs_component_t) * (size_t)eecs_max(num_available_components, 1)
+	);
+	eecs_table_t** tables = eecs_malloc(memctx, sizeof(eecs_table_t*) * (size_t)eecs_max(num_tables, 1));
+	eecs_id_t* first_positions = eecs_malloc(memctx, sizeof(eecs_id_t) * (size_t)eecs_max(num_tables, 1));
+
+	bool valid = true;
+	for (eecs_id_t i = 0; valid && i < num_components; ++i) {
+		eecs_snapshot_component_t component;
+		eecs_component_t mapped = options.component_map != NULL
+			? options.component_map[i]
+			: (eecs_component_t){ .from_1_index = i + 1 };
+		valid = eecs_snapshot_read(&reader, &component, sizeof(component))
+			&& component.storage <= EECS_STORAGE_SPARSE
+			&& component.enableable <= 1
+			&& 0 <= mapped.from_1_index && mapped.from_1_index <= num_available_components
+			&& (
+				mapped.from_1_index == 0
+				|| (
+					ecs->components[eecs_index_of(mapped)].size == component.size
+					&& ecs->components[eecs_index_of(mapped)].storage == component.storage
+					&& ecs->components[eecs_index_of(mapped)].enableable == (bool)component.enableable
+					&& !eecs_bitset_is_set(mapped_components, eecs_index_of(mapped))
+				)
+			);
+		if (valid && mapped.from_1_index != 0) {
+			eecs_bitset_set(mapped_components, eecs_index_of(mapped));
+		}
+		if (valid && component.storage == EECS_STORAGE_SPARSE) {
+			eecs_bitset_set(sparse_components, i);
+		}
+		if (valid && component.enableable) {
+			eecs_bitset_set(enableable_components, i);
+		}
+		component_sizes[i] = (size_t)component.size;
+		component_map[i] = mapped;
+	}
+
+	for (eecs_id_t i = 0; valid && i < num_tables; ++i) {
+		table_positions[i] = reader.pos;
+		eecs_snapshot_table_t table;
+		valid = eecs_snapshot_read(&reader, &table, sizeof(table))
+			&& table.num_columns <= (uint64_t)num_components
+			&& table.num_entities_per_chunk > 0
+			&& table.num_entities_per_chunk <= chunk_size / sizeof(eecs_id_t)
+			&& table.num_entities <= max_id
+			&& table.num_chunks == (table.num_entities + table.num_entities_per_chunk - 1) / table.num_entities_per_chunk;
+		eecs_bitset_init(table_components, num_components);
+		for (uint64_t j = 0; valid && j < table.num_columns; ++j) {
+			eecs_snapshot_column_t column;
+			valid = eecs_snapshot_read(&reader, &column, sizeof(column))
+				&& column.component_index < (uint64_t)num_components
+				&& !eecs_bitset_is_set(table_components, (eecs_id_t)column.component_index)
+				&& !eecs_bitset_is_set(sparse_components, (eecs_id_t)column.component_index)
+				&& column.storage_offset <= chunk_size
+				&& component_sizes[column.component_index] * table.num_entities_per_chunk
+					<= chunk_size - column.storage_offset
+				&& (
+					eecs_bitset_is_set(enableable_components, (eecs_id_t)column.component_index)
+						? (
+							column.enable_mask_offset <= chunk_size
+							&& sizeof(eecs_mask_t) * (size_t)eecs_num_enable_masks((eecs_id_t)table.num_entities_per_chunk)
+								<= chunk_size - column.enable_mask_offset
+						)
+						: column.enable_mask_offset == UINT64_MAX
+				);
+			if (valid) { eecs_bitset_set(table_components, (eecs_id_t)column.component_index); }
+		}
+		const char* chunks = valid && table.num_chunks <= SIZE_MAX / chunk_size
+			? eecs_snapshot_skip(&reader, (size_t)table.num_chunks * chunk_size)
+			: NULL;
+		valid = chunks != NULL;
+		table_sizes[i] = valid ? (eecs_id_t)table.num_entities : 0;
+		table_chunks[i] = chunks;
+		table_entities_per_chunk[i] = valid ? (eecs_id_t)table.num_entities_per_chunk : 0;
+	}
+
+	// Each live slot must point at a row holding its own id. As many slots
+	// as rows make it one slot per row.
+	size_t directory_size = sizeof(eecs_snapshot_entity_t) * (size_t)num_slots;
+	const char* directory = valid ? eecs_snapshot_skip(&reader, directory_size) : NULL;
+	valid = directory != NULL;
+	uint64_t num_live_slots = 0;
+	for (eecs_id_t i = 0; valid && i < num_slots; ++i) {
+		eecs_snapshot_entity_t entity;
+		memcpy(&entity, directory + sizeof(entity) * (size_t)i, sizeof(entity));
+		valid = entity.table_index < 0
+			? entity.pos_in_table == 0
+			: (
+				entity.table_index < num_tables
+				&& 0 <= entity.pos_in_table && entity.pos_in_table < table_sizes[entity.table_index]
+			);
+		if (!valid || entity.table_index < 0) { continue; }
+
+		eecs_id_t per_chunk = table_entities_per_chunk[entity.table_index];
+		eecs_id_t row_id;
+		memcpy(
+			&row_id,
+			table_chunks[entity.table_index]
+				+ chunk_size * (size_t)(entity.pos_in_table / per_chunk)
+				+ sizeof(eecs_id_t) * (size_t)(entity.pos_in_table % per_chunk),
+			sizeof(row_id)
+		);
+		valid = row_id == i + 1;
+		++num_live_slots;
+	}
+	for (eecs_id_t i = 0; valid && i < num_tables; ++i) {
+		num_live_slots -= (uint64_t)table_sizes[i];
+	}
+	valid = valid && num_live_slots == 0;
+
+	// Each sparse component has at most one set, whose members are live
+	// entities listed once
+	size_t sparse_sets_position = reader.pos;
+	eecs_bitset_t* saved_sets = eecs_malloc(memctx, eecs_bitset_memory_size(num_components));
+	eecs_bitset_init(saved_sets, num_components);
+	eecs_bitset_t* members = eecs_malloc(memctx, eecs_bitset_memory_size(num_slots));
+	eecs_bitset_init(members, num_slots);
+	for (uint64_t i = 0; valid && i < header.num_sparse_sets; ++i) {
+		eecs_snapshot_sparse_set_t set;
+		valid = eecs_snapshot_read(&reader, &set, sizeof(set))
+			&& set.component_index < (uint64_t)num_components
+			&& eecs_bitset_is_set(sparse_components, (eecs_id_t)set.component_index)
+			&& !eecs_bitset_is_set(saved_sets, (eecs_id_t)set.component_index)
+			&& set.num_entities <= (uint64_t)num_slots;
+		if (!valid) { break; }
+
+		eecs_bitset_set(saved_sets, (eecs_id_t)set.component_index);
+		size_t component_size = component_sizes[set.component_index];
+		eecs_id_t num_members = (eecs_id_t)set.num_entities;
+		const char* ids = eecs_snapshot_skip(&reader, sizeof(eecs_id_t) * (size_t)num_members);
+		valid = ids != NULL
+			&& (num_members == 0 || component_size <= SIZE_MAX / (size_t)num_members)
+			&& eecs_snapshot_skip(&reader, component_size * (size_t)num_members) != NULL;
+		for (eecs_id_t j = 0; valid && j < num_members; ++j) {
+			eecs_id_t from_1_index;
+			memcpy(&from_1_index, ids + sizeof(eecs_id_t) * (size_t)j, sizeof(from_1_index));
+			valid = 1 <= from_1_index && from_1_index <= num_slots
+				&& !eecs_bitset_is_set(members, from_1_index - 1);
+			if (valid) {
+				eecs_snapshot_entity_t entity;
+				memcpy(&entity, directory + sizeof(entity) * (size_t)(from_1_index - 1), sizeof(entity));
+				valid = entity.table_index >= 0;
+				eecs_bitset_set(members, from_1_index - 1);
+			}
+		}
+		for (eecs_id_t j = 0; valid && j < num_members; ++j) {
+			eecs_id_t from_1_index;
+			memcpy(&from_1_index, ids + sizeof(eecs_id_t) * (size_t)j, sizeof(from_1_index));
+			eecs_bitset_clear(members, from_1_index - 1);
+		}
+	}
+	eecs_free(memctx, members);
+	eecs_free(memctx, saved_sets);
+
+	for (eecs_id_t i = 0; valid && i < num_tables; ++i) {
+		reader.pos = table_positions[i];
+		eecs_snapshot_table_t saved_table;
+		eecs_snapshot_read(&reader, &saved_table, sizeof(saved_table));
+		eecs_id_t num_columns = (eecs_id_t)saved_table.num_columns;
+		eecs_snapshot_column_t* columns = eecs_malloc(
+			memctx, sizeof(eecs_snapshot_column_t) * (size_t)eecs_max(num_columns, 1)
+		);
+		eecs_snapshot_read(&reader, columns, sizeof(eecs_snapshot_column_t) * (size_t)num_columns);
+		const char* saved_chunks = reader.data + reader.pos;
+
+		eecs_id_t signature_length = 0;
+		for (eecs_id_t j = 0; j < num_columns; ++j) {
+			eecs_component_t component = component_map[columns[j].component_index];
+			if (component.from_1_index != 0) { signature[signature_length++] = component; }
+		}
+#define eecs_component_cmp_lt(lhs, rhs) ((lhs).from_1_index < (rhs).from_1_index)
+		eecs_insertion_sort(signature_length, signature, eecs_component_t, eecs_component_cmp_lt);
+#undef eecs_component_cmp_lt
+		eecs_table_t* table = tables[i] = eecs_get_table(world, (eecs_signature_t){
+			.length = signature_length,
+			.components = signature,
+		});
+
+		// Tables merged by dropped components are appended to
+		eecs_id_t first_pos = first_positions[i] = table->num_entities;
+		eecs_id_t num_entities = (eecs_id_t)saved_table.num_entities;
+		eecs_id_t dst_per_chunk = table->num_entities_per_chunk;
+		eecs_id_t src_per_chunk = (eecs_id_t)saved_table.num_entities_per_chunk;
+		table->num_entities += num_entities;
+		eecs_id_t num_chunks = (table->num_entities + dst_per_chunk - 1) / dst_per_chunk;
+		while (eecs_array_length(table->chunks) < num_chunks) {
+			eecs_push_table_chunk(world, table);
+		}
+		eecs_mark_rows_changed(world, table, first_pos, num_entities);
+
+		bool same_layout = first_pos == 0
+			&& chunk_size == world->options.table_chunk_size
+			&& src_per_chunk == dst_per_chunk
+			&& signature_length == num_columns;
+		for (eecs_id_t j = 0; same_layout && j < num_columns; ++j) {
+			eecs_id_t column = eecs_find_column(table, component_map[columns[j].component_index]);
+			same_layout = (uint64_t)table->component_storage_offsets[column] == columns[j].storage_offset
+				&& (uint64_t)table->enable_mask_offsets[column] == columns[j].enable_mask_offset;
+		}
+
+		if (same_layout) {
+			for (eecs_id_t j = 0; j < num_chunks; ++j) {
+				memcpy(table->chunks[j], saved_chunks + chunk_size * (size_t)j, chunk_size);
+			}
+		} else {
+			// Copy runs of rows which do not cross a chunk on either side
+			for (eecs_id_t row = 0; row < num_entities;) {
+				eecs_id_t src_pos = row % src_per_chunk;
+				eecs_id_t dst_pos = (first_pos + row) % dst_per_chunk;
+				eecs_id_t num_rows = eecs_min(
+					eecs_min(src_per_chunk - src_pos, dst_per_chunk - dst_pos),
+					num_entities - row
+				);
+				const char* src = saved_chunks + chunk_size * (size_t)(row / src_per_chunk);
+				char* dst = table->chunks[(first_pos + row) / dst_per_chunk];
+
+				memcpy(
+					dst + sizeof(eecs_id_t) * (size_t)dst_pos,
+					src + sizeof(eecs_id_t) * (size_t)src_pos,
+					sizeof(eecs_id_t) * (size_t)num_rows
+				);
+				for (eecs_id_t j = 0; j < num_columns; ++j) {
+					eecs_id_t column = eecs_find_column(table, component_map[columns[j].component_index]);
+					if (column < 0) { continue; }
+
+					size_t component_size = table->component_sizes[column];
+					memcpy(
+						dst + table->component_storage_offsets[column] + component_size * (size_t)dst_pos,
+						src + columns[j].storage_offset + component_size * (size_t)src_pos,
+						component_size * (size_t)num_rows
+					);
+					if (table->enable_mask_offsets[column] >= 0) {
+						const char* src_masks = src + columns[j].enable_mask_offset;
+						for (eecs_id_t k = 0; k < num_rows; ++k) {
+							eecs_mask_t mask;
+							size_t num_bits_per_mask = sizeof(eecs_mask_t) * CHAR_BIT;
+							size_t bit_index = (size_t)(src_pos + k);
+							memcpy(&mask, src_masks + sizeof(mask) * (bit_index / num_bits_per_mask), sizeof(mask));
+							eecs_set_rows_enabled(
+								table, column, first_pos + row + k, 1,
+								(mask >> (bit_index % num_bits_per_mask)) & 1
+							);
+						}
+					}
+				}
+				row += num_rows;
+			}
+		}
+
+		eecs_free(memctx, columns);
+	}
+
+	if (valid) {
+		eecs_grow_entity_slots(world, num_slots);
+		for (eecs_id_t i = 0; i < num_slots; ++i) {
+			eecs_snapshot_entity_t entity;
+			memcpy(&entity, directory + sizeof(entity) * (size_t)i, sizeof(entity));
+			*eecs_entity_slot(world, i + 1) = (eecs_entity_data_t){
+				.table = entity.table_index >= 0 ? tables[entity.table_index] : NULL,
+				.gen = entity.gen,
+				.pos_in_table = entity.table_index >= 0
+					? first_positions[entity.table_index] + entity.pos_in_table
+					: 0,
+			};
+		}
+		eecs_relink_free_entity_slots(world);
+		world->new_entity_gen = (eecs_id_t)header.new_entity_gen;
+
+		reader.pos = sparse_sets_position;
+		for (uint64_t i = 0; i < header.num_sparse_sets; ++i) {
+			eecs_snapshot_sparse_set_t saved_set;
+			eecs_snapshot_read(&reader, &saved_set, sizeof(saved_set));
+			eecs_id_t num_members = (eecs_id_t)saved_set.num_entities;
+			size_t component_size = component_sizes[saved_set.component_index];
+			const char* ids = eecs_snapshot_skip(&reader, sizeof(eecs_id_t) * (size_t)num_members);
+			const char* saved_data = eecs_snapshot_skip(&reader, component_size * (size_t)num_members);
+
+			eecs_component_t component = component_map[saved_set.component_index];
+			if (component.from_1_index == 0) { continue; }
+
+			eecs_sparse_set_t* set = &world->sparse_sets[eecs_index_of(component)];
+			for (eecs_id_t j = 0; j < num_members; ++j) {
+				eecs_id_t from_1_index;
+				memcpy(&from_1_index, ids + sizeof(eecs_id_t) * (size_t)j, sizeof(from_1_index));
+				memcpy(
+					eecs_push_sparse_member(world, set, from_1_index),
+					saved_data + component_size * (size_t)j,
+					component_size
+				);
+			}
+		}
+	}
+
+	for (eecs_id_t i = 0; valid && options.run_init_callbacks && i < num_tables; ++i) {
+		eecs_table_t* table = tables[i];
+		for (eecs_id_t pos = first_positions[i]; pos < first_positions[i] + table_sizes[i]; ++pos) {
+			char* chunk = table->chunks[pos / table->num_entities_per_chunk];
+			eecs_id_t pos_in_chunk = pos % table->num_entities_per_chunk;
+			eecs_id_t from_1_index = ((eecs_id_t*)chunk)[pos_in_chunk];
+			eecs_entity_t handle = {
+				.from_1_index = from_1_index,
+				.gen = eecs_entity_slot(world, from_1_index)->gen,
+			};
+
+			eecs_array_indexed_foreach(eecs_component_entity_callback_t, itr, table->component_init_callbacks) {
+				char* component_data = chunk
+					+ table->component_storage_offsets[itr.value->signature_index]
+					+ pos_in_chunk * table->component_sizes[itr.value->signature_index];
+
+				itr.value->fn(world, handle, component_data, itr.value->userdata);
+			}
+			eecs_array_indexed_foreach(eecs_system_entity_callback_t, itr, table->system_init_callbacks) {
+				itr.value->fn(world, handle, itr.value->userdata);
+			}
+		}
+	}
+
+	// Every set is loaded before any callback runs, the members are looked
+	// up again in case a callback changed them
+	reader.pos = sparse_sets_position;
+	for (uint64_t i = 0; valid && options.run_init_callbacks && i < header.num_sparse_sets; ++i) {
+		eecs_snapshot_sparse_set_t saved_set;
+		eecs_snapshot_read(&reader, &saved_set, sizeof(saved_set));
+		eecs_id_t num_members = (eecs_id_t)saved_set.num_entities;
+		const char* ids = eecs_snapshot_skip(&reader, sizeof(eecs_id_t) * (size_t)num_members);
+		eecs_snapshot_skip(&reader, component_sizes[saved_set.component_index] * (size_t)num_members);
+
+		eecs_component_t component = component_map[saved_set.component_index];
+		if (component.from_1_index == 0) { continue; }
+
+		const eecs_component_options_t* component_options = &ecs->components[eecs_index_of(component)];
+		for (eecs_id_t j = 0; component_options->init_fn != NULL && j < num_members; ++j) {
+			eecs_id_t from_1_index;
+			memcpy(&from_1_index, ids + sizeof(eecs_id_t) * (size_t)j, sizeof(from_1_index));
+			char* component_data = eecs_get_sparse_component(world, eecs_index_of(component), from_1_index);
+			if (component_data == NULL) { continue; }
+
+			eecs_entity_t handle = {
+				.from_1_index = from_1_index,
+				.gen = eecs_entity_slot(world, from_1_index)->gen,
+			};
+			component_options->init_fn(world, handle, component_data, component_options->userdata);
+		}
+	}
+
+	eecs_free(memctx, first_positions);
+	eecs_free(memctx, tables);
+	eecs_free(memctx, signature);
+	eecs_free(memctx, table_entities_per_chunk);
+	eecs_free(memctx, table_chunks);
+	eecs_free(memctx, table_sizes);
+	eecs_free(memctx, table_positions);
+	eecs_free(memctx, table_components);
+	eecs_free(memctx, sparse_components);
+	eecs_free(memctx, enableable_components);
+	eecs_free(memctx, mapped_components);
+	eecs_free(memctx, component_map);
+	eecs_free(memctx, component_sizes);
+	return valid;
+}
+
+EECS_PRIVATE bool
+eecs_write_to_file(const void* data, size_t size, void* userdata) {
+	return fwrite(data, 1, size, userdata) == size;
+}
+
+bool
+eecs_save_world_to_file(eecs_world_t* world, const char* path) {
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) { return false; }
+
+	bool succeeded = eecs_save_world(world, eecs_write_to_file, file);
+	succeeded &= fclose(file) == 0;
+	return succeeded;
+}
+
+bool
+eecs_load_world_from_file(
+	eecs_world_t* world,
+	const char* path,
+	eecs_load_options_t options
+) {
+#ifdef EECS_MMAP
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) { return false; }
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+
+	size_t size = (size_t)file_stat.st_size;
+	void* snapshot = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (snapshot == MAP_FAILED) { return false; }
+
+	// Chunks are copied front to back
+	madvise(snapshot, size, MADV_SEQUENTIAL);
+	bool succeeded = eecs_load_world(world, snapshot, size, options);
+	munmap(snapshot, size);
+	return succeeded;
+#else
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) { return false; }
+
+	long size = -1;
+	if (fseek(file, 0, SEEK_END) == 0) { size = ftell(file); }
+	if (size <= 0 || fseek(file, 0, SEEK_SET) != 0) {
+		fclose(file);
+		return false;
+	}
+
+	void* memctx = world->options.memctx;
+	void* snapshot = eecs_malloc(memctx, (size_t)size);
+	bool succeeded = fread(snapshot, 1, (size_t)size, file) == (size_t)size
+		&& eecs_load_world(world, snapshot, (size_t)size, options);
+	eecs_free(memctx, snapshot);
+	fclose(file);
+	return succeeded;
+#endif
+}
+
+// Byte offset of the first difference or size when equal. Equal blocks are
+// skipped with memcmp, which is vectorized by the C library, then the
+// differing block is narrowed down.
+EECS_PRIVATE size_t
+eecs_find_first_difference(const char* lhs, const char* rhs, size_t size) {
+	for (size_t i = 0; i < size; i += 4096) {
+		if (memcmp(lhs + i, rhs + i, eecs_min(size - i, 4096)) == 0) { continue; }
+
+		for (size_t j = i; ; j += 64) {
+			if (memcmp(lhs + j, rhs + j, eecs_min(size - j, 64)) == 0) { continue; }
+
+			while (lhs[j] == rhs[j]) { ++j; }
+			return j;
+		}
+	}
+	return size;
+}
+
+// First row from first_row which must be sent or num_rows. Rows past
+// num_sent_rows are always sent, the replica's chunk holds whatever was
+// there before.
+EECS_PRIVATE eecs_id_t
+eecs_find_changed_row(
+	const char* data,
+	const char* sent_data,
+	size_t row_size,
+	eecs_id_t first_row,
+	eecs_id_t num_sent_rows,
+	eecs_id_t num_rows
+) {
+	if (first_row >= num_rows) { return num_rows; }
+	if (first_row >= num_sent_rows) { return first_row; }
+
+	size_t begin = row_size * (size_t)first_row;
+	size_t end = row_size * (size_t)num_sent_rows;
+	size_t difference = eecs_find_first_difference(data + begin, sent_data + begin, end - begin);
+	return (eecs_id_t)((begin + difference) / row_size);
+}
+
+eecs_delta_baseline_t*
+eecs_create_delta_baseline(eecs_world_t* world) {
+	eecs_delta_baseline_t* baseline = eecs_malloc(world->options.memctx, sizeof(eecs_delta_baseline_t));
+	*baseline = (eecs_delta_baseline_t){
+		.world = world,
+	};
+	return baseline;
+}
+
+void
+eecs_destroy_delta_baseline(eecs_delta_baseline_t* baseline) {
+	void* memctx = baseline->world->options.memctx;
+	eecs_array_indexed_foreach(eecs_delta_table_t, itr, baseline->tables) {
+		eecs_array_indexed_foreach(char*, chunk_itr, itr.value->chunks) {
+			eecs_free(memctx, *chunk_itr.value);
+		}
+		eecs_array_free(memctx, itr.value->chunks);
+	}
+	eecs_array_free(memctx, baseline->tables);
+	eecs_array_indexed_foreach(eecs_delta_sparse_set_t, itr, baseline->sparse_sets) {
+		eecs_free(memctx, itr.value->entities);
+		eecs_free(memctx, itr.value->data);
+	}
+	eecs_array_free(memctx, baseline->sparse_sets);
+	eecs_array_free(memctx, baseline->entities);
+	eecs_free(memctx, baseline);
+}
+
+// Where the rows of a patch column are in chunks and how many entities each
+// row covers. Returns the column in the signature or -1 for the entity ids.
+EECS_PRIVATE eecs_id_t
+eecs_get_delta_column_layout(
+	const eecs_table_t* table,
+	eecs_id_t patch_column,
+	ptrdiff_t* offset_out,
+	size_t* row_size_out,
+	eecs_id_t* entities_per_row_out
+) {
+	*entities_per_row_out = 1;
+	if (patch_column == 0) {
+		*offset_out = 0;
+		*row_size_out = sizeof(eecs_id_t);
+		return -1;
+	} else if (patch_column <= table->signature.length) {
+		*offset_out = table->component_storage_offsets[patch_column - 1];
+		*row_size_out = table->component_sizes[patch_column - 1];
+		return patch_column - 1;
+	} else {
+		eecs_id_t column = table->enableable_columns[patch_column - table->signature.length - 1];
+		*offset_out = table->enable_mask_offsets[column];
+		*row_size_out = sizeof(eecs_mask_t);
+		*entities_per_row_out = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
+		return column;
+	}
+}
+
+EECS_PRIVATE bool
+eecs_encode_table_delta(
+	eecs_delta_baseline_t* baseline,
+	const eecs_table_t* table,
+	eecs_write_fn_t write_fn,
+	void* userdata
+) {
+	eecs_world_t* world = baseline->world;
+	void* memctx = world->options.memctx;
+	size_t chunk_size = world->options.table_chunk_size;
+	eecs_delta_table_t* baseline_table = &baseline->tables[table->index];
+	eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+	eecs_id_t num_chunks = eecs_array_length(table->chunks);
+	eecs_id_t num_columns = table->signature.length + 1 + table->num_enableable_columns;
+
+	eecs_delta_table_patch_t table_patch = {
+		.table_index = (uint64_t)table->index,
+		.num_entities = (uint64_t)table->num_entities,
+		.num_entities_per_chunk = (uint64_t)num_entities_per_chunk,
+	};
+	bool table_patch_written = false;
+	if (table->num_entities != baseline_table->num_entities) {
+		if (!write_fn(&table_patch, sizeof(table_patch), userdata)) { return false; }
+		table_patch_written = true;
+	}
+
+	for (eecs_id_t chunk_index = 0; chunk_index < num_chunks; ++chunk_index) {
+		const char* chunk = table->chunks[chunk_index];
+		char* baseline_chunk = chunk_index < eecs_array_length(baseline_table->chunks)
+			? baseline_table->chunks[chunk_index]
+			: NULL;
+		eecs_id_t first_pos = chunk_index * num_entities_per_chunk;
+		eecs_id_t num_entities = eecs_min(table->num_entities - first_pos, num_entities_per_chunk);
+		// Entities of the chunk which the replica already has
+		eecs_id_t num_sent_entities = baseline_chunk != NULL
+			? eecs_max(eecs_min(baseline_table->num_entities - first_pos, num_entities), 0)
+			: 0;
+
+		if (baseline_chunk == NULL) {
+			baseline_chunk = eecs_malloc(memctx, chunk_size);
+			eecs_array_push(memctx, baseline_table->chunks, baseline_chunk);
+		}
+
+		for (eecs_id_t column = 0; column < num_columns; ++column) {
+			ptrdiff_t offset;
+			size_t row_size;
+			eecs_id_t entities_per_row;
+			eecs_get_delta_column_layout(table, column, &offset, &row_size, &entities_per_row);
+			// Tags have nothing to send
+			if (row_size == 0) { continue; }
+
+			eecs_id_t num_rows = (num_entities + entities_per_row - 1) / entities_per_row;
+			eecs_id_t num_sent_rows = (num_sent_entities + entities_per_row - 1) / entities_per_row;
+			const char* data = chunk + offset;
+			char* sent_data = baseline_chunk + offset;
+
+			eecs_id_t first_row = eecs_find_changed_row(
+				data, sent_data, row_size, 0, num_sent_rows, num_rows
+			);
+			while (first_row < num_rows) {
+				// Runs separated by less than a patch header are sent as one
+				eecs_id_t end_row = first_row + 1;
+				eecs_id_t next_row;
+				for (;;) {
+					next_row = eecs_find_changed_row(
+						data, sent_data, row_size, end_row, num_sent_rows, num_rows
+					);
+					if (
+						next_row >= num_rows
+						|| row_size * (size_t)(next_row - end_row) > sizeof(eecs_delta_column_patch_t)
+					) {
+						break;
+					}
+					end_row = next_row + 1;
+				}
+
+				if (!table_patch_written) {
+					if (!write_fn(&table_patch, sizeof(table_patch), userdata)) { return false; }
+					table_patch_written = true;
+				}
+
+				size_t first_byte = row_size * (size_t)first_row;
+				size_t num_bytes = row_size * (size_t)(end_row - first_row);
+				eecs_delta_column_patch_t column_patch = {
+					.chunk_index = (uint64_t)chunk_index,
+					.column = (uint64_t)column,
+					.first_row = (uint64_t)first_row,
+					.num_rows = (uint64_t)(end_row - first_row),
+				};
+				if (
+					!write_fn(&column_patch, sizeof(column_patch), userdata)
+					|| !write_fn(data + first_byte, num_bytes, userdata)
+				) {
+					return false;
+				}
+				memcpy(sent_data + first_byte, data + first_byte, num_bytes);
+
+				first_row = next_row;
+			}
+		}
+	}
+
+	// The replica releases its trailing chunks as well
+	while (eecs_array_length(baseline_table->chunks) > num_chunks) {
+		eecs_free(memctx, eecs_array_pop(baseline_table->chunks));
+	}
+	baseline_table->num_entities = table->num_entities;
+
+	if (table_patch_written) {
+		eecs_delta_column_patch_t end = { .chunk_index = EECS_DELTA_END_OF_LIST };
+		return write_fn(&end, sizeof(end), userdata);
+	} else {
+		return true;
+	}
 }
 
-void
-eecs_destroy_entity(eecs_world_t* world, eecs_entity_t handle) {
-	eecs_sync_world(world);
+// Sets are small next to the tables so a set which changed is sent whole
+EECS_PRIVATE bool
+eecs_encode_sparse_set_delta(
+	eecs_delta_baseline_t* baseline,
+	eecs_id_t component_index,
+	eecs_write_fn_t write_fn,
+	void* userdata
+) {
+	eecs_world_t* world = baseline->world;
+	void* memctx = world->options.memctx;
+	const eecs_sparse_set_t* set = &world->sparse_sets[component_index];
+	eecs_delta_sparse_set_t* sent_set = &baseline->sparse_sets[component_index];
+	eecs_id_t num_members = eecs_array_length(set->entities);
+	size_t ids_size = sizeof(eecs_id_t) * (size_t)num_members;
+	size_t data_size = set->component_size * (size_t)num_members;
+	if (
+		num_members == sent_set->num_entities
+		&& (num_members == 0 || memcmp(set->entities, sent_set->entities, ids_size) == 0)
+		&& (data_size == 0 || memcmp(set->data, sent_set->data, data_size) == 0)
+	) {
+		return true;
+	}
 
-	eecs_entity_data_t* entity_data = eecs_get_entity_data(world, handle);
-	if (entity_data == NULL) { return; }
+	eecs_snapshot_sparse_set_t set_header = {
+		.component_index = (uint64_t)component_index,
+		.num_entities = (uint64_t)num_members,
+	};
+	if (
+		!write_fn(&set_header, sizeof(set_header), userdata)
+		|| !write_fn(set->entities, ids_size, userdata)
+		|| !write_fn(set->data, data_size, userdata)
+	) {
+		return false;
+	}
 
-	if (entity_data->table == world->current_update_table) {
-		eecs_alloc_deferred_op(world, EECS_DESTROY_ENTITY, handle);
-	} else {
-		eecs_destroy_entity_now(world, entity_data);
+	sent_set->num_entities = num_members;
+	sent_set->entities = eecs_realloc(memctx, sent_set->entities, eecs_max(ids_size, (size_t)1));
+	sent_set->data = eecs_realloc(memctx, sent_set->data, eecs_max(data_size, (size_t)1));
+	if (num_members > 0) {
+		memcpy(sent_set->entities, set->entities, ids_size);
+		memcpy(sent_set->data, set->data, data_size);
 	}
+	return true;
 }
 
-void
-eecs_register_template(
-	eecs_world_t* world,
-	eecs_template_t* handle,
-	const eecs_component_init_t* init
+bool
+eecs_encode_delta(
+	eecs_delta_baseline_t* baseline,
+	eecs_write_fn_t write_fn,
+	void* userdata
 ) {
+	eecs_world_t* world = baseline->world;
 	eecs_sync_world(world);
+	EECS_ASSERT(
+		world->current_update_table == NULL && !world->parallel_update && world->bulk_depth == 0,
+		"Cannot encode a world while it is being updated"
+	);
+	if (world->rebase_entities) { eecs_own_entities(world); }
 
-	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
 	void* memctx = world->options.memctx;
-
-	eecs_template_data_t* entity_template;
-	if (handle->from_1_index == 0) {
-		eecs_array_push(memctx, world->templates, (eecs_template_data_t){ 0 });
-		entity_template = &eecs_array_back(world->templates);
-	} else {
-		entity_template = &world->templates[eecs_index_of(*handle)];
-
-		eecs_id_t old_signature_length = entity_template->table->signature.length;
-		for (eecs_id_t i = 0; i < old_signature_length; ++i) {
-			eecs_free(memctx, (void*)entity_template->init_data[i].data);
+	eecs_id_t num_tables = eecs_array_length(world->tables);
+	eecs_id_t first_new_table = eecs_array_length(baseline->tables);
+	eecs_id_t num_slots = world->num_entity_slots;
+
+	eecs_delta_header_t header = {
+		.version = EECS_DELTA_VERSION,
+		.byte_order = EECS_SNAPSHOT_BYTE_ORDER,
+		.id_size = sizeof(eecs_id_t),
+		.chunk_size = world->options.table_chunk_size,
+		.num_components = (uint64_t)eecs_array_length(world->ecs->components),
+		.first_new_table = (uint64_t)first_new_table,
+		.num_tables = (uint64_t)num_tables,
+		.num_entity_slots = (uint64_t)num_slots,
+		.new_entity_gen = (uint64_t)world->new_entity_gen,
+	};
+	memcpy(header.magic, EECS_DELTA_MAGIC, sizeof(header.magic));
+	if (!write_fn(&header, sizeof(header), userdata)) { return false; }
+
+	for (eecs_id_t i = first_new_table; i < num_tables; ++i) {
+		const eecs_table_t* table = world->tables[i];
+		uint64_t num_columns = (uint64_t)table->signature.length;
+		if (!write_fn(&num_columns, sizeof(num_columns), userdata)) { return false; }
+		for (eecs_id_t j = 0; j < table->signature.length; ++j) {
+			uint64_t component_index = (uint64_t)eecs_index_of(table->signature.components[j]);
+			if (!write_fn(&component_index, sizeof(component_index), userdata)) { return false; }
 		}
+
+		eecs_delta_table_t baseline_table = { 0 };
+		eecs_array_push(memctx, baseline->tables, baseline_table);
 	}
 
-	eecs_component_init_t* init_copy;
-	eecs_table_t* table;
-	eecs_parse_component_init(world, init, &init_copy, &table);
+	eecs_array_indexed_foreach(eecs_table_t*, itr, world->tables) {
+		if (!eecs_encode_table_delta(baseline, *itr.value, write_fn, userdata)) { return false; }
+	}
+	eecs_delta_table_patch_t end_of_tables = { .table_index = EECS_DELTA_END_OF_LIST };
+	if (!write_fn(&end_of_tables, sizeof(end_of_tables), userdata)) { return false; }
+
+	eecs_id_t num_sent_slots = eecs_array_length(baseline->entities);
+	eecs_array_resize(memctx, baseline->entities, num_slots);
+
+	// Blocks never straddle a page. Free slots are kept without their free
+	// list link, which the replica rebuilds.
+	bool succeeded = true;
+	eecs_delta_entity_t changes[256];
+	eecs_id_t num_changes = 0;
+	for (eecs_id_t begin = 0; succeeded && begin < num_slots; begin += 16) {
+		eecs_id_t end = eecs_min(begin + 16, num_slots);
+		if (
+			end <= num_sent_slots
+			&& memcmp(
+				eecs_entity_slot(world, begin + 1),
+				&baseline->entities[begin],
+				sizeof(eecs_entity_data_t) * (size_t)(end - begin)
+			) == 0
+		) {
+			continue;
+		}
 
-	entity_template->table = table;
-	entity_template->init_data = eecs_realloc(
-		memctx,
-		entity_template->init_data,
-		sizeof(eecs_component_init_t) * table->signature.length
-	);
+		for (eecs_id_t i = begin; succeeded && i < end; ++i) {
+			eecs_entity_data_t entity_data = *eecs_entity_slot(world, i + 1);
+			if (entity_data.table == NULL) { entity_data.pos_in_table = 0; }
+			if (
+				i < num_sent_slots
+				&& memcmp(&entity_data, &baseline->entities[i], sizeof(eecs_entity_data_t)) == 0
+			) {
+				continue;
+			}
 
-	const eecs_t* ecs = world->ecs;
-	for (eecs_id_t i = 0; i < table->signature.length; ++i) {
-		const eecs_component_options_t* component_options = &ecs->components[eecs_index_of(init_copy[i].component)];
-		eecs_component_init_t* init_data = &entity_template->init_data[i];
+			baseline->entities[i] = entity_data;
+			changes[num_changes++] = (eecs_delta_entity_t){
+				.slot_index = i,
+				.entity = eecs_make_snapshot_entity(&entity_data),
+			};
+			if (num_changes == 256) {
+				succeeded = write_fn(changes, sizeof(changes), userdata);
+				num_changes = 0;
+			}
+		}
+	}
+	changes[num_changes++] = (eecs_delta_entity_t){ .slot_index = -1 };
+	succeeded = succeeded && write_fn(changes, sizeof(changes[0]) * (size_t)num_changes, userdata);
 
-		init_data->component = init_copy[i].component;
+	eecs_id_t num_sent_components = eecs_array_length(baseline->sparse_sets);
+	eecs_id_t num_components = eecs_array_length(world->sparse_sets);
+	if (num_components > num_sent_components) {
+		eecs_array_resize(memctx, baseline->sparse_sets, num_components);
+		memset(
+			&baseline->sparse_sets[num_sent_components], 0,
+			sizeof(eecs_delta_sparse_set_t) * (size_t)(num_components - num_sent_components)
+		);
+	}
+	eecs_array_indexed_foreach(eecs_id_t, itr, world->sparse_components) {
+		succeeded = succeeded && eecs_encode_sparse_set_delta(baseline, *itr.value, write_fn, userdata);
+	}
+	eecs_snapshot_sparse_set_t end_of_sparse_sets = { .component_index = EECS_DELTA_END_OF_LIST };
+	succeeded = succeeded && write_fn(&end_of_sparse_sets, sizeof(end_of_sparse_sets), userdata);
 
-		if (init_copy[i].data != NULL) {
-			void* data_copy = eecs_malloc(memctx, component_options->size);
-			memcpy(data_copy, init_copy->data, component_options->size);
+	baseline->new_entity_gen = world->new_entity_gen;
+	return succeeded;
+}
 
-			init_data->data = data_copy;
+// Directory entry of a slot once the delta is applied
+EECS_PRIVATE eecs_snapshot_entity_t
+eecs_delta_final_entity(const eecs_delta_check_t* check, eecs_id_t slot_index) {
+	eecs_snapshot_entity_t free_entity = { .table_index = -1 };
+	if (slot_index >= check->num_slots) { return free_entity; }
+
+	eecs_id_t begin = 0;
+	eecs_id_t end = check->num_changes;
+	while (begin < end) {
+		eecs_id_t mid = begin + (end - begin) / 2;
+		eecs_delta_entity_t change;
+		memcpy(&change, check->changes + sizeof(change) * (size_t)mid, sizeof(change));
+		if (change.slot_index == slot_index) {
+			return change.entity;
+		} else if (change.slot_index < slot_index) {
+			begin = mid + 1;
 		} else {
-			init_data->data = NULL;
+			end = mid;
 		}
 	}
 
-	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
+	// Slots past the replica's are new and free
+	return slot_index < check->world->num_entity_slots
+		? eecs_make_snapshot_entity(eecs_entity_slot(check->world, slot_index + 1))
+		: free_entity;
 }
 
-eecs_entity_t
-eecs_create_entity_from_template(
-	eecs_world_t* world,
-	eecs_template_t entity_template,
-	const eecs_component_init_t* overrides
+// Entity id in a row once the delta is applied. Returns false for a row which
+// is neither patched nor already filled.
+EECS_PRIVATE bool
+eecs_delta_final_row_id(
+	const eecs_delta_check_t* check,
+	eecs_id_t table_index,
+	eecs_id_t pos,
+	eecs_id_t* id_out
 ) {
-	eecs_sync_world(world);
+	const eecs_delta_id_patch_t* patches = check->id_patches + check->first_id_patches[table_index];
+	eecs_id_t begin = 0;
+	eecs_id_t end = check->num_id_patches[table_index];
+	while (begin < end) {
+		eecs_id_t mid = begin + (end - begin) / 2;
+		if (pos < patches[mid].first_pos) {
+			end = mid;
+		} else if (pos >= patches[mid].first_pos + patches[mid].num_rows) {
+			begin = mid + 1;
+		} else {
+			memcpy(
+				id_out,
+				patches[mid].ids + sizeof(eecs_id_t) * (size_t)(pos - patches[mid].first_pos),
+				sizeof(*id_out)
+			);
+			return true;
+		}
+	}
 
-	eecs_arena_checkpoint_t tmp_checkpoint = eecs_arena_checkpoint(world, &world->tmp_arena);
+	const eecs_table_t* table = check->world->tables[table_index];
+	if (pos >= table->num_entities) { return false; }
 
-	EECS_ASSERT(entity_template.from_1_index > 0, "Invalid template");
-	const eecs_template_data_t* template_data = &world->templates[eecs_index_of(entity_template)];
-	eecs_table_t* table = template_data->table;
+	*id_out = *eecs_row_id(table, pos);
+	return true;
+}
 
-	eecs_component_init_t* init_data;
+EECS_PRIVATE bool
+eecs_delta_points_at(eecs_snapshot_entity_t entity, eecs_id_t table_index, eecs_id_t pos) {
+	return entity.table_index == table_index && entity.pos_in_table == pos;
+}
 
-	if (overrides != NULL) {
-		init_data = eecs_arena_alloc(
-			world, &world->tmp_arena,
-			sizeof(eecs_component_init_t) * table->signature.length,
-			_Alignof(eecs_component_init_t)
-		);
-		memcpy(
-			init_data,
-			template_data->init_data,
-			sizeof(eecs_component_init_t) * table->signature.length
+// Whether every live slot points at a row holding its id and every row at a
+// slot pointing back once the delta is applied. Only what the delta touches
+// is looked at since the replica starts out consistent.
+EECS_PRIVATE bool
+eecs_check_delta_rows(const eecs_delta_check_t* check) {
+	const eecs_world_t* world = check->world;
+	eecs_id_t id;
+
+	for (eecs_id_t i = 0; i < check->num_changes; ++i) {
+		eecs_delta_entity_t change;
+		memcpy(&change, check->changes + sizeof(change) * (size_t)i, sizeof(change));
+		eecs_snapshot_entity_t entity = change.entity;
+		if (
+			entity.table_index >= 0
+			&& !(
+				eecs_delta_final_row_id(check, entity.table_index, entity.pos_in_table, &id)
+				&& id == change.slot_index + 1
+			)
+		) {
+			return false;
+		}
+
+		// A moved entity must not be left in its previous row
+		if (change.slot_index >= world->num_entity_slots) { continue; }
+		eecs_snapshot_entity_t previous = eecs_make_snapshot_entity(
+			eecs_entity_slot(world, change.slot_index + 1)
 		);
+		if (
+			previous.table_index >= 0
+			&& previous.pos_in_table < check->table_sizes[previous.table_index]
+			&& eecs_delta_final_row_id(check, previous.table_index, previous.pos_in_table, &id)
+			&& id == change.slot_index + 1
+			&& !eecs_delta_points_at(entity, previous.table_index, previous.pos_in_table)
+		) {
+			return false;
+		}
+	}
 
-		for (eecs_id_t i = 0; overrides[i].component.from_1_index != 0; ++i) {
-			for (eecs_id_t j = 0; j < table->signature.length; ++j) {
-				if (table->signature.components[j].from_1_index == overrides[i].component.from_1_index) {
-					init_data[j].data = overrides[i].data;
-					break;
+	// Rows of dropped slots must be removed or overwritten
+	for (eecs_id_t i = check->num_slots; i < world->num_entity_slots; ++i) {
+		eecs_snapshot_entity_t previous = eecs_make_snapshot_entity(eecs_entity_slot(world, i + 1));
+		if (
+			previous.table_index >= 0
+			&& previous.pos_in_table < check->table_sizes[previous.table_index]
+			&& eecs_delta_final_row_id(check, previous.table_index, previous.pos_in_table, &id)
+			&& id == i + 1
+		) {
+			return false;
+		}
+	}
+
+	for (eecs_id_t table_index = 0; table_index < eecs_array_length(world->tables); ++table_index) {
+		const eecs_table_t* table = world->tables[table_index];
+		eecs_id_t num_entities = check->table_sizes[table_index];
+		const eecs_delta_id_patch_t* patches = check->id_patches + check->first_id_patches[table_index];
+		eecs_id_t num_patches = check->num_id_patches[table_index];
+
+		// Added rows must all be patched
+		eecs_id_t num_filled = table->num_entities;
+		for (eecs_id_t i = 0; i < num_patches && num_filled < num_entities; ++i) {
+			if (patches[i].first_pos > num_filled) { break; }
+			num_filled = eecs_max(num_filled, patches[i].first_pos + patches[i].num_rows);
+		}
+		if (num_filled < num_entities) { return false; }
+
+		for (eecs_id_t i = 0; i < num_patches; ++i) {
+			eecs_id_t end_pos = eecs_min(patches[i].first_pos + patches[i].num_rows, num_entities);
+			for (eecs_id_t pos = patches[i].first_pos; pos < end_pos; ++pos) {
+				memcpy(&id, patches[i].ids + sizeof(id) * (size_t)(pos - patches[i].first_pos), sizeof(id));
+				if (!eecs_delta_points_at(eecs_delta_final_entity(check, id - 1), table_index, pos)) {
+					return false;
+				}
+
+				// The entity overwritten must have moved
+				if (pos >= table->num_entities) { continue; }
+				eecs_id_t previous_id = *eecs_row_id(table, pos);
+				if (
+					previous_id != id
+					&& eecs_delta_points_at(eecs_delta_final_entity(check, previous_id - 1), table_index, pos)
+				) {
+					return false;
 				}
 			}
 		}
-	} else {
-		init_data = template_data->init_data;
-	}
 
-	eecs_entity_t entity = eecs_create_entity_for_table(world, table, init_data);
+		// So must the entities of removed rows
+		for (eecs_id_t pos = num_entities; pos < table->num_entities; ++pos) {
+			eecs_id_t previous_id = *eecs_row_id(table, pos);
+			if (eecs_delta_points_at(eecs_delta_final_entity(check, previous_id - 1), table_index, pos)) {
+				return false;
+			}
+		}
+	}
 
-	eecs_arena_rollback(world, &world->tmp_arena, tmp_checkpoint);
-	return entity;
+	return true;
 }
 
-void
-eecs_run_systems(eecs_world_t* world, eecs_mask_t update_mask) {
-	EECS_ASSERT(world->current_update_table == NULL, "eecs_run_systems is not reentrant");
-
+bool
+eecs_apply_delta(eecs_world_t* replica, const void* delta, size_t size) {
+	eecs_world_t* world = replica;
 	eecs_sync_world(world);
+	EECS_ASSERT(
+		world->current_update_table == NULL && !world->parallel_update && world->bulk_depth == 0,
+		"Cannot apply a delta to a world while it is being updated"
+	);
+	eecs_own_entities(world);
 
-	world->update_mask = update_mask;
-
-	const eecs_t* ecs = world->ecs;
-	eecs_array_indexed_foreach(
-		eecs_system_data_t,
-		sys_itr,
-		world->system_data
+	void* memctx = world->options.memctx;
+	eecs_id_t num_available_components = eecs_array_length(world->ecs->components);
+	eecs_snapshot_reader_t reader = { .data = delta, .size = size };
+	uint64_t max_id = ((uint64_t)1 << (sizeof(eecs_id_t) * CHAR_BIT - 1)) - 1;
+
+	// A delta sent again after being rejected describes tables which were
+	// already created
+	eecs_delta_header_t header;
+	if (
+		!eecs_snapshot_read(&reader, &header, sizeof(header))
+		|| memcmp(header.magic, EECS_DELTA_MAGIC, sizeof(header.magic)) != 0
+		|| header.version != EECS_DELTA_VERSION
+		|| header.byte_order != EECS_SNAPSHOT_BYTE_ORDER
+		|| header.id_size != sizeof(eecs_id_t)
+		|| header.chunk_size != world->options.table_chunk_size
+		|| header.num_components > (uint64_t)num_available_components
+		|| header.first_new_table > (uint64_t)eecs_array_length(world->tables)
+		|| header.num_tables < header.first_new_table
+		|| header.num_tables > max_id
+		|| header.num_entity_slots > max_id
 	) {
-		const eecs_system_options_t* system_options = &ecs->systems[sys_itr.index];
-		if ((update_mask & system_options->update_mask) == system_options->update_mask) {
-			eecs_do_run_system(world, system_options, sys_itr.value);
+		return false;
+	}
+
+	// Tables are created in the same order as in the encoded world. Empty
+	// tables are all a rejected delta may leave behind.
+	eecs_component_t* signature = eecs_malloc(
+		memctx, sizeof(eecs_component_t) * (size_t)eecs_max(num_available_components, 1)
+	);
+	bool valid = true;
+	for (uint64_t i = header.first_new_table; valid && i < header.num_tables; ++i) {
+		uint64_t num_columns;
+		valid = eecs_snapshot_read(&reader, &num_columns, sizeof(num_columns))
+			&& num_columns <= (uint64_t)num_available_components;
+		for (uint64_t j = 0; valid && j < num_columns; ++j) {
+			uint64_t component_index = 0;
+			valid = eecs_snapshot_read(&reader, &component_index, sizeof(component_index))
+				&& component_index < header.num_components
+				&& (j == 0 || (eecs_id_t)component_index > eecs_index_of(signature[j - 1]));
+			signature[j] = (eecs_component_t){ .from_1_index = (eecs_id_t)component_index + 1 };
 		}
+		valid = valid && eecs_get_table(world, (eecs_signature_t){
+			.length = (eecs_id_t)num_columns,
+			.components = signature,
+		})->index == (eecs_id_t)i;
+	}
+	eecs_free(memctx, signature);
+	valid = valid && header.num_tables == (uint64_t)eecs_array_length(world->tables);
+	if (!valid) { return false; }
+
+	// Nothing else is changed until the whole delta is checked
+	eecs_id_t num_tables = (eecs_id_t)header.num_tables;
+	eecs_id_t num_slots = (eecs_id_t)header.num_entity_slots;
+	size_t table_array_size = sizeof(eecs_id_t) * (size_t)eecs_max(num_tables, 1);
+	eecs_delta_check_t check = {
+		.world = world,
+		.num_slots = num_slots,
+		.table_sizes = eecs_malloc(memctx, table_array_size),
+		.first_id_patches = eecs_malloc(memctx, table_array_size),
+		.num_id_patches = eecs_malloc(memctx, table_array_size),
+	};
+	eecs_bitset_t* patched_tables = eecs_malloc(memctx, eecs_bitset_memory_size(num_tables));
+	eecs_bitset_init(patched_tables, num_tables);
+	for (eecs_id_t i = 0; i < num_tables; ++i) {
+		check.table_sizes[i] = world->tables[i]->num_entities;
+		check.first_id_patches[i] = 0;
+		check.num_id_patches[i] = 0;
 	}
 
-	world->update_mask = EECS_UPDATE_NONE;
-}
+	eecs_snapshot_reader_t patch_reader = reader;
+	while (valid) {
+		eecs_delta_table_patch_t table_patch;
+		valid = eecs_snapshot_read(&reader, &table_patch, sizeof(table_patch));
+		if (!valid || table_patch.table_index == EECS_DELTA_END_OF_LIST) { break; }
 
-void
-eecs_run_system(eecs_world_t* world, eecs_mask_t update_mask, eecs_system_t system) {
-	EECS_ASSERT(world->current_update_table == NULL, "eecs_run_system is not reentrant");
+		valid = table_patch.table_index < header.num_tables
+			&& !eecs_bitset_is_set(patched_tables, (eecs_id_t)table_patch.table_index)
+			&& table_patch.num_entities <= max_id;
+		if (!valid) { break; }
 
-	eecs_sync_world(world);
+		eecs_id_t table_index = (eecs_id_t)table_patch.table_index;
+		const eecs_table_t* table = world->tables[table_index];
+		eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+		eecs_id_t num_columns = table->signature.length + 1 + table->num_enableable_columns;
+		valid = table_patch.num_entities_per_chunk == (uint64_t)num_entities_per_chunk;
+		if (!valid) { break; }
+
+		eecs_bitset_set(patched_tables, table_index);
+		check.table_sizes[table_index] = (eecs_id_t)table_patch.num_entities;
+		check.first_id_patches[table_index] = eecs_array_length(check.id_patches);
+		eecs_id_t num_chunks = (check.table_sizes[table_index] + num_entities_per_chunk - 1) / num_entities_per_chunk;
+
+		eecs_id_t next_id_pos = 0;
+		while (valid) {
+			eecs_delta_column_patch_t column_patch;
+			valid = eecs_snapshot_read(&reader, &column_patch, sizeof(column_patch));
+			if (!valid || column_patch.chunk_index == EECS_DELTA_END_OF_LIST) { break; }
+
+			valid = column_patch.chunk_index < (uint64_t)num_chunks
+				&& column_patch.column < (uint64_t)num_columns;
+			if (!valid) { break; }
+
+			ptrdiff_t offset;
+			size_t row_size;
+			eecs_id_t entities_per_row;
+			eecs_get_delta_column_layout(
+				table, (eecs_id_t)column_patch.column, &offset, &row_size, &entities_per_row
+			);
+			uint64_t num_rows_per_chunk = (uint64_t)(
+				(num_entities_per_chunk + entities_per_row - 1) / entities_per_row
+			);
+			valid = column_patch.first_row <= num_rows_per_chunk
+				&& column_patch.num_rows <= num_rows_per_chunk - column_patch.first_row;
+			const char* rows = valid ? eecs_snapshot_skip(&reader, row_size * column_patch.num_rows) : NULL;
+			valid = rows != NULL;
+			if (!valid || column_patch.column != 0) { continue; }
+
+			// Ids are patched in increasing positions
+			eecs_delta_id_patch_t id_patch = {
+				.first_pos = (eecs_id_t)column_patch.chunk_index * num_entities_per_chunk
+					+ (eecs_id_t)column_patch.first_row,
+				.num_rows = (eecs_id_t)column_patch.num_rows,
+				.ids = rows,
+			};
+			valid = id_patch.first_pos >= next_id_pos;
+			for (eecs_id_t i = 0; valid && i < id_patch.num_rows; ++i) {
+				eecs_id_t from_1_index;
+				memcpy(&from_1_index, rows + sizeof(eecs_id_t) * (size_t)i, sizeof(from_1_index));
+				valid = 1 <= from_1_index && from_1_index <= num_slots;
+			}
+			eecs_array_push(memctx, check.id_patches, id_patch);
+			++check.num_id_patches[table_index];
+			next_id_pos = id_patch.first_pos + id_patch.num_rows;
+		}
+	}
 
-	world->update_mask = update_mask;
+	eecs_snapshot_reader_t directory_reader = reader;
+	check.changes = reader.data + reader.pos;
+	eecs_id_t num_new_slots_changed = 0;
+	while (valid) {
+		eecs_delta_entity_t change;
+		valid = eecs_snapshot_read(&reader, &change, sizeof(change));
+		if (!valid || change.slot_index < 0) { break; }
+
+		eecs_snapshot_entity_t entity = change.entity;
+		valid = change.slot_index < num_slots
+			&& entity.table_index < num_tables
+			&& (
+				entity.table_index < 0
+					? entity.pos_in_table == 0
+					: 0 <= entity.pos_in_table && entity.pos_in_table < check.table_sizes[entity.table_index]
+			);
+		if (check.num_changes > 0) {
+			eecs_delta_entity_t previous;
+			memcpy(&previous, check.changes + sizeof(previous) * (size_t)(check.num_changes - 1), sizeof(previous));
+			valid = valid && previous.slot_index < change.slot_index;
+		}
+		++check.num_changes;
+		num_new_slots_changed += change.slot_index >= world->num_entity_slots;
+	}
+	// Every new slot is sent, which keeps the directory in proportion with
+	// the delta
+	valid = valid && num_new_slots_changed == eecs_max(num_slots - world->num_entity_slots, 0);
+
+	eecs_snapshot_reader_t sparse_set_reader = reader;
+	eecs_bitset_t* members = valid ? eecs_malloc(memctx, eecs_bitset_memory_size(num_slots)) : NULL;
+	if (valid) { eecs_bitset_init(members, num_slots); }
+	while (valid) {
+		eecs_snapshot_sparse_set_t set_header;
+		valid = eecs_snapshot_read(&reader, &set_header, sizeof(set_header));
+		if (!valid || set_header.component_index == EECS_DELTA_END_OF_LIST) { break; }
+
+		valid = set_header.component_index < header.num_components
+			&& world->ecs->components[set_header.component_index].storage == EECS_STORAGE_SPARSE
+			&& set_header.num_entities <= (uint64_t)num_slots;
+		if (!valid) { break; }
+
+		eecs_id_t num_members = (eecs_id_t)set_header.num_entities;
+		const eecs_sparse_set_t* set = &world->sparse_sets[set_header.component_index];
+		const char* ids = eecs_snapshot_skip(&reader, sizeof(eecs_id_t) * (size_t)num_members);
+		valid = ids != NULL
+			&& eecs_snapshot_skip(&reader, set->component_size * (size_t)num_members) != NULL;
+
+		// Members are live and listed once
+		eecs_id_t num_checked = 0;
+		for (; valid && num_checked < num_members; ++num_checked) {
+			eecs_id_t from_1_index;
+			memcpy(&from_1_index, ids + sizeof(eecs_id_t) * (size_t)num_checked, sizeof(from_1_index));
+			valid = 1 <= from_1_index && from_1_index <= num_slots
+				&& !eecs_bitset_is_set(members, from_1_index - 1)
+				&& eecs_delta_final_entity(&check, from_1_index - 1).table_index >= 0;
+			if (valid) { eecs_bitset_set(members, from_1_index - 1); }
+		}
+		for (eecs_id_t i = 0; i < num_checked; ++i) {
+			eecs_id_t from_1_index;
+			memcpy(&from_1_index, ids + sizeof(eecs_id_t) * (size_t)i, sizeof(from_1_index));
+			if (1 <= from_1_index && from_1_index <= num_slots) {
+				eecs_bitset_clear(members, from_1_index - 1);
+			}
+		}
+	}
+	eecs_free(memctx, members);
+
+	valid = valid && eecs_check_delta_rows(&check);
+	eecs_free(memctx, patched_tables);
+	eecs_array_free(memctx, check.id_patches);
+	eecs_free(memctx, check.num_id_patches);
+	eecs_free(memctx, check.first_id_patches);
+	eecs_free(memctx, check.table_sizes);
+	if (!valid) { return false; }
+
+	reader = patch_reader;
+	for (;;) {
+		eecs_delta_table_patch_t table_patch;
+		eecs_snapshot_read(&reader, &table_patch, sizeof(table_patch));
+		if (table_patch.table_index == EECS_DELTA_END_OF_LIST) { break; }
+
+		eecs_table_t* table = world->tables[table_patch.table_index];
+		eecs_id_t num_entities_per_chunk = table->num_entities_per_chunk;
+		table->num_entities = (eecs_id_t)table_patch.num_entities;
+		eecs_id_t num_chunks = (table->num_entities + num_entities_per_chunk - 1) / num_entities_per_chunk;
+		while (eecs_array_length(table->chunks) < num_chunks) {
+			eecs_push_table_chunk(world, table);
+		}
+		while (eecs_array_length(table->chunks) > num_chunks) {
+			eecs_pop_table_chunk(world, table);
+		}
 
-	const eecs_system_options_t* system_options = &world->ecs->systems[eecs_index_of(system)];
-	eecs_system_data_t* system_data = &world->system_data[eecs_index_of(system)];
-	eecs_do_run_system(world, system_options, system_data);
+		for (;;) {
+			eecs_delta_column_patch_t column_patch;
+			eecs_snapshot_read(&reader, &column_patch, sizeof(column_patch));
+			if (column_patch.chunk_index == EECS_DELTA_END_OF_LIST) { break; }
+
+			eecs_id_t chunk_index = (eecs_id_t)column_patch.chunk_index;
+			ptrdiff_t offset;
+			size_t row_size;
+			eecs_id_t entities_per_row;
+			eecs_id_t column = eecs_get_delta_column_layout(
+				table, (eecs_id_t)column_patch.column, &offset, &row_size, &entities_per_row
+			);
+			memcpy(
+				eecs_own_chunk(world, table, chunk_index) + offset + row_size * column_patch.first_row,
+				eecs_snapshot_skip(&reader, row_size * column_patch.num_rows),
+				row_size * column_patch.num_rows
+			);
+			if (column < 0) {
+				eecs_mark_rows_changed(
+					world, table,
+					chunk_index * num_entities_per_chunk + (eecs_id_t)column_patch.first_row,
+					(eecs_id_t)column_patch.num_rows
+				);
+			} else {
+				table->change_ticks[chunk_index * table->signature.length + column] = world->change_tick;
+			}
+		}
+	}
 
-	world->update_mask = EECS_UPDATE_NONE;
-}
+	// The free lists are rebuilt from the NULL tables on the next reuse
+	if (num_slots > world->num_entity_slots) {
+		eecs_grow_entity_slots(world, num_slots - world->num_entity_slots);
+	} else {
+		eecs_truncate_entity_slots(world, num_slots);
+	}
+	world->relink_free_entity_slots = true;
+	reader = directory_reader;
+	for (;;) {
+		eecs_delta_entity_t change;
+		eecs_snapshot_read(&reader, &change, sizeof(change));
+		if (change.slot_index < 0) { break; }
+
+		eecs_snapshot_entity_t entity = change.entity;
+		*eecs_entity_slot(world, change.slot_index + 1) = (eecs_entity_data_t){
+			.table = entity.table_index >= 0 ? world->tables[entity.table_index] : NULL,
+			.gen = entity.gen,
+			.pos_in_table = entity.pos_in_table,
+		};
+	}
 
-eecs_mask_t
-eecs_get_current_update_mask(eecs_world_t* world) {
-	return world->update_mask;
+	// Sets which changed replace the replica's, without callbacks
+	reader = sparse_set_reader;
+	for (;;) {
+		eecs_snapshot_sparse_set_t set_header;
+		eecs_snapshot_read(&reader, &set_header, sizeof(set_header));
+		if (set_header.component_index == EECS_DELTA_END_OF_LIST) { break; }
+
+		eecs_id_t num_members = (eecs_id_t)set_header.num_entities;
+		eecs_sparse_set_t* set = &world->sparse_sets[set_header.component_index];
+		const char* ids = eecs_snapshot_skip(&reader, sizeof(eecs_id_t) * (size_t)num_members);
+		const char* data = eecs_snapshot_skip(&reader, set->component_size * (size_t)num_members);
+
+		eecs_array_indexed_foreach(eecs_id_t, itr, set->entities) {
+			set->positions[*itr.value - 1] = 0;
+		}
+		eecs_array_clear(set->entities);
+		for (eecs_id_t i = 0; i < num_members; ++i) {
+			eecs_id_t from_1_index;
+			memcpy(&from_1_index, ids + sizeof(eecs_id_t) * (size_t)i, sizeof(from_1_index));
+			memcpy(
+				eecs_push_sparse_member(world, set, from_1_index),
+				data + set->component_size * (size_t)i,
+				set->component_size
+			);
+		}
+	}
+
+	world->new_entity_gen = (eecs_id_t)header.new_entity_gen;
+	return true;
 }
 
 eecs_id_t
@@ -1936,9 +8452,40 @@ eecs_get_batch_size(eecs_batch_t batch) {
 	return batch.size;
 }
 
+eecs_id_t
+eecs_get_padded_batch_size(eecs_batch_t batch) {
+	return batch.padded_size;
+}
+
 void*
 eecs_get_components_in_batch(eecs_batch_t batch, eecs_id_t match_index) {
-	return (char*)batch.chunk + batch.offsets[match_index];
+	ptrdiff_t offset = batch.offsets[match_index];
+	return offset >= 0 ? (char*)batch.chunk + offset : NULL;
+}
+
+const eecs_mask_t*
+eecs_get_enable_masks_in_batch(
+	eecs_batch_t batch,
+	eecs_id_t match_index,
+	eecs_id_t* first_bit_out
+) {
+	ptrdiff_t offset = batch.enable_mask_offsets != NULL ? batch.enable_mask_offsets[match_index] : -1;
+	if (offset < 0) { return NULL; }
+
+	eecs_id_t num_bits_per_mask = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
+	const char* chunk = (const char*)((const eecs_id_t*)batch.chunk - batch.first_row);
+	if (first_bit_out != NULL) { *first_bit_out = batch.first_row % num_bits_per_mask; }
+	return (const eecs_mask_t*)(chunk + offset) + batch.first_row / num_bits_per_mask;
+}
+
+bool
+eecs_is_enabled_in_batch(eecs_batch_t batch, eecs_id_t match_index, eecs_id_t index) {
+	EECS_ASSERT(index < batch.size, "Out of bound access");
+	if (batch.offsets[match_index] < 0) { return false; }
+
+	eecs_id_t first_bit;
+	const eecs_mask_t* masks = eecs_get_enable_masks_in_batch(batch, match_index, &first_bit);
+	return masks == NULL || eecs_is_mask_bit_set(masks, first_bit + index);
 }
 
 eecs_entity_t
@@ -1947,7 +8494,7 @@ eecs_get_entity_in_batch(eecs_batch_t batch, eecs_id_t index) {
 
 	const eecs_id_t* entity_ids = batch.chunk;
 	eecs_id_t from_1_index = entity_ids[index];
-	const eecs_entity_data_t* entity_data = &batch.world->entities[from_1_index - 1];
+	const eecs_entity_data_t* entity_data = eecs_entity_slot(batch.world, from_1_index);
 
 	return (eecs_entity_t){
 		.from_1_index = from_1_index,
@@ -1969,21 +8516,84 @@ eecs_get_component_in_entity(
 	const eecs_entity_data_t* entity_data = eecs_get_entity_data(world, entity);
 	if (entity_data == NULL) { return NULL; }
 
-	const eecs_table_t* table = entity_data->table;
-	eecs_id_t pos_in_table = entity_data->pos_in_table;
-	eecs_id_t chunk_index = pos_in_table / table->num_entities_per_chunk;
-	eecs_id_t pos_in_chunk = pos_in_table % table->num_entities_per_chunk;
-	char* chunk = table->chunks[chunk_index];
+	eecs_table_t* table = entity_data->table;
+	eecs_id_t column = eecs_find_column(table, component_type);
+	if (column < 0) {
+		return eecs_get_sparse_component(world, eecs_index_of(component_type), entity.from_1_index);
+	}
 
-	for (eecs_id_t i = 0; i < table->signature.length; ++i) {
-		if (table->signature.components->from_1_index == component_type.from_1_index) {
-			return chunk
-				+ table->component_storage_offsets[i]
-				+ pos_in_chunk * table->component_sizes[i];
+	eecs_own_rows(world, table, entity_data->pos_in_table, 1);
+	return eecs_get_column_address(table, column, entity_data->pos_in_table);
+}
+
+void
+eecs_get_components_for_entities(
+	eecs_world_t* world,
+	const eecs_entity_t* entities,
+	eecs_id_t count,
+	eecs_component_t component,
+	void** out
+) {
+	eecs_get_multiple_components_for_entities(
+		world, entities, count,
+		(eecs_component_t[]){ component, EECS_END_OF_LIST },
+		out
+	);
+}
+
+void
+eecs_get_multiple_components_for_entities(
+	eecs_world_t* world,
+	const eecs_entity_t* entities,
+	eecs_id_t count,
+	const eecs_component_t* components,
+	void** out
+) {
+	eecs_id_t num_components = eecs_component_list_length(components);
+	if (num_components == 0) { return; }
+	if (world->rebase_entities) { eecs_own_entities(world); }
+
+	// Directory entries are prefetched two distances ahead. One distance
+	// ahead, they are in cache and the rows they point to are prefetched.
+	eecs_id_t num_slots = world->num_entity_slots;
+	for (eecs_id_t i = 0; i < count; ++i) {
+		eecs_id_t ahead = i + 2 * EECS_PREFETCH_DISTANCE;
+		if (ahead < count) {
+			eecs_id_t from_1_index = entities[ahead].from_1_index;
+			if (1 <= from_1_index && from_1_index <= num_slots) {
+				EECS_PREFETCH(eecs_entity_slot(world, from_1_index));
+			}
 		}
-	}
 
-	return NULL;
+		ahead = i + EECS_PREFETCH_DISTANCE;
+		if (ahead < count) {
+			const eecs_entity_data_t* entity_data = eecs_get_entity_data(world, entities[ahead]);
+			if (entity_data != NULL) {
+				eecs_id_t column = eecs_find_column(entity_data->table, components[0]);
+				if (column >= 0) {
+					EECS_PREFETCH(eecs_get_column_address(
+						entity_data->table, column, entity_data->pos_in_table
+					));
+				}
+			}
+		}
+
+		void** entity_out = &out[i * num_components];
+		const eecs_entity_data_t* entity_data = eecs_get_entity_data(world, entities[i]);
+		if (entity_data == NULL) {
+			for (eecs_id_t j = 0; j < num_components; ++j) { entity_out[j] = NULL; }
+			continue;
+		}
+
+		eecs_table_t* table = entity_data->table;
+		eecs_own_rows(world, table, entity_data->pos_in_table, 1);
+		for (eecs_id_t j = 0; j < num_components; ++j) {
+			eecs_id_t column = eecs_find_column(table, components[j]);
+			entity_out[j] = column >= 0
+				? eecs_get_column_address(table, column, entity_data->pos_in_table)
+				: eecs_get_sparse_component(world, eecs_index_of(components[j]), entities[i].from_1_index);
+		}
+	}
 }
 
 void
@@ -1994,57 +8604,20 @@ eecs_morph_entity(
 	const eecs_component_t* removed_components
 ) {
 	eecs_sync_world(world);
+	EECS_ASSERT(!world->structure_locked, "System declared no structural changes");
+	EECS_ASSERT(!eecs_has_per_entity_init(new_components), "per_entity is only supported by eecs_create_entities");
 
 	eecs_entity_data_t* entity_data = eecs_get_entity_data(world, handle);
 	if (entity_data == NULL) { return; }
 
-	if (entity_data->table == world->current_update_table) {
+	if (eecs_should_defer(world, entity_data)) {
 		eecs_deferred_op_t* op = eecs_alloc_deferred_op(world, EECS_MORPH_ENTITY, handle);
-
-		eecs_id_t num_new_components = eecs_component_init_list_length(new_components);
-		if (new_components != NULL && num_new_components > 0) {
-			eecs_component_init_t* new_components_copy = eecs_arena_alloc(
-				world, &world->deferred_arena,
-				sizeof(eecs_component_init_t) * (num_new_components + 1),
-				_Alignof(eecs_component_init_t)
-			);
-			for (eecs_id_t i = 0; i < num_new_components; ++i) {
-				new_components_copy[i].component = new_components[i].component;
-				const void* init_data = new_components[i].data;
-				if (init_data != NULL) {
-					const eecs_component_options_t* component_options = &world->ecs->components[eecs_index_of(new_components[i].component)];
-					void* data_copy = eecs_arena_alloc(
-						world, &world->deferred_arena,
-						component_options->size, component_options->alignment
-					);
-					memcpy(data_copy, init_data, component_options->size);
-
-					new_components_copy[i].data = data_copy;
-				} else {
-					new_components_copy[i].data = NULL;
-				}
-			}
-			new_components_copy[num_new_components] = (eecs_component_init_t){ 0 };
-			op->new_components = new_components_copy;
-		}
-
-		eecs_id_t num_removed_components = eecs_component_list_length(removed_components);
-		if (removed_components != NULL && num_removed_components > 0) {
-			eecs_component_t* removed_components_copy = eecs_arena_alloc(
-				world, &world->deferred_arena,
-				sizeof(eecs_component_t) * (num_removed_components + 1),
-				_Alignof(eecs_component_t)
-			);
-			memcpy(
-				removed_components_copy,
-				removed_components,
-				sizeof(eecs_component_t) * (num_removed_components + 1)
-			);
-			op->removed_components = removed_components_copy;
-		}
+		eecs_arena_t* deferred_arena = eecs_deferred_arena(world);
+		op->new_components = eecs_copy_deferred_new_components(world, deferred_arena, new_components);
+		op->removed_components = eecs_copy_deferred_removed_components(world, deferred_arena, removed_components);
 	} else {
 		eecs_morph_entity_now(
-			world, entity_data, new_components, removed_components
+			world, handle, new_components, removed_components
 		);
 	}
 }
@@ -1,5 +1,6 @@
 #include <munit/munit.h>
 #include <eecs.h>
+#include <limits.h>
 #include "components.h"
 
 struct SystemData {
@@ -176,10 +177,1888 @@ init_cleanup(const MunitParameter params[], void* fixture) {
 	return MUNIT_OK;
 }
 
+static void
+count_per_entity(
+	eecs_world_t* world,
+	eecs_entity_t entity,
+	void* userdata
+) {
+	munit_assert_true(eecs_is_valid_entity(world, entity));
+	++*(int*)userdata;
+}
+
+static MunitResult
+create_entities(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	int num_inits = 0;
+	eecs_system_t system = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.init_per_entity_fn = count_per_entity,
+		.userdata = &num_inits,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+
+	// Leave a few free slots to be reused
+	eecs_entity_t destroyed[3];
+	for (int i = 0; i < 3; ++i) {
+		destroyed[i] = eecs_create_entity(world, (eecs_component_init_t[]){
+			{ .component = comp_B },
+			EECS_END_OF_LIST,
+		});
+	}
+	for (int i = 0; i < 3; ++i) {
+		eecs_destroy_entity(world, destroyed[i]);
+	}
+
+	enum { NUM_ENTITIES = 2000 };
+	static struct A as[NUM_ENTITIES];
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		as[i].a = (float)i;
+	}
+
+	static eecs_entity_t entities[NUM_ENTITIES];
+	for (int round = 0; round < 2; ++round) {
+		eecs_create_entities(world, (eecs_component_init_t[]){
+			{
+				.component = comp_A,
+				.data = as,
+				.per_entity = true,
+			},
+			{
+				.component = comp_B,
+				.data = &(struct B){ .b = 42, .c = 43 },
+			},
+			{ .component = comp_C },
+			EECS_END_OF_LIST,
+		}, NUM_ENTITIES, entities);
+
+		for (int i = 0; i < NUM_ENTITIES; ++i) {
+			struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+			struct B* b = eecs_get_component_in_entity(world, entities[i], comp_B);
+			struct C* c = eecs_get_component_in_entity(world, entities[i], comp_C);
+			munit_assert_float(a->a, ==, (float)i);
+			munit_assert_int(b->b, ==, 42);
+			munit_assert_int(b->c, ==, 43);
+			munit_assert_int(c->b, ==, 0);
+		}
+	}
+	munit_assert_int(num_inits, ==, NUM_ENTITIES * 2);
+	munit_assert_int(entities[0].from_1_index, >, NUM_ENTITIES);
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+count_batch(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	*(int*)userdata += eecs_get_batch_size(batch);
+}
+
+static MunitResult
+changed_filter(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	int num_written = 0;
+	eecs_system_t writer = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &writer, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.write_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.update_fn = count_batch,
+		.userdata = &num_written,
+	});
+
+	int num_seen = 0;
+	eecs_system_t reader = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &reader, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.read_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.changed_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.update_fn = count_batch,
+		.userdata = &num_seen,
+	});
+
+	// Does not see its own writes
+	int num_self_seen = 0;
+	eecs_system_t self_writer = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &self_writer, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.changed_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = count_batch,
+		.userdata = &num_self_seen,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+
+	enum { NUM_ENTITIES = 5000 };
+	static eecs_entity_t entities[NUM_ENTITIES];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	}, NUM_ENTITIES, entities);
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, NUM_ENTITIES, entities);
+
+	// Everything is new on the first run, then nothing changed
+	eecs_run_system(world, EECS_UPDATE_ALL, reader);
+	munit_assert_int(num_seen, ==, NUM_ENTITIES);
+	num_seen = 0;
+	eecs_run_system(world, EECS_UPDATE_ALL, reader);
+	munit_assert_int(num_seen, ==, 0);
+
+	eecs_run_system(world, EECS_UPDATE_ALL, self_writer);
+	munit_assert_int(num_self_seen, ==, NUM_ENTITIES * 2);
+	num_self_seen = 0;
+	eecs_run_system(world, EECS_UPDATE_ALL, self_writer);
+	munit_assert_int(num_self_seen, ==, 0);
+
+	// Writes by another system
+	eecs_run_system(world, EECS_UPDATE_ALL, writer);
+	munit_assert_int(num_written, ==, NUM_ENTITIES);
+	eecs_run_system(world, EECS_UPDATE_ALL, reader);
+	munit_assert_int(num_seen, ==, NUM_ENTITIES);
+
+	// Only the chunk containing the entity is reported
+	num_seen = 0;
+	eecs_mark_component_changed(world, entities[NUM_ENTITIES - 1], comp_B);
+	eecs_run_system(world, EECS_UPDATE_ALL, reader);
+	munit_assert_int(num_seen, >, 0);
+	munit_assert_int(num_seen, <, NUM_ENTITIES);
+
+	// Structural changes are seen by everyone
+	num_seen = 0;
+	eecs_destroy_entity(world, entities[0]);
+	eecs_run_system(world, EECS_UPDATE_ALL, reader);
+	munit_assert_int(num_seen, >, 0);
+	munit_assert_int(num_seen, <, NUM_ENTITIES);
+
+	num_self_seen = 0;
+	eecs_run_system(world, EECS_UPDATE_ALL, self_writer);
+	munit_assert_int(num_self_seen, >, 0);
+	munit_assert_int(num_self_seen, <, NUM_ENTITIES);
+
+	num_seen = 0;
+	eecs_run_system(world, EECS_UPDATE_ALL, reader);
+	munit_assert_int(num_seen, ==, 0);
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static MunitResult
+templates(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+
+	eecs_template_t first = EECS_HANDLE_INIT;
+	eecs_template_t second = EECS_HANDLE_INIT;
+	eecs_register_template(world, &first, (eecs_component_init_t[]){
+		{ .component = comp_A, .data = &(struct A){ .a = 1.f } },
+		{ .component = comp_B, .data = &(struct B){ .b = 2, .c = 3 } },
+		EECS_END_OF_LIST,
+	});
+	eecs_register_template(world, &second, (eecs_component_init_t[]){
+		{ .component = comp_B, .data = &(struct B){ .b = 4 } },
+		EECS_END_OF_LIST,
+	});
+	munit_assert_int(first.from_1_index, !=, 0);
+	munit_assert_int(second.from_1_index, !=, first.from_1_index);
+
+	eecs_entity_t entity = eecs_create_entity_from_template(world, first, NULL);
+	munit_assert_float(((struct A*)eecs_get_component_in_entity(world, entity, comp_A))->a, ==, 1.f);
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(world, entity, comp_B))->b, ==, 2);
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(world, entity, comp_B))->c, ==, 3);
+
+	entity = eecs_create_entity_from_template(world, first, (eecs_component_init_t[]){
+		{ .component = comp_B, .data = &(struct B){ .b = 5 } },
+		EECS_END_OF_LIST,
+	});
+	munit_assert_float(((struct A*)eecs_get_component_in_entity(world, entity, comp_A))->a, ==, 1.f);
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(world, entity, comp_B))->b, ==, 5);
+
+	entity = eecs_create_entity_from_template(world, second, NULL);
+	munit_assert_null(eecs_get_component_in_entity(world, entity, comp_A));
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(world, entity, comp_B))->b, ==, 4);
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+destroy_first_in_batch(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	eecs_destroy_entity(world, eecs_get_entity_in_batch(batch, 0));
+}
+
+static MunitResult
+stats(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	int num_seen = 0;
+	eecs_system_t counter = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &counter, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = count_batch,
+		.userdata = &num_seen,
+	});
+	eecs_system_t destroyer = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &destroyer, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.update_fn = destroy_first_in_batch,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	eecs_reset_stats(world);
+
+	eecs_entity_t entities[10];
+	for (int i = 0; i < 5; ++i) {
+		entities[i] = eecs_create_entity(world, (eecs_component_init_t[]){
+			{ .component = comp_A },
+			EECS_END_OF_LIST,
+		});
+	}
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, 5, entities + 5);
+	eecs_morph_entity(world, entities[0], NULL, (eecs_component_t[]){ comp_A, EECS_END_OF_LIST });
+	eecs_morph_entities(world, entities + 1, 2, (eecs_component_init_t[]){
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, NULL);
+	eecs_destroy_entity(world, entities[0]);
+	eecs_run_systems(world, EECS_UPDATE_ALL);
+
+	eecs_world_stats_t world_stats;
+	munit_assert_true(eecs_get_world_stats(world, &world_stats));
+	munit_assert_int(world_stats.num_entities_created, ==, 10);
+	munit_assert_int(world_stats.num_entities_morphed, ==, 3);
+	munit_assert_int(world_stats.num_entities_destroyed, ==, 2);
+	// {A}, {A, B} and {}
+	munit_assert_int(world_stats.num_tables_created, ==, 3);
+	munit_assert_int(world_stats.num_chunks_allocated, >, 0);
+
+	eecs_system_stats_t system_stats;
+	munit_assert_true(eecs_get_system_stats(world, counter, &system_stats));
+	munit_assert_int(system_stats.num_runs, ==, 1);
+	munit_assert_int(system_stats.num_matched_tables, ==, 2);
+	munit_assert_int(system_stats.num_chunks_visited, ==, 2);
+	munit_assert_int(system_stats.num_entities_processed, ==, num_seen);
+	munit_assert_int(system_stats.num_deferred_ops_applied, ==, 0);
+
+	munit_assert_true(eecs_get_system_stats(world, destroyer, &system_stats));
+	munit_assert_int(system_stats.num_chunks_visited, ==, 1);
+	munit_assert_int(system_stats.num_deferred_ops_applied, ==, 1);
+
+	eecs_reset_stats(world);
+	munit_assert_true(eecs_get_world_stats(world, &world_stats));
+	munit_assert_int(world_stats.num_entities_created, ==, 0);
+	munit_assert_true(eecs_get_system_stats(world, counter, &system_stats));
+	munit_assert_int(system_stats.num_runs, ==, 0);
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static MunitResult
+compact(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.table_chunk_size = 256,
+	});
+
+	const eecs_component_init_t init[] = {
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	};
+	eecs_entity_t entities[200];
+	eecs_create_entities(world, init, 200, entities);
+
+	eecs_table_memory_t tables[4];
+	munit_assert_int(eecs_get_table_memory(world, tables, 4), ==, 1);
+	munit_assert_int(tables[0].num_entities, ==, 200);
+	munit_assert_int(tables[0].entity_size, ==, sizeof(eecs_id_t) + sizeof(struct A));
+	munit_assert_int(
+		tables[0].num_chunks,
+		==,
+		(200 + tables[0].num_entities_per_chunk - 1) / tables[0].num_entities_per_chunk
+	);
+	eecs_id_t peak_num_chunks = tables[0].num_chunks;
+
+	// Keep a few entities in the middle and destroy the tail
+	eecs_destroy_entities(world, entities, 50);
+	eecs_destroy_entities(world, entities + 60, 140);
+
+	eecs_world_memory_t memory;
+	eecs_get_world_memory(world, &memory);
+	munit_assert_int(memory.num_entity_slots, ==, 200);
+	munit_assert_int(memory.num_free_entity_slots, ==, 190);
+	munit_assert_int(memory.num_pooled_chunks, >=, peak_num_chunks - memory.num_table_chunks);
+
+	eecs_compact_world(world, 1);
+
+	eecs_get_world_memory(world, &memory);
+	munit_assert_int(memory.num_pooled_chunks, <=, 1);
+	munit_assert_int(memory.num_entity_slots, ==, 60);
+	munit_assert_int(
+		memory.entity_slot_capacity,
+		==,
+		(60 + EECS_ENTITY_PAGE_SIZE - 1) / EECS_ENTITY_PAGE_SIZE * EECS_ENTITY_PAGE_SIZE
+	);
+	munit_assert_int(memory.num_free_entity_slots, ==, 50);
+
+	for (int i = 0; i < 200; ++i) {
+		munit_assert_int(eecs_is_valid_entity(world, entities[i]), ==, 50 <= i && i < 60);
+	}
+
+	// New slots must not revive stale handles to the trimmed ones
+	eecs_entity_t new_entities[200];
+	eecs_create_entities(world, init, 200, new_entities);
+	munit_assert_int(new_entities[0].from_1_index, ==, 1);
+	for (int i = 0; i < 200; ++i) {
+		munit_assert_true(eecs_is_valid_entity(world, new_entities[i]));
+		munit_assert_int(eecs_is_valid_entity(world, entities[i]), ==, 50 <= i && i < 60);
+	}
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static MunitResult
+entity_pages(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	const eecs_component_init_t init[] = {
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	};
+	const eecs_id_t page_size = EECS_ENTITY_PAGE_SIZE;
+	eecs_id_t num_entities = page_size * 3 + page_size / 2;
+	eecs_entity_t* entities = malloc(sizeof(eecs_entity_t) * (size_t)num_entities);
+
+	// The directory grows a page at a time and entities stay where they are
+	eecs_world_memory_t memory;
+	for (eecs_id_t i = 0; i < num_entities; ++i) {
+		entities[i] = eecs_create_entity(world, init);
+		((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a = (float)i;
+		if (i % page_size == 0) {
+			eecs_get_world_memory(world, &memory);
+			munit_assert_int(memory.entity_slot_capacity, ==, (i / page_size + 1) * page_size);
+		}
+	}
+	for (eecs_id_t i = 0; i < num_entities; ++i) {
+		munit_assert_int(entities[i].from_1_index, ==, i + 1);
+		munit_assert_float(((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a, ==, (float)i);
+	}
+
+	// Free slots are reused a page at a time, the page freed last first
+	const eecs_id_t freed_pages[] = { 2, 0, 1 };
+	for (int i = 0; i < 3; ++i) {
+		for (eecs_id_t j = 1; j <= 3; ++j) {
+			eecs_destroy_entity(world, entities[freed_pages[i] * page_size + j]);
+		}
+	}
+	for (int i = 0; i < 9; ++i) {
+		eecs_entity_t reused = eecs_create_entity(world, init);
+		munit_assert_int((reused.from_1_index - 1) / page_size, ==, freed_pages[2 - i / 3]);
+		munit_assert_false(eecs_is_valid_entity(world, entities[reused.from_1_index - 1]));
+	}
+	eecs_entity_t appended = eecs_create_entity(world, init);
+	munit_assert_int(appended.from_1_index, ==, num_entities + 1);
+
+	// Compacting drops the empty pages at the end, the free slots left are
+	// reused lowest first
+	eecs_id_t num_kept = page_size * 2 + page_size / 4;
+	eecs_destroy_entity(world, appended);
+	eecs_destroy_entities(world, entities + num_kept, num_entities - num_kept);
+	eecs_destroy_entity(world, entities[page_size + 5]);
+	eecs_destroy_entity(world, entities[5]);
+	eecs_compact_world(world, 0);
+	eecs_get_world_memory(world, &memory);
+	munit_assert_int(memory.num_entity_slots, ==, num_kept);
+	munit_assert_int(memory.entity_slot_capacity, ==, page_size * 3);
+	munit_assert_int(memory.num_free_entity_slots, ==, 2);
+
+	eecs_entity_t after_compact[3];
+	eecs_create_entities(world, init, 3, after_compact);
+	munit_assert_int(after_compact[0].from_1_index, ==, 6);
+	munit_assert_int(after_compact[1].from_1_index, ==, page_size + 6);
+	munit_assert_int(after_compact[2].from_1_index, ==, num_kept + 1);
+	munit_assert_false(eecs_is_valid_entity(world, entities[num_kept]));
+	munit_assert_false(eecs_is_valid_entity(world, entities[num_entities - 1]));
+	for (eecs_id_t i = page_size * 2 + 4; i < num_kept; ++i) {
+		munit_assert_float(((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a, ==, (float)i);
+	}
+
+	free(entities);
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static MunitResult
+chunk_pool(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+
+	eecs_chunk_pool_t* pool = eecs_create_chunk_pool((eecs_chunk_pool_options_t){
+		.chunk_size = 256,
+		.low_watermark = 2,
+		.high_watermark = 8,
+	});
+	munit_assert_int(eecs_get_chunk_pool_size(pool), ==, 2);
+
+	const eecs_component_init_t init[] = {
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	};
+	eecs_entity_t entities[300];
+
+	// Worlds warm up from the pool and give their chunks back on destruction
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.chunk_pool = pool,
+	});
+	eecs_create_entities(world, init, 3, entities);
+	eecs_world_memory_t memory;
+	eecs_get_world_memory(world, &memory);
+	munit_assert_int(memory.table_chunk_size, ==, 256);
+	munit_assert_int(eecs_get_chunk_pool_size(pool), ==, 0);
+	eecs_destroy_world(world);
+	munit_assert_int(eecs_get_chunk_pool_size(pool), >=, 2);
+	munit_assert_int(eecs_get_chunk_pool_size(pool), <=, 8);
+
+	world = eecs_create_world(ecs, (eecs_world_options_t){
+		.chunk_pool = pool,
+	});
+	eecs_reset_stats(world);
+	eecs_create_entities(world, init, 3, entities);
+	eecs_world_stats_t stats;
+	if (eecs_get_world_stats(world, &stats)) {
+		munit_assert_int(stats.num_chunks_reused, >, 0);
+	}
+
+	// Going above the high watermark trims the pool to the low one
+	eecs_create_entities(world, init, 300, entities);
+	eecs_destroy_world(world);
+	munit_assert_int(eecs_get_chunk_pool_size(pool), ==, 2);
+
+	eecs_destroy_chunk_pool(pool);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static MunitResult
+chunk_pool_reserve(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+
+	// Too small for all the chunks so that the allocator is also used
+	eecs_chunk_pool_t* pool = eecs_create_chunk_pool((eecs_chunk_pool_options_t){
+		.chunk_size = 4096,
+		.low_watermark = 1,
+		.high_watermark = 4,
+		.reserve_size = 4096 * 16,
+	});
+
+	enum { NUM_ENTITIES = 20000 };
+	static eecs_entity_t entities[NUM_ENTITIES];
+	for (int round = 0; round < 2; ++round) {
+		eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+			.chunk_pool = pool,
+		});
+
+		eecs_create_entities(world, (eecs_component_init_t[]){
+			{ .component = comp_A },
+			EECS_END_OF_LIST,
+		}, NUM_ENTITIES, entities);
+		for (int i = 0; i < NUM_ENTITIES; ++i) {
+			struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+			a->a = (float)i;
+		}
+		for (int i = 0; i < NUM_ENTITIES; ++i) {
+			struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+			munit_assert_float(a->a, ==, (float)i);
+		}
+
+		eecs_destroy_world(world);
+		munit_assert_int(eecs_get_chunk_pool_size(pool), ==, 1);
+	}
+
+	eecs_destroy_chunk_pool(pool);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+count_valid_rows(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+		*(int*)userdata += eecs_is_valid_entity(world, eecs_get_entity_in_batch(batch, i));
+	}
+}
+
+static MunitResult
+chunk_pool_partial_pages(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	int num_valid_rows = 0;
+	eecs_system_t system = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = count_valid_rows,
+		.userdata = &num_valid_rows,
+	});
+
+	// Chunks straddle page boundaries so trimming one must leave the pages
+	// shared with its neighbours alone
+	eecs_chunk_pool_t* pool = eecs_create_chunk_pool((eecs_chunk_pool_options_t){
+		.chunk_size = 6144,
+		.high_watermark = 1,
+		.reserve_size = 6144 * 64,
+	});
+	eecs_world_t* worlds[2];
+	for (int i = 0; i < 2; ++i) {
+		worlds[i] = eecs_create_world(ecs, (eecs_world_options_t){
+			.chunk_pool = pool,
+		});
+	}
+
+	// Interleave the chunks of both worlds
+	enum { NUM_ENTITIES = 6000 };
+	static eecs_entity_t entities[NUM_ENTITIES];
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		entities[i] = eecs_create_entity(worlds[i / 500 % 2], (eecs_component_init_t[]){
+			{ .component = comp_A, .data = &(struct A){ .a = (float)i } },
+			EECS_END_OF_LIST,
+		});
+	}
+
+	eecs_destroy_world(worlds[0]);
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		if (i / 500 % 2 == 0) { continue; }
+
+		munit_assert_true(eecs_is_valid_entity(worlds[1], entities[i]));
+		struct A* a = eecs_get_component_in_entity(worlds[1], entities[i], comp_A);
+		munit_assert_float(a->a, ==, (float)i);
+	}
+	eecs_run_systems(worlds[1], EECS_UPDATE_ALL);
+	munit_assert_int(num_valid_rows, ==, NUM_ENTITIES / 2);
+
+	eecs_destroy_world(worlds[1]);
+	eecs_destroy_chunk_pool(pool);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+scale_padded_batch(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	eecs_id_t size = eecs_get_batch_size(batch);
+	eecs_id_t padded_size = eecs_get_padded_batch_size(batch);
+	munit_assert_int(padded_size % 16, ==, 0);
+	munit_assert_int(padded_size, >=, size);
+	munit_assert_int(padded_size - size, <, 16);
+
+	struct A* as = eecs_get_components_in_batch(batch, 0);
+	struct B* bs = eecs_get_components_in_batch(batch, 1);
+	munit_assert_int((uintptr_t)as % 64, ==, 0);
+	munit_assert_int((uintptr_t)bs % 64, ==, 0);
+	munit_assert_int((uintptr_t)batch.chunk % 64, ==, 0);
+
+	// No remainder loop
+	for (eecs_id_t i = 0; i < padded_size; ++i) {
+		as[i].a *= 2.f;
+	}
+	*(int*)userdata += size;
+}
+
+static MunitResult
+simd_layout(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	int num_seen = 0;
+	eecs_system_t scale = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &scale, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, comp_B, EECS_END_OF_LIST },
+		.update_fn = scale_padded_batch,
+		.userdata = &num_seen,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.table_chunk_size = 4096,
+		.column_alignment = 64,
+		.batch_width = 16,
+	});
+
+	eecs_entity_t entities[1000];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A, .data = &(struct A){ .a = 1.f } },
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, 1000, entities);
+
+	eecs_table_memory_t table;
+	eecs_get_table_memory(world, &table, 1);
+	munit_assert_int(table.num_entities_per_chunk % 16, ==, 0);
+
+	eecs_run_systems(world, EECS_UPDATE_ALL);
+	munit_assert_int(num_seen, ==, 1000);
+	for (int i = 0; i < 1000; ++i) {
+		struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+		munit_assert_float(a->a, ==, 2.f);
+	}
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+struct InitLog {
+	int entries[16];
+	int length;
+};
+
+static void
+log_init_1(eecs_world_t* world, eecs_entity_t entity, void* userdata) {
+	struct InitLog* log = userdata;
+	log->entries[log->length++] = 1;
+}
+
+static void
+log_init_2(eecs_world_t* world, eecs_entity_t entity, void* userdata) {
+	struct InitLog* log = userdata;
+	log->entries[log->length++] = 2;
+}
+
+static MunitResult
+incremental_sync(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	struct InitLog log = { 0 };
+	eecs_system_t logger_1 = EECS_HANDLE_INIT;
+	eecs_system_options_t logger_1_options = {
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.init_per_entity_fn = log_init_1,
+		.userdata = &log,
+	};
+	eecs_register_system(ecs, &logger_1, logger_1_options);
+	eecs_system_t logger_2 = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &logger_2, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.init_per_entity_fn = log_init_2,
+		.userdata = &log,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	for (int i = 0; i < 4; ++i) {
+		eecs_create_entity(world, (eecs_component_init_t[]){
+			{ .component = comp_A },
+			EECS_END_OF_LIST,
+		});
+	}
+	eecs_create_entity(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	});
+	log.length = 0;
+
+	// A late system is matched against the existing tables
+	int num_seen = 0;
+	eecs_system_t counter = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &counter, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = count_batch,
+		.userdata = &num_seen,
+	});
+	eecs_run_system(world, EECS_UPDATE_ALL, counter);
+	munit_assert_int(num_seen, ==, 5);
+
+	// Re-registration replaces the previous match and, even after many of
+	// them, callbacks stay in system order
+	for (int i = 0; i < 10; ++i) {
+		eecs_register_system(ecs, &counter, (eecs_system_options_t){
+			.require_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+			.update_fn = count_batch,
+			.userdata = &num_seen,
+		});
+		eecs_register_system(ecs, &logger_1, logger_1_options);
+
+		num_seen = 0;
+		eecs_run_system(world, EECS_UPDATE_ALL, counter);
+		munit_assert_int(num_seen, ==, 1);
+
+		log.length = 0;
+		eecs_create_entity(world, (eecs_component_init_t[]){
+			{ .component = comp_A },
+			EECS_END_OF_LIST,
+		});
+		munit_assert_int(log.length, ==, 2);
+		munit_assert_int(log.entries[0], ==, 1);
+		munit_assert_int(log.entries[1], ==, 2);
+	}
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static MunitResult
+query(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	eecs_entity_t entities[6];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A, .data = &(struct A){ .a = 1.f } },
+		EECS_END_OF_LIST,
+	}, 3, entities);
+
+	eecs_query_t* query = eecs_create_query(world, (eecs_query_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.exclude_components = (eecs_component_t[]){ comp_C, EECS_END_OF_LIST },
+		.optional_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+	});
+
+	// Tables created after the query are matched as they appear
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A, .data = &(struct A){ .a = 2.f } },
+		{ .component = comp_B, .data = &(struct B){ .b = 2 } },
+		EECS_END_OF_LIST,
+	}, 2, entities + 3);
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		{ .component = comp_C },
+		EECS_END_OF_LIST,
+	}, 1, entities + 5);
+
+	int num_seen = 0;
+	eecs_query_iterator_t itr = eecs_iterate_query(query);
+	eecs_batch_t batch;
+	while (eecs_next_query_batch(&itr, &batch)) {
+		struct A* as = eecs_get_components_in_batch(batch, 0);
+		struct B* bs = eecs_get_components_in_batch(batch, 1);
+		for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+			if (bs != NULL) {
+				munit_assert_float(as[i].a, ==, 2.f);
+				munit_assert_int(bs[i].b, ==, 2);
+			} else {
+				munit_assert_float(as[i].a, ==, 1.f);
+			}
+		}
+		num_seen += eecs_get_batch_size(batch);
+	}
+	munit_assert_int(num_seen, ==, 5);
+
+	// Entities moving between tables are seen in their new ones
+	eecs_morph_entities(world, entities, 3, NULL, (eecs_component_t[]){ comp_A, EECS_END_OF_LIST });
+	eecs_morph_entities(world, entities, 3, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, (eecs_component_t[]){ comp_C, EECS_END_OF_LIST });
+	eecs_morph_entity(world, entities[5], NULL, (eecs_component_t[]){ comp_C, EECS_END_OF_LIST });
+
+	int num_batches = 0;
+	int num_seen_with_B = 0;
+	num_seen = 0;
+	itr = eecs_iterate_query(query);
+	while (eecs_next_query_batch(&itr, &batch)) {
+		if (eecs_get_components_in_batch(batch, 1) != NULL) {
+			num_seen_with_B += eecs_get_batch_size(batch);
+		}
+		num_seen += eecs_get_batch_size(batch);
+		++num_batches;
+	}
+	munit_assert_int(num_seen, ==, 6);
+	munit_assert_int(num_seen_with_B, ==, 5);
+	munit_assert_int(num_batches, ==, 2);
+
+	eecs_destroy_query(query);
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+struct OptionalCounts {
+	int num_with_B;
+	int num_without_B;
+};
+
+static void
+count_optional(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	struct OptionalCounts* counts = userdata;
+	struct A* as = eecs_get_components_in_batch(batch, 0);
+	struct B* bs = eecs_get_components_in_batch(batch, 1);
+	munit_assert_not_null(as);
+	if (bs != NULL) {
+		counts->num_with_B += eecs_get_batch_size(batch);
+	} else {
+		counts->num_without_B += eecs_get_batch_size(batch);
+	}
+}
+
+static MunitResult
+optional_components(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	struct OptionalCounts counts = { 0 };
+	eecs_system_t system = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.optional_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.update_fn = count_optional,
+		.userdata = &counts,
+	});
+
+	// Writes to the optional column are seen by changed filters
+	int num_changed = 0;
+	eecs_system_t changed = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &changed, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.changed_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.update_fn = count_batch,
+		.userdata = &num_changed,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	eecs_entity_t entities[6];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	}, 2, entities);
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, 3, entities + 2);
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		{ .component = comp_C },
+		EECS_END_OF_LIST,
+	}, 1, entities + 5);
+
+	eecs_run_system(world, EECS_UPDATE_ALL, changed);
+	munit_assert_int(num_changed, ==, 3);
+
+	eecs_run_system(world, EECS_UPDATE_ALL, system);
+	munit_assert_int(counts.num_with_B, ==, 3);
+	munit_assert_int(counts.num_without_B, ==, 3);
+
+	num_changed = 0;
+	eecs_run_system(world, EECS_UPDATE_ALL, changed);
+	munit_assert_int(num_changed, ==, 3);
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static MunitResult
+gather(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+
+	eecs_entity_t entities[40];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	}, 20, entities);
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, 20, entities + 20);
+	for (int i = 0; i < 40; ++i) {
+		((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a = (float)i;
+	}
+
+	// Interleave tables and put a dead handle in the middle
+	eecs_entity_t handles[40];
+	for (int i = 0; i < 20; ++i) {
+		handles[i * 2] = entities[i];
+		handles[i * 2 + 1] = entities[39 - i];
+	}
+	eecs_destroy_entity(world, entities[5]);
+
+	void* as[40];
+	eecs_get_components_for_entities(world, handles, 40, comp_A, as);
+	for (int i = 0; i < 40; ++i) {
+		if (i == 10) {
+			munit_assert_null(as[i]);
+			continue;
+		}
+		float expected = (float)(i % 2 == 0 ? i / 2 : 39 - i / 2);
+		munit_assert_float(((struct A*)as[i])->a, ==, expected);
+	}
+
+	void* abs[40 * 2];
+	eecs_get_multiple_components_for_entities(
+		world, handles, 40,
+		(eecs_component_t[]){ comp_A, comp_B, EECS_END_OF_LIST },
+		abs
+	);
+	for (int i = 0; i < 40; ++i) {
+		munit_assert_ptr_equal(abs[i * 2], as[i]);
+		void* b = eecs_get_component_in_entity(world, handles[i], comp_B);
+		munit_assert_ptr_equal(abs[i * 2 + 1], b);
+		if (i % 2 == 1) { munit_assert_not_null(b); }
+	}
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+struct SnapshotBuffer {
+	char* data;
+	size_t size;
+};
+
+static bool
+write_snapshot(const void* data, size_t size, void* userdata) {
+	struct SnapshotBuffer* buffer = userdata;
+	buffer->data = realloc(buffer->data, buffer->size + size);
+	memcpy(buffer->data + buffer->size, data, size);
+	buffer->size += size;
+	return true;
+}
+
+// Finds the first saved table with at least min_columns columns and two rows.
+// A snapshot is a header of 10 words, 4 words per component, then per table 4
+// words, 3 words per column and its chunks.
+static char*
+find_snapshot_table(const struct SnapshotBuffer* buffer, uint64_t min_columns) {
+	uint64_t header[10];
+	memcpy(header, buffer->data, sizeof(header));
+	uint64_t chunk_size = header[4];
+	char* table = buffer->data + sizeof(header) + sizeof(uint64_t) * 4 * header[5];
+	for (uint64_t i = 0; i < header[6]; ++i) {
+		uint64_t table_header[4];
+		memcpy(table_header, table, sizeof(table_header));
+		if (table_header[0] >= min_columns && table_header[1] >= 2) { return table; }
+		table += sizeof(table_header) + sizeof(uint64_t) * 3 * table_header[0] + chunk_size * table_header[3];
+	}
+	return NULL;
+}
+
+static MunitResult
+snapshot(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	eecs_entity_t entities[1000];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	}, 500, entities);
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, 500, entities + 500);
+	for (int i = 0; i < 1000; ++i) {
+		((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a = (float)i;
+		struct B* b = eecs_get_component_in_entity(world, entities[i], comp_B);
+		if (b != NULL) { b->b = i; }
+	}
+	// Leave holes in the directory
+	for (int i = 0; i < 1000; i += 7) {
+		eecs_destroy_entity(world, entities[i]);
+	}
+
+	struct SnapshotBuffer buffer = { 0 };
+	munit_assert_true(eecs_save_world(world, write_snapshot, &buffer));
+	eecs_destroy_world(world);
+
+	// Same registration order: handles survive and chunks are copied whole
+	eecs_world_t* loaded = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	munit_assert_true(eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){ 0 }));
+	for (int i = 0; i < 1000; ++i) {
+		struct A* a = eecs_get_component_in_entity(loaded, entities[i], comp_A);
+		struct B* b = eecs_get_component_in_entity(loaded, entities[i], comp_B);
+		if (i % 7 == 0) {
+			munit_assert_false(eecs_is_valid_entity(loaded, entities[i]));
+			continue;
+		}
+		munit_assert_float(a->a, ==, (float)i);
+		if (i >= 500) {
+			munit_assert_int(b->b, ==, i);
+		} else {
+			munit_assert_null(b);
+		}
+	}
+	// Free slots are reused with a new generation
+	eecs_entity_t reused = eecs_create_entity(loaded, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	});
+	munit_assert_int((reused.from_1_index - 1) % 7, ==, 0);
+	munit_assert_false(eecs_is_valid_entity(loaded, entities[(reused.from_1_index - 1)]));
+	eecs_destroy_world(loaded);
+
+	// Dropping B merges both tables, rows are copied column by column
+	loaded = eecs_create_world(ecs, (eecs_world_options_t){ .table_chunk_size = 4096 });
+	munit_assert_true(eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){
+		.component_map = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+	}));
+	for (int i = 1; i < 1000; ++i) {
+		if (i % 7 == 0) { continue; }
+		struct A* a = eecs_get_component_in_entity(loaded, entities[i], comp_A);
+		munit_assert_float(a->a, ==, (float)i);
+		munit_assert_null(eecs_get_component_in_entity(loaded, entities[i], comp_B));
+	}
+	eecs_destroy_world(loaded);
+
+	// Truncated or mismatched snapshots are rejected and leave the world empty
+	loaded = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	munit_assert_false(eecs_load_world(loaded, buffer.data, buffer.size - 1, (eecs_load_options_t){ 0 }));
+	munit_assert_false(eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){
+		.component_map = (eecs_component_t[]){ comp_B, comp_A },
+	}));
+	munit_assert_false(eecs_is_valid_entity(loaded, entities[1]));
+
+	// A column listed twice
+	char* table = find_snapshot_table(&buffer, 2);
+	munit_assert_not_null(table);
+	uint64_t* columns = (uint64_t*)(table + sizeof(uint64_t) * 4);
+	uint64_t second_column = columns[3];
+	columns[3] = columns[0];
+	munit_assert_false(eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){ 0 }));
+	columns[3] = second_column;
+
+	// Swapped row ids are still in range but do not match the directory
+	char* ids = table + sizeof(uint64_t) * (4 + 3 * 2);
+	eecs_id_t first_ids[2];
+	memcpy(first_ids, ids, sizeof(first_ids));
+	memcpy(ids, &first_ids[1], sizeof(eecs_id_t));
+	memcpy(ids + sizeof(eecs_id_t), &first_ids[0], sizeof(eecs_id_t));
+	munit_assert_false(eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){ 0 }));
+	memcpy(ids, first_ids, sizeof(first_ids));
+	munit_assert_false(eecs_is_valid_entity(loaded, entities[1]));
+	munit_assert_true(eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){ 0 }));
+	eecs_destroy_world(loaded);
+
+	free(buffer.data);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+assert_replicated(
+	eecs_world_t* world,
+	eecs_world_t* replica,
+	const eecs_entity_t* entities,
+	int num_entities,
+	eecs_component_t comp_A,
+	eecs_component_t comp_B
+) {
+	for (int i = 0; i < num_entities; ++i) {
+		munit_assert_int(
+			eecs_is_valid_entity(world, entities[i]), ==, eecs_is_valid_entity(replica, entities[i])
+		);
+		struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+		struct A* replica_a = eecs_get_component_in_entity(replica, entities[i], comp_A);
+		munit_assert_int(a == NULL, ==, replica_a == NULL);
+		if (a != NULL) { munit_assert_float(a->a, ==, replica_a->a); }
+		struct B* b = eecs_get_component_in_entity(world, entities[i], comp_B);
+		struct B* replica_b = eecs_get_component_in_entity(replica, entities[i], comp_B);
+		munit_assert_int(b == NULL, ==, replica_b == NULL);
+		if (b != NULL) { munit_assert_int(b->b, ==, replica_b->b); }
+	}
+}
+
+static MunitResult
+delta(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	eecs_world_t* replica = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	eecs_delta_baseline_t* baseline = eecs_create_delta_baseline(world);
+
+	eecs_entity_t entities[1200];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A, .data = &(struct A){ .a = 1.f } },
+		EECS_END_OF_LIST,
+	}, 1000, entities);
+
+	struct SnapshotBuffer buffer = { 0 };
+	munit_assert_true(eecs_encode_delta(baseline, write_snapshot, &buffer));
+	munit_assert_true(eecs_apply_delta(replica, buffer.data, buffer.size));
+	assert_replicated(world, replica, entities, 1000, comp_A, comp_B);
+	size_t full_size = buffer.size;
+
+	// Nothing changed
+	buffer.size = 0;
+	munit_assert_true(eecs_encode_delta(baseline, write_snapshot, &buffer));
+	size_t empty_size = buffer.size;
+	munit_assert_true(eecs_apply_delta(replica, buffer.data, buffer.size));
+
+	// A few writes only send the rows between the first and last change
+	((struct A*)eecs_get_component_in_entity(world, entities[10], comp_A))->a = 2.f;
+	((struct A*)eecs_get_component_in_entity(world, entities[12], comp_A))->a = 3.f;
+	buffer.size = 0;
+	munit_assert_true(eecs_encode_delta(baseline, write_snapshot, &buffer));
+	munit_assert_size(buffer.size, <, empty_size + 128);
+	munit_assert_size(buffer.size, <, full_size / 10);
+	munit_assert_true(eecs_apply_delta(replica, buffer.data, buffer.size));
+	assert_replicated(world, replica, entities, 1000, comp_A, comp_B);
+
+	// Creations, destructions and moves between tables
+	for (int i = 0; i < 1000; i += 3) {
+		eecs_destroy_entity(world, entities[i]);
+	}
+	for (int i = 1; i < 1000; i += 5) {
+		eecs_morph_entity(world, entities[i], (eecs_component_init_t[]){
+			{ .component = comp_B, .data = &(struct B){ .b = i } },
+			EECS_END_OF_LIST,
+		}, NULL);
+	}
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_B, .data = &(struct B){ .b = -1 } },
+		EECS_END_OF_LIST,
+	}, 200, entities + 1000);
+	buffer.size = 0;
+	munit_assert_true(eecs_encode_delta(baseline, write_snapshot, &buffer));
+	// A truncated delta leaves the replica as it was and can be sent again
+	eecs_world_t* previous = eecs_fork_world(replica);
+	for (size_t size = 0; size < buffer.size; size += buffer.size / 16 + 1) {
+		munit_assert_false(eecs_apply_delta(replica, buffer.data, size));
+		assert_replicated(previous, replica, entities, 1200, comp_A, comp_B);
+	}
+	munit_assert_false(eecs_apply_delta(replica, buffer.data, buffer.size - 1));
+	assert_replicated(previous, replica, entities, 1200, comp_A, comp_B);
+	eecs_destroy_world(previous);
+	munit_assert_true(eecs_apply_delta(replica, buffer.data, buffer.size));
+	assert_replicated(world, replica, entities, 1200, comp_A, comp_B);
+
+	// Tables shrink and chunks are released on both sides
+	eecs_destroy_entities(world, entities, 1000);
+	buffer.size = 0;
+	munit_assert_true(eecs_encode_delta(baseline, write_snapshot, &buffer));
+	munit_assert_true(eecs_apply_delta(replica, buffer.data, buffer.size));
+	assert_replicated(world, replica, entities, 1200, comp_A, comp_B);
+
+	// Truncated deltas are rejected
+	munit_assert_false(eecs_apply_delta(replica, buffer.data, buffer.size / 2));
+
+	free(buffer.data);
+	eecs_destroy_delta_baseline(baseline);
+	eecs_destroy_world(replica);
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static MunitResult
+fork_world(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	int num_read = 0;
+	eecs_system_t reader = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &reader, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.read_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = count_batch,
+		.userdata = &num_read,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.table_chunk_size = 1024,
+	});
+	eecs_entity_t entities[1000];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	}, 1000, entities);
+	for (int i = 0; i < 1000; ++i) {
+		((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a = (float)i;
+	}
+	eecs_template_t with_B = EECS_HANDLE_INIT;
+	eecs_register_template(world, &with_B, (eecs_component_init_t[]){
+		{ .component = comp_B, .data = &(struct B){ .b = 42 } },
+		EECS_END_OF_LIST,
+	});
+
+	eecs_world_t* forked = eecs_fork_world(world);
+
+	// Reading does not copy anything
+	eecs_run_systems(forked, EECS_UPDATE_ALL);
+	munit_assert_int(num_read, ==, 1000);
+	eecs_world_stats_t stats;
+	if (eecs_get_world_stats(forked, &stats)) {
+		munit_assert_int(stats.num_chunks_copied, ==, 0);
+	}
+
+	// Writes in either world are not seen by the other
+	((struct A*)eecs_get_component_in_entity(world, entities[0], comp_A))->a = -1.f;
+	((struct A*)eecs_get_component_in_entity(forked, entities[999], comp_A))->a = -2.f;
+	if (eecs_get_world_stats(world, &stats)) {
+		munit_assert_int(stats.num_chunks_copied, ==, 1);
+	}
+	eecs_destroy_entity(forked, entities[1]);
+	eecs_morph_entity(forked, entities[2], (eecs_component_init_t[]){
+		{ .component = comp_B, .data = &(struct B){ .b = 2 } },
+		EECS_END_OF_LIST,
+	}, NULL);
+	eecs_entity_t from_template = eecs_create_entity_from_template(forked, with_B, NULL);
+
+	for (int i = 0; i < 1000; ++i) {
+		float a = i == 999 ? -2.f : (float)i;
+		struct A* forked_a = eecs_get_component_in_entity(forked, entities[i], comp_A);
+		if (i == 1) {
+			munit_assert_null(forked_a);
+		} else {
+			munit_assert_float(forked_a->a, ==, a);
+		}
+
+		a = i == 0 ? -1.f : (float)i;
+		munit_assert_float(((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a, ==, a);
+	}
+	munit_assert_true(eecs_is_valid_entity(world, entities[1]));
+	munit_assert_null(eecs_get_component_in_entity(world, entities[2], comp_B));
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(forked, entities[2], comp_B))->b, ==, 2);
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(forked, from_template, comp_B))->b, ==, 42);
+	munit_assert_false(eecs_is_valid_entity(world, from_template));
+
+	// A fork of a fork outlives both
+	eecs_world_t* forked_twice = eecs_fork_world(forked);
+	eecs_destroy_world(forked);
+	eecs_destroy_world(world);
+	munit_assert_false(eecs_is_valid_entity(forked_twice, entities[1]));
+	munit_assert_float(((struct A*)eecs_get_component_in_entity(forked_twice, entities[999], comp_A))->a, ==, -2.f);
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(forked_twice, from_template, comp_B))->b, ==, 42);
+
+	// Once its forks are gone, a world writes its chunks in place
+	eecs_destroy_world(eecs_fork_world(forked_twice));
+	eecs_world_stats_t before;
+	bool has_stats = eecs_get_world_stats(forked_twice, &before);
+	for (int i = 0; i < 1000; ++i) {
+		struct A* a = eecs_get_component_in_entity(forked_twice, entities[i], comp_A);
+		if (a != NULL) { a->a = 0.f; }
+	}
+	if (has_stats) {
+		eecs_get_world_stats(forked_twice, &stats);
+		munit_assert_int(stats.num_chunks_copied, ==, before.num_chunks_copied);
+	}
+
+	eecs_destroy_world(forked_twice);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+count_component_cleanup(
+	eecs_world_t* world,
+	eecs_entity_t entity,
+	void* component_data,
+	void* userdata
+) {
+	munit_assert_true(eecs_is_valid_entity(world, entity));
+	munit_assert_not_null(component_data);
+	++*(int*)userdata;
+}
+
+struct SparseCheck {
+	eecs_component_t comp_B;
+	int count;
+};
+
+// Runs narrowed by a sparse component line up with their entities
+static void
+check_sparse_batch(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	struct SparseCheck* check = userdata;
+	struct A* as = eecs_get_components_in_batch(batch, 0);
+	munit_assert_null(eecs_get_components_in_batch(batch, 1));
+	for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+		eecs_entity_t entity = eecs_get_entity_in_batch(batch, i);
+		struct B* b = eecs_get_component_in_entity(world, entity, check->comp_B);
+		munit_assert_not_null(b);
+		munit_assert_int(b->b, ==, (int)as[i].a);
+	}
+	check->count += eecs_get_batch_size(batch);
+}
+
+static MunitResult
+sparse_components(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	int num_cleanups = 0;
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+		.cleanup_fn = count_component_cleanup,
+		.userdata = &num_cleanups,
+		.storage = EECS_STORAGE_SPARSE,
+	});
+
+	struct SparseCheck with_B = { .comp_B = comp_B };
+	eecs_system_t with_B_system = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &with_B_system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, comp_B, EECS_END_OF_LIST },
+		.update_fn = check_sparse_batch,
+		.userdata = &with_B,
+	});
+	int num_without_B = 0;
+	eecs_system_t without_B_system = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &without_B_system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.exclude_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.update_fn = count_batch,
+		.userdata = &num_without_B,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.table_chunk_size = 1024,
+	});
+	eecs_entity_t entities[300];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	}, 300, entities);
+	for (int i = 0; i < 300; ++i) {
+		((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a = (float)i;
+	}
+
+	// Toggling a sparse component leaves the entity in place
+	for (int i = 0; i < 300; i += 3) {
+		struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+		eecs_morph_entity(world, entities[i], (eecs_component_init_t[]){
+			{ .component = comp_B, .data = &(struct B){ .b = i } },
+			EECS_END_OF_LIST,
+		}, NULL);
+		munit_assert_ptr_equal(eecs_get_component_in_entity(world, entities[i], comp_A), a);
+	}
+	munit_assert_null(eecs_get_component_in_entity(world, entities[1], comp_B));
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(world, entities[3], comp_B))->b, ==, 3);
+
+	eecs_run_systems(world, EECS_UPDATE_ALL);
+	munit_assert_int(with_B.count, ==, 100);
+	munit_assert_int(num_without_B, ==, 200);
+
+	// Queries are narrowed the same way
+	eecs_query_t* query = eecs_create_query(world, (eecs_query_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, comp_B, EECS_END_OF_LIST },
+	});
+	with_B.count = 0;
+	eecs_batch_t batch;
+	for (eecs_query_iterator_t itr = eecs_iterate_query(query); eecs_next_query_batch(&itr, &batch);) {
+		check_sparse_batch(world, batch, &with_B);
+	}
+	munit_assert_int(with_B.count, ==, 100);
+	eecs_destroy_query(query);
+
+	// Removing, bulk morphs and destroying run the cleanup
+	eecs_morph_entity(world, entities[0], NULL, (eecs_component_t[]){ comp_B, EECS_END_OF_LIST });
+	munit_assert_int(num_cleanups, ==, 1);
+	eecs_morph_entities(world, entities + 1, 2, (eecs_component_init_t[]){
+		{ .component = comp_B, .data = &(struct B){ .b = 2 } },
+		EECS_END_OF_LIST,
+	}, NULL);
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(world, entities[1], comp_B))->b, ==, 2);
+	eecs_destroy_entity(world, entities[3]);
+	munit_assert_int(num_cleanups, ==, 2);
+
+	// Forks and snapshots keep the sets
+	eecs_world_t* forked = eecs_fork_world(world);
+	eecs_morph_entity(forked, entities[6], NULL, (eecs_component_t[]){ comp_B, EECS_END_OF_LIST });
+	munit_assert_null(eecs_get_component_in_entity(forked, entities[6], comp_B));
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(world, entities[6], comp_B))->b, ==, 6);
+	eecs_destroy_world(forked);
+
+	struct SnapshotBuffer buffer = { 0 };
+	munit_assert_true(eecs_save_world(world, write_snapshot, &buffer));
+	eecs_world_t* loaded = eecs_create_world(ecs, (eecs_world_options_t){
+		.table_chunk_size = 1024,
+	});
+	munit_assert_true(eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){ 0 }));
+	free(buffer.data);
+	for (int i = 0; i < 300; ++i) {
+		struct B* b = eecs_get_component_in_entity(loaded, entities[i], comp_B);
+		if (i == 1 || i == 2) {
+			munit_assert_int(b->b, ==, 2);
+		} else if (i % 3 == 0 && i != 0 && i != 3) {
+			munit_assert_int(b->b, ==, i);
+		} else {
+			munit_assert_null(b);
+		}
+	}
+
+	num_cleanups = 0;
+	eecs_destroy_world(loaded);
+	munit_assert_int(num_cleanups, ==, 100);
+
+	num_cleanups = 0;
+	eecs_destroy_world(world);
+	munit_assert_int(num_cleanups, ==, 100);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+track_max_batch_size(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	int* max_size = userdata;
+	if (eecs_get_batch_size(batch) > *max_size) { *max_size = eecs_get_batch_size(batch); }
+}
+
+static MunitResult
+tag_components(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t tag = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &tag, (eecs_component_options_t){
+		.size = 0,
+		.alignment = 1,
+	});
+
+	int max_tagged_batch = 0;
+	eecs_system_t tagged = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &tagged, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, tag, EECS_END_OF_LIST },
+		.update_fn = track_max_batch_size,
+		.userdata = &max_tagged_batch,
+	});
+	int max_untagged_batch = 0;
+	eecs_system_t untagged = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &untagged, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.exclude_components = (eecs_component_t[]){ tag, EECS_END_OF_LIST },
+		.update_fn = track_max_batch_size,
+		.userdata = &max_untagged_batch,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.table_chunk_size = 1024,
+		.column_alignment = 64,
+	});
+	eecs_entity_t entities[1000];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	}, 1000, entities);
+	for (int i = 0; i < 1000; ++i) {
+		((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a = (float)i;
+	}
+
+	// Tags take no room: both tables fit as many entities per chunk
+	eecs_morph_entities(world, entities, 500, (eecs_component_init_t[]){
+		{ .component = tag },
+		EECS_END_OF_LIST,
+	}, NULL);
+	eecs_run_systems(world, EECS_UPDATE_ALL);
+	munit_assert_int(max_tagged_batch, >, 0);
+	munit_assert_int(max_tagged_batch, ==, max_untagged_batch);
+
+	// Moving in and out of tagged tables keeps the data
+	eecs_morph_entity(world, entities[0], NULL, (eecs_component_t[]){ tag, EECS_END_OF_LIST });
+	eecs_morph_entity(world, entities[999], (eecs_component_init_t[]){
+		{ .component = tag },
+		EECS_END_OF_LIST,
+	}, NULL);
+	eecs_destroy_entity(world, entities[1]);
+	for (int i = 2; i < 1000; ++i) {
+		munit_assert_float(((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a, ==, (float)i);
+		bool has_tag = (i < 500 && i != 0) || i == 999;
+		munit_assert_int(eecs_get_component_in_entity(world, entities[i], tag) != NULL, ==, has_tag);
+	}
+	munit_assert_float(((struct A*)eecs_get_component_in_entity(world, entities[0], comp_A))->a, ==, 0.f);
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+struct EnabledCount {
+	int num_batches;
+	int num_enabled;
+};
+
+static void
+count_enabled(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	struct EnabledCount* count = userdata;
+	++count->num_batches;
+	eecs_id_t first_bit;
+	const eecs_mask_t* masks = eecs_get_enable_masks_in_batch(batch, 0, &first_bit);
+	munit_assert_not_null(masks);
+	munit_assert_int(first_bit, ==, 0);
+	eecs_id_t num_bits_per_mask = (eecs_id_t)(sizeof(eecs_mask_t) * CHAR_BIT);
+	for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+		bool enabled = (masks[i / num_bits_per_mask] >> (i % num_bits_per_mask)) & 1;
+		munit_assert_int(enabled, ==, eecs_is_enabled_in_batch(batch, 0, i));
+		count->num_enabled += enabled;
+	}
+}
+
+static void
+assert_enabled(
+	eecs_world_t* world,
+	const eecs_entity_t* entities,
+	int num_entities,
+	eecs_component_t component,
+	int enabled_entity
+) {
+	for (int i = 0; i < num_entities; ++i) {
+		if (!eecs_is_valid_entity(world, entities[i])) { continue; }
+		munit_assert_int(eecs_is_component_enabled(world, entities[i], component), ==, i == enabled_entity);
+	}
+}
+
+static MunitResult
+enableable_components(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+		.enableable = true,
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+
+	struct EnabledCount count = { 0 };
+	eecs_system_t system = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = count_enabled,
+		.userdata = &count,
+		.skip_disabled_chunks = true,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.table_chunk_size = 1024,
+	});
+	eecs_entity_t entities[500];
+	eecs_create_entities(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	}, 500, entities);
+	for (int i = 0; i < 500; ++i) {
+		((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a = (float)i;
+	}
+
+	// Components start enabled
+	eecs_run_systems(world, EECS_UPDATE_ALL);
+	munit_assert_int(count.num_enabled, ==, 500);
+	munit_assert_int(count.num_batches, >, 1);
+	munit_assert_false(eecs_is_component_enabled(world, entities[0], comp_B));
+
+	// Only the chunk with an enabled entity is visited
+	for (int i = 0; i < 500; ++i) {
+		eecs_set_component_enabled(world, entities[i], comp_A, i == 300);
+	}
+	count = (struct EnabledCount){ 0 };
+	eecs_run_systems(world, EECS_UPDATE_ALL);
+	munit_assert_int(count.num_batches, ==, 1);
+	munit_assert_int(count.num_enabled, ==, 1);
+	assert_enabled(world, entities, 500, comp_A, 300);
+
+	// Bits follow their entity through morphs and destroys
+	eecs_morph_entity(world, entities[300], (eecs_component_init_t[]){
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, NULL);
+	eecs_morph_entities(world, entities + 200, 50, (eecs_component_init_t[]){
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	}, NULL);
+	eecs_destroy_entity(world, entities[0]);
+	eecs_destroy_entities(world, entities + 10, 20);
+	assert_enabled(world, entities, 500, comp_A, 300);
+	eecs_morph_entity(world, entities[300], NULL, (eecs_component_t[]){ comp_B, EECS_END_OF_LIST });
+	assert_enabled(world, entities, 500, comp_A, 300);
+	for (int i = 1; i < 500; ++i) {
+		if (i >= 10 && i < 30) { continue; }
+		munit_assert_float(((struct A*)eecs_get_component_in_entity(world, entities[i], comp_A))->a, ==, (float)i);
+	}
+
+	// Snapshots and deltas carry the bits
+	struct SnapshotBuffer buffer = { 0 };
+	munit_assert_true(eecs_save_world(world, write_snapshot, &buffer));
+	eecs_world_t* loaded = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+	munit_assert_true(eecs_load_world(loaded, buffer.data, buffer.size, (eecs_load_options_t){ 0 }));
+	assert_enabled(loaded, entities, 500, comp_A, 300);
+	eecs_destroy_world(loaded);
+
+	eecs_world_t* replica = eecs_create_world(ecs, (eecs_world_options_t){
+		.table_chunk_size = 1024,
+	});
+	eecs_delta_baseline_t* baseline = eecs_create_delta_baseline(world);
+	buffer.size = 0;
+	munit_assert_true(eecs_encode_delta(baseline, write_snapshot, &buffer));
+	munit_assert_true(eecs_apply_delta(replica, buffer.data, buffer.size));
+	assert_enabled(replica, entities, 500, comp_A, 300);
+	eecs_set_component_enabled(world, entities[300], comp_A, false);
+	eecs_set_component_enabled(world, entities[400], comp_A, true);
+	buffer.size = 0;
+	munit_assert_true(eecs_encode_delta(baseline, write_snapshot, &buffer));
+	munit_assert_true(eecs_apply_delta(replica, buffer.data, buffer.size));
+	assert_enabled(replica, entities, 500, comp_A, 400);
+	eecs_destroy_delta_baseline(baseline);
+	eecs_destroy_world(replica);
+	free(buffer.data);
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
 MunitSuite basic = {
 	.prefix = "/basic",
 	.tests = (MunitTest[]){
 		{ .name = "/init_cleanup", .test = init_cleanup },
+		{ .name = "/create_entities", .test = create_entities },
+		{ .name = "/changed_filter", .test = changed_filter },
+		{ .name = "/templates", .test = templates },
+		{ .name = "/stats", .test = stats },
+		{ .name = "/compact", .test = compact },
+		{ .name = "/entity_pages", .test = entity_pages },
+		{ .name = "/chunk_pool", .test = chunk_pool },
+		{ .name = "/chunk_pool_reserve", .test = chunk_pool_reserve },
+		{ .name = "/chunk_pool_partial_pages", .test = chunk_pool_partial_pages },
+		{ .name = "/simd_layout", .test = simd_layout },
+		{ .name = "/incremental_sync", .test = incremental_sync },
+		{ .name = "/query", .test = query },
+		{ .name = "/optional_components", .test = optional_components },
+		{ .name = "/gather", .test = gather },
+		{ .name = "/snapshot", .test = snapshot },
+		{ .name = "/delta", .test = delta },
+		{ .name = "/fork_world", .test = fork_world },
+		{ .name = "/sparse_components", .test = sparse_components },
+		{ .name = "/tag_components", .test = tag_components },
+		{ .name = "/enableable_components", .test = enableable_components },
 		{ 0 },
 	},
 };
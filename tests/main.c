@@ -3,11 +3,15 @@
 #include <eecs.h>
 
 extern MunitSuite basic;
+extern MunitSuite morph;
+extern MunitSuite parallel;
 
 int main (int argc, char* argv[]) {
 	MunitSuite suites = {
 		.suites = (MunitSuite[]) {
 			basic,
+			morph,
+			parallel,
 			{ 0 },
 		},
 	};
@@ -0,0 +1,350 @@
+#include <munit/munit.h>
+#include <eecs.h>
+#include "components.h"
+
+static MunitResult
+single_component(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+
+	eecs_entity_t entities[3];
+	for (int i = 0; i < 3; ++i) {
+		entities[i] = eecs_create_entity(world, (eecs_component_init_t[]){
+			{
+				.component = comp_A,
+				.data = &(struct A){ .a = (float)i },
+			},
+			{
+				.component = comp_C,
+				.data = &(struct C){ .b = i },
+			},
+			EECS_END_OF_LIST,
+		});
+	}
+
+	// Add B to every entity, the first one through a new edge and the rest
+	// through the cached one
+	for (int i = 0; i < 3; ++i) {
+		eecs_morph_entity(world, entities[i], (eecs_component_init_t[]){
+			{
+				.component = comp_B,
+				.data = &(struct B){ .b = 10 + i },
+			},
+			EECS_END_OF_LIST,
+		}, NULL);
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+		struct B* b = eecs_get_component_in_entity(world, entities[i], comp_B);
+		struct C* c = eecs_get_component_in_entity(world, entities[i], comp_C);
+		munit_assert_not_null(a);
+		munit_assert_not_null(b);
+		munit_assert_not_null(c);
+		munit_assert_float(a->a, ==, (float)i);
+		munit_assert_int(b->b, ==, 10 + i);
+		munit_assert_int(c->b, ==, i);
+	}
+
+	// Adding an existing component keeps the current data
+	eecs_morph_entity(world, entities[0], (eecs_component_init_t[]){
+		{
+			.component = comp_B,
+			.data = &(struct B){ .b = 42 },
+		},
+		EECS_END_OF_LIST,
+	}, NULL);
+	struct B* b = eecs_get_component_in_entity(world, entities[0], comp_B);
+	munit_assert_int(b->b, ==, 10);
+
+	// Remove A, then go back through the reverse edge
+	eecs_morph_entity(world, entities[1], NULL, (eecs_component_t[]){ comp_A, EECS_END_OF_LIST });
+	munit_assert_null(eecs_get_component_in_entity(world, entities[1], comp_A));
+	b = eecs_get_component_in_entity(world, entities[1], comp_B);
+	munit_assert_int(b->b, ==, 11);
+
+	eecs_morph_entity(world, entities[1], NULL, (eecs_component_t[]){ comp_A, EECS_END_OF_LIST });
+	munit_assert_true(eecs_is_valid_entity(world, entities[1]));
+
+	eecs_morph_entity(world, entities[1], (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	}, NULL);
+	struct A* a = eecs_get_component_in_entity(world, entities[1], comp_A);
+	munit_assert_not_null(a);
+	munit_assert_float(a->a, ==, 0.f);
+	struct C* c = eecs_get_component_in_entity(world, entities[1], comp_C);
+	munit_assert_int(c->b, ==, 1);
+
+	// The other entities are untouched by the swap-remove
+	c = eecs_get_component_in_entity(world, entities[2], comp_C);
+	munit_assert_int(c->b, ==, 2);
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+count_cleanup(
+	eecs_world_t* world,
+	eecs_entity_t entity,
+	void* component_data,
+	void* userdata
+) {
+	munit_assert_true(eecs_is_valid_entity(world, entity));
+	++*(int*)userdata;
+}
+
+static void
+destroy_batch(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	eecs_destroy_entities_in_batch(batch);
+}
+
+static MunitResult
+bulk(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	int num_b_cleanups = 0;
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+		.cleanup_fn = count_cleanup,
+		.userdata = &num_b_cleanups,
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){ 0 });
+
+	enum { NUM_ENTITIES = 3000 };
+	static eecs_entity_t entities[NUM_ENTITIES];
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		entities[i] = eecs_create_entity(world, (eecs_component_init_t[]){
+			{
+				.component = comp_A,
+				.data = &(struct A){ .a = (float)i },
+			},
+			{
+				.component = comp_B,
+				.data = &(struct B){ .b = i },
+			},
+			EECS_END_OF_LIST,
+		});
+	}
+
+	// A few rows of a large table
+	eecs_destroy_entities(world, (eecs_entity_t[]){ entities[3], entities[0], entities[3] }, 3);
+	munit_assert_int(num_b_cleanups, ==, 2);
+	munit_assert_int(((struct B*)eecs_get_component_in_entity(world, entities[1], comp_B))->b, ==, 1);
+
+	// Destroy every third entity, with a duplicate and a stale handle
+	static eecs_entity_t destroyed[NUM_ENTITIES / 3 + 2];
+	int num_destroyed = 0;
+	for (int i = 0; i < NUM_ENTITIES; i += 3) {
+		destroyed[num_destroyed++] = entities[i];
+	}
+	destroyed[num_destroyed++] = entities[0];
+	destroyed[num_destroyed++] = (eecs_entity_t){ .from_1_index = 1, .gen = 42 };
+	eecs_destroy_entities(world, destroyed, num_destroyed);
+	munit_assert_int(num_b_cleanups, ==, NUM_ENTITIES / 3);
+
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		munit_assert_int(eecs_is_valid_entity(world, entities[i]), ==, i % 3 != 0);
+		if (i % 3 == 0) { continue; }
+
+		struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+		struct B* b = eecs_get_component_in_entity(world, entities[i], comp_B);
+		munit_assert_float(a->a, ==, (float)i);
+		munit_assert_int(b->b, ==, i);
+	}
+
+	// Add C to the even entities that are left
+	static eecs_entity_t morphed[NUM_ENTITIES];
+	int num_morphed = 0;
+	for (int i = 0; i < NUM_ENTITIES; i += 2) {
+		if (i % 3 != 0) { morphed[num_morphed++] = entities[i]; }
+	}
+	eecs_morph_entities(world, morphed, num_morphed, (eecs_component_init_t[]){
+		{
+			.component = comp_C,
+			.data = &(struct C){ .b = 7 },
+		},
+		EECS_END_OF_LIST,
+	}, NULL);
+
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		if (i % 3 == 0) { continue; }
+
+		struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+		struct B* b = eecs_get_component_in_entity(world, entities[i], comp_B);
+		struct C* c = eecs_get_component_in_entity(world, entities[i], comp_C);
+		munit_assert_float(a->a, ==, (float)i);
+		munit_assert_int(b->b, ==, i);
+		if (i % 2 == 0) {
+			munit_assert_not_null(c);
+			munit_assert_int(c->b, ==, 7);
+		} else {
+			munit_assert_null(c);
+		}
+	}
+
+	// Move a whole table
+	num_b_cleanups = 0;
+	eecs_morph_entities_matching(
+		world,
+		(eecs_component_t[]){ comp_C, EECS_END_OF_LIST },
+		NULL,
+		NULL,
+		(eecs_component_t[]){ comp_B, EECS_END_OF_LIST }
+	);
+	munit_assert_int(num_b_cleanups, ==, num_morphed);
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		if (i % 3 == 0) { continue; }
+
+		struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+		struct B* b = eecs_get_component_in_entity(world, entities[i], comp_B);
+		munit_assert_float(a->a, ==, (float)i);
+		munit_assert_int(b == NULL, ==, i % 2 == 0);
+	}
+
+	eecs_destroy_entities_matching(
+		world,
+		(eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		(eecs_component_t[]){ comp_C, EECS_END_OF_LIST }
+	);
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		munit_assert_int(eecs_is_valid_entity(world, entities[i]), ==, i % 3 != 0 && i % 2 == 0);
+	}
+
+	// Destroy from inside a system
+	eecs_system_t system = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_C, EECS_END_OF_LIST },
+		.update_fn = destroy_batch,
+	});
+	eecs_run_systems(world, EECS_UPDATE_ALL);
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		munit_assert_false(eecs_is_valid_entity(world, entities[i]));
+	}
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+struct DeferredMorphData {
+	eecs_component_t comp_B;
+};
+
+static void
+add_b_to_batch(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	struct DeferredMorphData* data = userdata;
+	eecs_morph_entities_in_batch(batch, (eecs_component_init_t[]){
+		{ .component = data->comp_B, .data = &(struct B){ .b = 7, .c = 8 } },
+		EECS_END_OF_LIST,
+	}, NULL);
+}
+
+static MunitResult
+deferred_bulk_data(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	// The morph runs over the table being updated so it is deferred
+	struct DeferredMorphData data = { .comp_B = comp_B };
+	eecs_system_t system = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.exclude_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.update_fn = add_b_to_batch,
+		.userdata = &data,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.table_chunk_size = 1024,
+	});
+
+	// Two tables with several chunks each
+	eecs_entity_t entities[100];
+	for (int i = 0; i < 100; ++i) {
+		entities[i] = eecs_create_entity(world, (eecs_component_init_t[]){
+			{ .component = comp_A, .data = &(struct A){ .a = (float)i } },
+			{ .component = i % 2 == 0 ? comp_A : comp_C },
+			EECS_END_OF_LIST,
+		});
+	}
+
+	eecs_run_systems(world, EECS_UPDATE_ALL);
+	for (int i = 0; i < 100; ++i) {
+		struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+		struct B* b = eecs_get_component_in_entity(world, entities[i], comp_B);
+		munit_assert_not_null(b);
+		munit_assert_float(a->a, ==, (float)i);
+		munit_assert_int(b->b, ==, 7);
+		munit_assert_int((int)b->c, ==, 8);
+	}
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+MunitSuite morph = {
+	.prefix = "/morph",
+	.tests = (MunitTest[]){
+		{ .name = "/single_component", .test = single_component },
+		{ .name = "/bulk", .test = bulk },
+		{ .name = "/deferred_bulk_data", .test = deferred_bulk_data },
+		{ 0 },
+	},
+};
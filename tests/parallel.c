@@ -0,0 +1,454 @@
+#include <munit/munit.h>
+#include <eecs.h>
+#include "components.h"
+
+#define NUM_ENTITIES 20000
+
+struct ParallelSystemData {
+	eecs_component_t comp_A;
+	eecs_component_t comp_B;
+};
+
+static void
+parallel_update(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	struct ParallelSystemData* data = userdata;
+	struct A* as = eecs_get_components_in_batch(batch, 0);
+	struct B* bs = eecs_get_components_in_batch(batch, 1);
+
+	for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+		as[i].a += 1.f;
+
+		eecs_entity_t entity = eecs_get_entity_in_batch(batch, i);
+		if (bs[i].b % 2 == 1) {
+			eecs_destroy_entity(world, entity);
+		} else if (bs[i].b % 4 == 0) {
+			eecs_morph_entity(
+				world, entity,
+				NULL,
+				(eecs_component_t[]){ data->comp_B, EECS_END_OF_LIST }
+			);
+		}
+	}
+}
+
+static MunitResult
+deferred_ops(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	struct ParallelSystemData system_data = {
+		.comp_A = EECS_HANDLE_INIT,
+		.comp_B = EECS_HANDLE_INIT,
+	};
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &system_data.comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &system_data.comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	eecs_system_t system = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &system, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){
+			system_data.comp_A,
+			system_data.comp_B,
+			EECS_END_OF_LIST,
+		},
+		.update_fn = parallel_update,
+		.userdata = &system_data,
+		.parallel = true,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.num_worker_threads = 3,
+	});
+
+	static eecs_entity_t entities[NUM_ENTITIES];
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		entities[i] = eecs_create_entity(world, (eecs_component_init_t[]){
+			{
+				.component = system_data.comp_A,
+				.data = &(struct A){ .a = (float)i },
+			},
+			{
+				.component = system_data.comp_B,
+				.data = &(struct B){ .b = i },
+			},
+			// Spread entities over two tables
+			{ .component = i % 3 == 0 ? comp_C : system_data.comp_A },
+			EECS_END_OF_LIST,
+		});
+	}
+
+	// A fork runs the same systems on its own workers
+	eecs_world_t* forked = eecs_fork_world(world);
+	eecs_world_t* worlds[] = { world, forked };
+	for (int w = 0; w < 2; ++w) {
+		eecs_run_systems(worlds[w], EECS_UPDATE_ALL);
+
+		for (int i = 0; i < NUM_ENTITIES; ++i) {
+			if (i % 2 == 1) {
+				munit_assert_false(eecs_is_valid_entity(worlds[w], entities[i]));
+				continue;
+			}
+
+			struct A* a = eecs_get_component_in_entity(worlds[w], entities[i], system_data.comp_A);
+			munit_assert_not_null(a);
+			munit_assert_float(a->a, ==, (float)i + 1.f);
+
+			struct B* b = eecs_get_component_in_entity(worlds[w], entities[i], system_data.comp_B);
+			if (i % 4 == 0) {
+				munit_assert_null(b);
+			} else {
+				munit_assert_not_null(b);
+				munit_assert_int(b->b, ==, i);
+			}
+		}
+	}
+
+	eecs_destroy_world(forked);
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+write_a_update(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	struct A* as = eecs_get_components_in_batch(batch, 0);
+	for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+		as[i].a += 1.f;
+	}
+}
+
+static void
+read_a_write_b_update(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	struct A* as = eecs_get_components_in_batch(batch, 0);
+	struct B* bs = eecs_get_components_in_batch(batch, 1);
+	for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+		bs[i].b = (int)as[i].a * 2;
+	}
+}
+
+static void
+write_c_update(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	struct C* cs = eecs_get_components_in_batch(batch, 0);
+	for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+		cs[i].b += 1;
+	}
+
+	// Not a parallel system so this is never called concurrently
+	++*(int*)userdata;
+}
+
+static MunitResult
+scheduler(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	eecs_system_t write_a = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &write_a, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.write_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = write_a_update,
+		.parallel = true,
+		.no_structural_changes = true,
+	});
+
+	int num_write_c_batches = 0;
+	eecs_system_t write_c = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &write_c, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_C, EECS_END_OF_LIST },
+		.write_components = (eecs_component_t[]){ comp_C, EECS_END_OF_LIST },
+		.update_fn = write_c_update,
+		.userdata = &num_write_c_batches,
+		.no_structural_changes = true,
+	});
+
+	// Must observe the writes of write_a
+	eecs_system_t read_a_write_b = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &read_a_write_b, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, comp_B, EECS_END_OF_LIST },
+		.write_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.update_fn = read_a_write_b_update,
+		.parallel = true,
+		.no_structural_changes = true,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.num_worker_threads = 3,
+	});
+
+	static eecs_entity_t entities[NUM_ENTITIES];
+	for (int i = 0; i < NUM_ENTITIES; ++i) {
+		entities[i] = eecs_create_entity(world, (eecs_component_init_t[]){
+			{ .component = comp_A },
+			{ .component = comp_B },
+			{ .component = comp_C },
+			EECS_END_OF_LIST,
+		});
+	}
+
+	for (int frame = 1; frame <= 3; ++frame) {
+		eecs_run_systems(world, EECS_UPDATE_ALL);
+
+		for (int i = 0; i < NUM_ENTITIES; ++i) {
+			struct A* a = eecs_get_component_in_entity(world, entities[i], comp_A);
+			struct B* b = eecs_get_component_in_entity(world, entities[i], comp_B);
+			struct C* c = eecs_get_component_in_entity(world, entities[i], comp_C);
+			munit_assert_float(a->a, ==, (float)frame);
+			munit_assert_int(b->b, ==, frame * 2);
+			munit_assert_int(c->b, ==, frame);
+		}
+	}
+	munit_assert_int(num_write_c_batches, >, 0);
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+struct SpawnData {
+	eecs_component_t spawned_component;
+	eecs_entity_t spawned[64];
+	int num_spawned;
+};
+
+static void
+spawn(struct SpawnData* data, eecs_world_t* world) {
+	munit_assert_int(data->num_spawned, <, 64);
+	data->spawned[data->num_spawned++] = eecs_create_entity(world, (eecs_component_init_t[]){
+		{ .component = data->spawned_component },
+		EECS_END_OF_LIST,
+	});
+}
+
+static void
+write_b_update(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	struct B* bs = eecs_get_components_in_batch(batch, 0);
+	for (eecs_id_t i = 0; i < eecs_get_batch_size(batch); ++i) {
+		bs[i].b += 1;
+	}
+}
+
+static void
+spawn_update(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	spawn(userdata, world);
+}
+
+static void
+spawn_post_update(eecs_world_t* world, void* userdata) {
+	spawn(userdata, world);
+}
+
+static MunitResult
+create_in_systems(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_B = EECS_HANDLE_INIT;
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_B, (eecs_component_options_t){
+		.size = sizeof(struct B),
+		.alignment = _Alignof(struct B),
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	// Declaring accesses does not stop update_fn from creating entities
+	struct SpawnData update_spawns = { .spawned_component = comp_C };
+	eecs_system_t spawn_in_update = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &spawn_in_update, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.read_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = spawn_update,
+		.userdata = &update_spawns,
+	});
+
+	// The hook keeps write_a out of the stage of write_b
+	struct SpawnData post_update_spawns = { .spawned_component = comp_C };
+	eecs_system_t write_a = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &write_a, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.write_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = write_a_update,
+		.post_update_fn = spawn_post_update,
+		.userdata = &post_update_spawns,
+	});
+	eecs_system_t write_b = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &write_b, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.write_components = (eecs_component_t[]){ comp_B, EECS_END_OF_LIST },
+		.update_fn = write_b_update,
+		.parallel = true,
+		.no_structural_changes = true,
+	});
+
+	eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+		.num_worker_threads = 3,
+	});
+
+	eecs_entity_t entity = eecs_create_entity(world, (eecs_component_init_t[]){
+		{ .component = comp_A },
+		EECS_END_OF_LIST,
+	});
+	eecs_create_entity(world, (eecs_component_init_t[]){
+		{ .component = comp_B },
+		EECS_END_OF_LIST,
+	});
+
+	for (int frame = 1; frame <= 3; ++frame) {
+		eecs_run_systems(world, EECS_UPDATE_ALL);
+
+		munit_assert_int(update_spawns.num_spawned, ==, frame);
+		munit_assert_int(post_update_spawns.num_spawned, ==, frame);
+		munit_assert_float(((struct A*)eecs_get_component_in_entity(world, entity, comp_A))->a, ==, (float)frame);
+	}
+	for (int i = 0; i < 3; ++i) {
+		munit_assert_true(eecs_is_valid_entity(world, update_spawns.spawned[i]));
+		munit_assert_true(eecs_is_valid_entity(world, post_update_spawns.spawned[i]));
+	}
+
+	eecs_destroy_world(world);
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+static void
+tag_with_c_update(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	eecs_component_t comp_C = *(eecs_component_t*)userdata;
+	eecs_morph_entities_in_batch(batch, (eecs_component_init_t[]){
+		{ .component = comp_C },
+		EECS_END_OF_LIST,
+	}, NULL);
+}
+
+static void
+count_update(
+	eecs_world_t* world,
+	eecs_batch_t batch,
+	void* userdata
+) {
+	*(int*)userdata += eecs_get_batch_size(batch);
+}
+
+static MunitResult
+morph_ordering(const MunitParameter params[], void* fixture) {
+	eecs_t* ecs = eecs_create((eecs_options_t) { 0 });
+
+	eecs_component_t comp_A = EECS_HANDLE_INIT;
+	eecs_component_t comp_C = EECS_HANDLE_INIT;
+	eecs_register_component(ecs, &comp_A, (eecs_component_options_t){
+		.size = sizeof(struct A),
+		.alignment = _Alignof(struct A),
+	});
+	eecs_register_component(ecs, &comp_C, (eecs_component_options_t){
+		.size = sizeof(struct C),
+		.alignment = _Alignof(struct C),
+	});
+
+	// The accesses do not conflict but the morphs of tag_with_c must be seen
+	// by count_c whatever the number of workers
+	eecs_system_t tag_with_c = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &tag_with_c, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.exclude_components = (eecs_component_t[]){ comp_C, EECS_END_OF_LIST },
+		.write_components = (eecs_component_t[]){ comp_A, EECS_END_OF_LIST },
+		.update_fn = tag_with_c_update,
+		.userdata = &comp_C,
+	});
+	int num_counted = 0;
+	eecs_system_t count_c = EECS_HANDLE_INIT;
+	eecs_register_system(ecs, &count_c, (eecs_system_options_t){
+		.require_components = (eecs_component_t[]){ comp_C, EECS_END_OF_LIST },
+		.read_components = (eecs_component_t[]){ comp_C, EECS_END_OF_LIST },
+		.update_fn = count_update,
+		.userdata = &num_counted,
+		.no_structural_changes = true,
+	});
+
+	for (int num_worker_threads = 0; num_worker_threads <= 3; num_worker_threads += 3) {
+		eecs_world_t* world = eecs_create_world(ecs, (eecs_world_options_t){
+			.num_worker_threads = num_worker_threads,
+		});
+		static eecs_entity_t entities[NUM_ENTITIES];
+		eecs_create_entities(world, (eecs_component_init_t[]){
+			{ .component = comp_A },
+			EECS_END_OF_LIST,
+		}, NUM_ENTITIES, entities);
+
+		num_counted = 0;
+		eecs_run_systems(world, EECS_UPDATE_ALL);
+		munit_assert_int(num_counted, ==, NUM_ENTITIES);
+
+		eecs_destroy_world(world);
+	}
+
+	eecs_destroy(ecs);
+	return MUNIT_OK;
+}
+
+MunitSuite parallel = {
+	.prefix = "/parallel",
+	.tests = (MunitTest[]){
+		{ .name = "/deferred_ops", .test = deferred_ops },
+		{ .name = "/scheduler", .test = scheduler },
+		{ .name = "/create_in_systems", .test = create_in_systems },
+		{ .name = "/morph_ordering", .test = morph_ordering },
+		{ 0 },
+	},
+};